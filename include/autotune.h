@@ -0,0 +1,54 @@
+/** @file
+    Startup autotune of the baseband kernels with a persisted wisdom file.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_AUTOTUNE_H_
+#define INCLUDE_AUTOTUNE_H_
+
+#include <stdint.h>
+#include "baseband.h"
+
+#define AUTOTUNE_DEFAULT_FILE "rtl_433.wisdom"
+#define AUTOTUNE_MIN_MS 5 ///< Minimum time per kernel and implementation in one round
+#define AUTOTUNE_ROUNDS 3 ///< The best of these rounds is used
+
+/** Time all available implementations of each kernel on a frame and pick the fastest.
+
+    @param block_size the frame size in bytes, CU8 kernels see block_size / 2 samples, CS16 block_size / 4
+    @param min_ms minimum time per kernel and implementation in one round
+    @param[out] best the fastest implementation for each kernel, BASEBAND_KERNEL_END entries
+*/
+void autotune_run(uint32_t block_size, unsigned min_ms, baseband_impl_t *best);
+
+/** Read the winners for a block size from a wisdom file.
+
+    @param path the wisdom file
+    @param block_size the frame size in bytes
+    @param[out] best the implementation for each kernel, BASEBAND_KERNEL_END entries
+    @return 0 on success, -1 if the file is missing, has no complete entry for @p block_size,
+            or names an implementation that is not available on this CPU
+*/
+int autotune_load(char const *path, uint32_t block_size, baseband_impl_t *best);
+
+/** Write the winners for a block size to a wisdom file, entries for other block sizes are kept.
+
+    @param path the wisdom file
+    @param block_size the frame size in bytes
+    @param best the implementation for each kernel, BASEBAND_KERNEL_END entries
+    @return 0 on success, -1 on write error
+*/
+int autotune_save(char const *path, uint32_t block_size, baseband_impl_t const *best);
+
+/** Select the kernels from the wisdom file, calibrate and save it if there is no entry yet.
+
+    @param path the wisdom file
+    @param block_size the frame size in bytes
+*/
+void autotune_kernels(char const *path, uint32_t block_size);
+
+#endif /* INCLUDE_AUTOTUNE_H_ */
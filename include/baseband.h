@@ -33,6 +33,108 @@ float magnitude_true_cu8(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len);
 float magnitude_est_cs16(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len);
 float magnitude_true_cs16(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len);
 
+/** Convert CS8 samples to CU8 in place.
+
+    @param buf samples (I/Q samples in interleaved int8)
+    @param len number of bytes
+*/
+void baseband_convert_cs8_cu8(uint8_t *buf, uint32_t len);
+
+/** Convert CF32 samples to CS16, clamped to [-1,1] and scaled to Q0.15.
+
+    The output may be the same buffer as the input for in place conversion.
+    @param in samples (I/Q samples in interleaved float)
+    @param[out] out samples (I/Q samples in interleaved int16)
+    @param len number of values (twice the number of samples)
+*/
+void baseband_convert_cf32_cs16(float const *in, int16_t *out, uint32_t len);
+
+/** Find the first sample above a level, e.g. the rising edge of a pulse.
+
+    @param buf the samples, e.g. AM demodulated data
+    @param len number of samples
+    @param level the level to exceed
+    @return the index of the first sample above @p level, @p len if there is none
+*/
+uint32_t baseband_find_above(int16_t const *buf, uint32_t len, int16_t level);
+
+/** Estimate the level of a frame from a strided subset of samples, e.g. for squelch.
+
+    Same units as envelope_detect() (or magnitude_est_cu8(), magnitude_est_cs16()),
+    but reads only every @p stride-th sample and writes no envelope.
+    @param iq_buf input samples (I/Q samples in interleaved uint8 or int16)
+    @param sample_size CU8: 2, CS16: 4
+    @param use_mag_est use the magnitude estimator for CU8, CS16 always uses the magnitude
+    @param len number of samples in the frame
+    @param stride read every stride-th sample, 1 reads all samples
+    @param[out] tail_db the level of the last 1/16th of the frame in dB
+    @return the average level in dB
+*/
+float baseband_probe_level(void const *iq_buf, int sample_size, int use_mag_est, uint32_t len, unsigned stride, float *tail_db);
+
+/// Kernel implementations for envelope and magnitude, all give identical results.
+typedef enum baseband_impl {
+    BASEBAND_IMPL_AUTO = -1, ///< Best available on this CPU
+    BASEBAND_IMPL_SCALAR,
+    BASEBAND_IMPL_SSE2,
+    BASEBAND_IMPL_AVX2,
+    BASEBAND_IMPL_NEON,
+    BASEBAND_IMPL_END,
+} baseband_impl_t;
+
+/// Check if a kernel implementation is compiled in and supported by the CPU.
+int baseband_impl_available(baseband_impl_t impl);
+
+/// Get the display name of a kernel implementation.
+char const *baseband_impl_name(baseband_impl_t impl);
+
+/** Choose the implementation of all kernels.
+
+    The kernels are fixed by the first baseband_init(), later calls only warn.
+    Call this at startup from a single thread.
+    @param impl the implementation to use, BASEBAND_IMPL_AUTO picks the best available
+    @return the implementation chosen, unchanged if @p impl is not available
+*/
+baseband_impl_t baseband_set_impl(baseband_impl_t impl);
+
+/// Get the kernel implementation in use on the calling thread.
+baseband_impl_t baseband_get_impl(void);
+
+/** Use all kernels of one implementation on the calling thread only, e.g. to time or compare them.
+
+    Other threads keep using the kernels selected by baseband_init().
+    @param impl the implementation to use, BASEBAND_IMPL_AUTO returns to the selected kernels
+    @return the implementation now in use on this thread, unchanged if @p impl is not available
+*/
+baseband_impl_t baseband_set_thread_impl(baseband_impl_t impl);
+
+/// Kernels that can be selected individually, e.g. by autotune.
+typedef enum baseband_kernel {
+    BASEBAND_KERNEL_ENVELOPE,
+    BASEBAND_KERNEL_MAG_EST_CU8,
+    BASEBAND_KERNEL_MAG_TRUE_CU8,
+    BASEBAND_KERNEL_MAG_EST_CS16,
+    BASEBAND_KERNEL_MAG_TRUE_CS16,
+    BASEBAND_KERNEL_FM_CU8, ///< Phase and atan pass of baseband_demod_FM()
+    BASEBAND_KERNEL_END,
+} baseband_kernel_t;
+
+/// Get the name of a kernel, as used in the wisdom file.
+char const *baseband_kernel_name(baseband_kernel_t kernel);
+
+/** Choose the implementation of a single kernel, other kernels are unchanged.
+
+    Like baseband_set_impl() this only works before the first baseband_init(),
+    a later baseband_set_impl() resets all kernels.
+    @param kernel the kernel to change
+    @param impl the implementation to use, must be available
+    @return the implementation now in use, unchanged if @p impl is not available
+*/
+baseband_impl_t baseband_set_kernel_impl(baseband_kernel_t kernel, baseband_impl_t impl);
+
+/// Get the implementation in use for a single kernel on the calling thread.
+baseband_impl_t baseband_get_kernel_impl(baseband_kernel_t kernel);
+
 #define AMP_TO_DB(x) (10.0f * ((x) > 0 ? log10f(x) : 0) - 42.1442f)  // 10*log10f(16384.0f)
 #define MAG_TO_DB(x) (20.0f * ((x) > 0 ? log10f(x) : 0) - 84.2884f)  // 20*log10f(16384.0f)
 #ifdef __exp10f
@@ -104,6 +206,7 @@ typedef struct demodfm_state {
     int32_t blp_16[2]; ///< Current low pass filter B coeffs, 16 bit
     int64_t alp_32[2]; ///< Current low pass filter A coeffs, 32 bit
     int64_t blp_32[2]; ///< Current low pass filter B coeffs, 32 bit
+    int fast_atan;     ///< Setting: use a polynomial atan (not bit-exact), kept on reset
 } demodfm_state_t;
 
 /** Reset the lowpass filter to an initial state. */
@@ -124,7 +227,9 @@ void baseband_demod_FM_reset(demodfm_state_t *demod_fm);
 
 /** FM demodulator.
 
-    Function is stateful.
+    Function is stateful, works on the whole block in two passes:
+    phase difference and atan for all samples, then the low pass filter.
+    The output is bit-exact to the per-sample reference unless `fast_atan` is set.
     @param[in,out] state State to store between chunk processing
     @param x_buf input samples (I/Q samples in interleaved uint8)
     @param[out] y_buf output from FM demodulator
@@ -137,8 +242,32 @@ void baseband_demod_FM(demodfm_state_t *state, uint8_t const *x_buf, int16_t *y_
 /// For evaluation.
 void baseband_demod_FM_cs16(demodfm_state_t *state, int16_t const *x_buf, int16_t *y_buf, unsigned long num_samples, uint32_t samp_rate, float low_pass);
 
-/** Initialize tables and constants.
-    Should be called once at startup.
+/** Fused AM and FM front end, CU8 samples.
+
+    Same output as envelope_detect() (or magnitude_est_cu8()), baseband_low_pass_filter()
+    and baseband_demod_FM() in sequence, but reads the IQ buffer from memory only once.
+    The unfiltered envelope is not kept.
+    @param[in,out] lp_state State of the AM low pass filter
+    @param[in,out] fm_state State of the FM demodulator
+    @param use_mag_est use the magnitude estimator instead of the envelope
+    @param iq_buf input samples (I/Q samples in interleaved uint8)
+    @param[out] am_buf low pass filtered AM output
+    @param[out] fm_buf FM demodulator output
+    @param len number of samples to process
+    @param samp_rate sample rate of samples to process
+    @param low_pass FM low-pass filter frequency or ratio
+    @return the average level in dB
+*/
+float baseband_demod_AM_FM(filter_state_t *lp_state, demodfm_state_t *fm_state, int use_mag_est,
+        uint8_t const *iq_buf, int16_t *am_buf, int16_t *fm_buf, uint32_t len, uint32_t samp_rate, float low_pass);
+
+/// Fused AM and FM front end, CS16 samples, see baseband_demod_AM_FM().
+float baseband_demod_AM_FM_cs16(filter_state_t *lp_state, demodfm_state_t *fm_state,
+        int16_t const *iq_buf, int16_t *am_buf, int16_t *fm_buf, uint32_t len, uint32_t samp_rate, float low_pass);
+
+/** Select the kernels chosen with baseband_set_impl() and baseband_set_kernel_impl(), by default the best for this CPU.
+    Only the first call selects, the kernels are read-only after that, e.g. for a second engine.
+    Call this before any input is processed.
 */
 void baseband_init(void);
 
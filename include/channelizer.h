@@ -0,0 +1,64 @@
+/** @file
+    Polyphase filterbank channelizer for wideband IQ input.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_CHANNELIZER_H_
+#define INCLUDE_CHANNELIZER_H_
+
+#include <stdint.h>
+
+#define CHANNELIZER_MIN_CHANNELS 2
+#define CHANNELIZER_MAX_CHANNELS 32
+#define CHANNELIZER_TAPS_PER_CHANNEL 16
+
+/// Channelizer state, a critically sampled analysis filterbank.
+///
+/// Channel k is centered at k * samp_rate / n_channels (wrapped to negative
+/// offsets for the upper half) and is output at samp_rate / n_channels.
+typedef struct channelizer {
+    unsigned n_channels; ///< Number of channels, also the decimation factor
+    unsigned taps;       ///< Prototype filter length, n_channels * CHANNELIZER_TAPS_PER_CHANNEL
+    unsigned phase;      ///< Input samples collected for the next output sample
+
+    float *coeffs;  ///< Prototype low pass filter
+    float *twiddle; ///< DFT twiddle factors, cos and sin interleaved, n_channels pairs
+    float *hist;    ///< Input history, interleaved I/Q, taps + n_channels samples
+
+    int16_t *buf;      ///< Output samples, CS16, one run of buf_len samples per channel
+    unsigned buf_len;  ///< Output buffer size in samples per channel
+} channelizer_t;
+
+/** Create a channelizer.
+
+    @param n_channels the number of channels, CHANNELIZER_MIN_CHANNELS to CHANNELIZER_MAX_CHANNELS
+    @return a new channelizer or NULL on bad channel count or alloc failure
+*/
+channelizer_t *channelizer_create(unsigned n_channels);
+
+void channelizer_free(channelizer_t *chz);
+
+void channelizer_reset(channelizer_t *chz);
+
+/** Split a frame of IQ samples into channels.
+
+    The filter state carries over between frames.
+    @param chz the channelizer
+    @param iq_buf input samples (I/Q samples in interleaved uint8 or int16)
+    @param n_samples number of input samples
+    @param sample_size CU8: 2, CS16: 4
+    @return the number of output samples per channel, see channelizer_output()
+*/
+unsigned long channelizer_push(channelizer_t *chz, void const *iq_buf, unsigned long n_samples, int sample_size);
+
+/// Output of channel @p k from the last push as interleaved CS16, valid until the next push.
+int16_t *channelizer_output(channelizer_t *chz, unsigned k);
+
+/// Center frequency offset of channel @p k in Hz for the given input sample rate.
+int32_t channelizer_offset(channelizer_t const *chz, unsigned k, uint32_t samp_rate);
+
+#endif /* INCLUDE_CHANNELIZER_H_ */
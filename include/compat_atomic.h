@@ -0,0 +1,34 @@
+/** @file
+    compat_atomic addresses compatibility atomic operations.
+
+    topic: lock-free data exchange between threads
+    issue: C99 has no atomics, GCC/Clang and MSVC have different intrinsics
+    solution: provide the few operations needed on 32-bit unsigned values
+*/
+
+#ifndef INCLUDE_COMPAT_ATOMIC_H_
+#define INCLUDE_COMPAT_ATOMIC_H_
+
+#if defined(__GNUC__) || defined(__clang__)
+
+#define ATOMIC_LOAD_ACQUIRE(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE_RELEASE(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define ATOMIC_EXCHANGE(p, v)       __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define ATOMIC_FETCH_ADD(p, v)      __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define ATOMIC_FETCH_SUB_ACQ_REL(p, v) __atomic_fetch_sub((p), (v), __ATOMIC_ACQ_REL)
+
+#elif defined(_MSC_VER)
+
+#include <windows.h>
+// volatile accesses have acquire and release semantics with /volatile:ms, the default on x86 and x64
+#define ATOMIC_LOAD_ACQUIRE(p)      (*(unsigned volatile *)(p))
+#define ATOMIC_STORE_RELEASE(p, v)  ((void)(*(unsigned volatile *)(p) = (v)))
+#define ATOMIC_EXCHANGE(p, v)       ((unsigned)InterlockedExchange((LONG volatile *)(p), (LONG)(v)))
+#define ATOMIC_FETCH_ADD(p, v)      ((unsigned)InterlockedExchangeAdd((LONG volatile *)(p), (LONG)(v)))
+#define ATOMIC_FETCH_SUB_ACQ_REL(p, v) ((unsigned)InterlockedExchangeAdd((LONG volatile *)(p), -(LONG)(v)))
+
+#else
+#error "No atomic operations for this compiler"
+#endif
+
+#endif /* INCLUDE_COMPAT_ATOMIC_H_ */
@@ -0,0 +1,37 @@
+/** @file
+    compat_mmap addresses compatibility read-only file mapping.
+
+    topic: reading large input files without copying
+    issue: mmap() is POSIX only, Windows uses file mapping objects
+    solution: map a whole file read-only with either, report failure otherwise
+*/
+
+#ifndef INCLUDE_COMPAT_MMAP_H_
+#define INCLUDE_COMPAT_MMAP_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+/// A read-only view of a whole file.
+typedef struct mmap_view {
+    unsigned char const *data;
+    size_t size;
+#ifdef _WIN32
+    void *mapping; ///< the file mapping object HANDLE
+#endif
+} mmap_view_t;
+
+/** Map a whole open file read-only, advised for sequential reading.
+
+    The view stays valid after the file is closed.
+
+    @param[out] view the view to set up
+    @param file an open regular file
+    @return 0 on success, -1 if the file can't be mapped, e.g. a pipe, an empty file, or too large
+*/
+int mmap_view_open(mmap_view_t *view, FILE *file);
+
+/// Unmap a view, an unmapped view is ignored.
+void mmap_view_close(mmap_view_t *view);
+
+#endif /* INCLUDE_COMPAT_MMAP_H_ */
@@ -0,0 +1,54 @@
+/** @file
+    IQ decimating front end (CIC filter).
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_DECIMATOR_H_
+#define INCLUDE_DECIMATOR_H_
+
+#include <stdint.h>
+
+#define DECIMATOR_MAX_FACTOR 16
+#define DECIMATOR_ORDER 3
+
+/// Decimator state, a 3rd order CIC filter on I and Q.
+typedef struct decimator {
+    unsigned factor;  ///< Decimation factor (1 to DECIMATOR_MAX_FACTOR)
+    unsigned phase;   ///< Input samples since the last output sample
+
+    uint32_t integ[2][DECIMATOR_ORDER]; ///< Integrator stages for I and Q, wrapping
+    uint32_t comb[2][DECIMATOR_ORDER];  ///< Comb stage delays for I and Q, wrapping
+
+    void *buf;         ///< Output buffer
+    unsigned buf_size; ///< Output buffer size in bytes
+} decimator_t;
+
+/** Create a decimator.
+
+    @param factor the decimation factor, 2 to DECIMATOR_MAX_FACTOR
+    @return a new decimator or NULL on bad factor or alloc failure
+*/
+decimator_t *decimator_create(unsigned factor);
+
+void decimator_free(decimator_t *dec);
+
+void decimator_reset(decimator_t *dec);
+
+/** Decimate a frame of IQ samples.
+
+    The output is in the same sample format as the input and is valid until the next call.
+    The filter state carries over between frames.
+    @param dec the decimator
+    @param iq_buf input samples (I/Q samples in interleaved uint8 or int16)
+    @param n_samples number of input samples
+    @param sample_size CU8: 2, CS16: 4
+    @param[out] out_samples number of output samples
+    @return the output buffer
+*/
+void *decimator_push(decimator_t *dec, void const *iq_buf, unsigned long n_samples, int sample_size, unsigned long *out_samples);
+
+#endif /* INCLUDE_DECIMATOR_H_ */
@@ -0,0 +1,39 @@
+/** @file
+    Worker pool to run the decoders of one priority level in parallel.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_DECODER_POOL_H_
+#define INCLUDE_DECODER_POOL_H_
+
+#define DECODER_POOL_MAX_WORKERS 64
+
+/// Run task @p i of a batch, called on any worker or the calling thread.
+typedef void (*decoder_pool_fn)(void *ctx, unsigned i);
+
+typedef struct decoder_pool decoder_pool_t;
+
+/** Start a worker pool.
+
+    @param n_workers the number of threads working on a batch, including the calling thread
+    @return a new pool or NULL on error or if threads are not available
+*/
+decoder_pool_t *decoder_pool_create(unsigned n_workers);
+
+/// Stop and free the pool, a NULL @p pool is ignored.
+void decoder_pool_free(decoder_pool_t *pool);
+
+/// Number of threads working on a batch, including the calling thread.
+unsigned decoder_pool_workers(decoder_pool_t *pool);
+
+/** Run the tasks 0 to @p n - 1 in any order and on any thread, returns when all are done.
+
+    A NULL @p pool runs the tasks in order on the calling thread.
+*/
+void decoder_pool_run(decoder_pool_t *pool, unsigned n, decoder_pool_fn fn, void *ctx);
+
+#endif /* INCLUDE_DECODER_POOL_H_ */
@@ -0,0 +1,128 @@
+/** @file
+    Demodulation pipeline threads fed by a lock-free ring of IQ frames.
+
+    The acquire thread queues each leased IQ frame, retained until processed,
+    the DSP thread processes the frames in order.
+    Optionally the DSP thread passes detected packages through a package pool
+    to a slicer thread, which runs the decoders.
+    Both threads queue the resulting events for the event loop.
+    All queues are single-producer single-consumer rings.
+
+    Only the acquire thread can't wait, a full frame ring drops frames.
+    A full package ring makes the DSP thread wait for the slicer thread,
+    the frame ring then buffers the input.
+    A full event ring makes the DSP or slicer thread wait for the event loop.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_DSP_THREAD_H_
+#define INCLUDE_DSP_THREAD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "iq_pool.h"
+
+/// Process one IQ frame, called on the DSP thread.
+typedef void (*dsp_frame_fn)(void *ctx, iq_frame_t *iq, uint32_t len, uint32_t sample_rate, uint32_t center_frequency);
+
+/// Process one package, called on the slicer thread.
+typedef void (*dsp_package_fn)(void *ctx, void *package);
+
+/// Wake the event loop to pop events, called on the DSP thread, must not block.
+typedef void (*dsp_wake_fn)(void *ctx);
+
+typedef struct dsp_thread dsp_thread_t;
+
+/// Queue statistics, a snapshot.
+typedef struct dsp_stats {
+    unsigned frames_size;       ///< Capacity of the IQ frame ring
+    unsigned frames_depth;      ///< IQ frames waiting for the DSP thread
+    unsigned frames_high_water; ///< Most IQ frames ever waiting
+    unsigned frames_dropped;    ///< IQ frames dropped because the ring was full
+    unsigned packages_size;       ///< Capacity of the package ring
+    unsigned packages_depth;      ///< Packages waiting for the slicer thread
+    unsigned packages_high_water; ///< Most packages ever waiting
+    unsigned packages_stalled;    ///< Times the DSP thread waited for the slicer thread
+    unsigned events_size;       ///< Capacity of the event ring
+    unsigned events_depth;      ///< Events waiting for the event loop
+    unsigned events_high_water; ///< Most events ever waiting
+    unsigned events_stalled;    ///< Times a pipeline thread waited for the event loop
+    unsigned events_dropped;    ///< Events dropped because the pipeline stopped while waiting
+} dsp_stats_t;
+
+/** Start a DSP thread and optionally a slicer thread.
+
+    @param n_frames the number of IQ frames that can be queued
+    @param frame_fn the frame processing function
+    @param n_packages the number of packages that can be buffered, 0 for no slicer thread
+    @param package_size the package size in bytes, packages start zeroed
+    @param package_fn the package processing function
+    @param n_events the number of events that can be buffered per thread
+    @param wake_fn the event loop wake up function
+    @param ctx the context for @p frame_fn, @p package_fn, and @p wake_fn
+    @return a new DSP thread or NULL on error or if threads are not available
+*/
+dsp_thread_t *dsp_thread_start(unsigned n_frames, dsp_frame_fn frame_fn,
+        unsigned n_packages, size_t package_size, dsp_package_fn package_fn,
+        unsigned n_events, dsp_wake_fn wake_fn, void *ctx);
+
+/// Stop the threads after the current frame and package, queued frames and packages are discarded, events can still be popped.
+void dsp_thread_stop(dsp_thread_t *dsp);
+
+/// Call @p fn on each package of the pool of a stopped thread, e.g. to free memory owned by packages, a NULL @p dsp is ignored.
+void dsp_thread_foreach_package(dsp_thread_t *dsp, void (*fn)(void *package));
+
+/// Free a stopped thread, queued frames are released, remaining events must be popped before.
+void dsp_thread_free(dsp_thread_t *dsp);
+
+/** Queue an IQ frame, called on the acquire thread, never blocks.
+
+    The frame is retained until processed, the caller keeps its own reference.
+
+    @return 0 on success, -1 if the frame was dropped
+*/
+int dsp_thread_push_frame(dsp_thread_t *dsp, iq_frame_t *iq, uint32_t len, uint32_t sample_rate, uint32_t center_frequency);
+
+/// Check if the caller is the DSP thread and packages should be passed to a slicer thread.
+int dsp_thread_sliced(dsp_thread_t *dsp);
+
+/** Get a free package, called on the DSP thread, waits if all packages are in use.
+
+    @return a package to fill, or NULL if the thread is stopping
+*/
+void *dsp_thread_get_package(dsp_thread_t *dsp);
+
+/// Queue a filled package for the slicer thread, called on the DSP thread.
+void dsp_thread_push_package(dsp_thread_t *dsp, void *package);
+
+/// Get the package processed on the slicer thread, NULL on other threads.
+void *dsp_thread_package(void);
+
+/** Queue an event for the event loop of the calling DSP or slicer thread's pipeline.
+
+    Waits for the event loop if the ring is full, the processing lock is released meanwhile.
+
+    @return 0 on success, -1 if the pipeline stopped while waiting, the event needs to be freed by the caller
+*/
+int dsp_thread_push_event(void *event);
+
+/// Pop an event, called on the event loop, returns NULL if there are no more events.
+void *dsp_thread_pop_event(dsp_thread_t *dsp);
+
+/// Check if the caller runs on the DSP or slicer thread.
+int dsp_thread_current(void);
+
+/// Lock the frame and package processing, e.g. to safely reset statistics from the event loop, a NULL @p dsp is ignored.
+void dsp_thread_lock(dsp_thread_t *dsp);
+
+void dsp_thread_unlock(dsp_thread_t *dsp);
+
+/// Get the queue statistics, a NULL @p dsp gives all zero statistics.
+void dsp_thread_stats(dsp_thread_t *dsp, dsp_stats_t *stats);
+
+#endif /* INCLUDE_DSP_THREAD_H_ */
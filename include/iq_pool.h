@@ -0,0 +1,61 @@
+/** @file
+    Pool of refcounted IQ frames, leased by the acquire thread to the consumers.
+
+    The acquire thread leases a free frame, fills it, and passes it on.
+    Each consumer that keeps the frame beyond the call retains it and releases it when done.
+    A frame is free again when the last reference is released,
+    the producer never overwrites a frame that is still in use, it drops the input instead.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_IQ_POOL_H_
+#define INCLUDE_IQ_POOL_H_
+
+#include <stddef.h>
+
+struct iq_pool;
+
+/// An IQ frame of a pool.
+typedef struct iq_frame {
+    struct iq_pool *pool;
+    unsigned refs;      ///< References held, 0 if the frame is free
+    unsigned char *buf; ///< Frame data of the pool frame size
+} iq_frame_t;
+
+/// Pool state, only one thread may lease frames, any thread may retain and release them.
+typedef struct iq_pool {
+    unsigned n_frames;
+    size_t frame_size;
+    unsigned next;       ///< Next frame to try to lease, written by the producer
+    unsigned users;      ///< The owner and one per leased frame, the pool is freed when this drops to 0
+    unsigned exhausted;  ///< Leases failed because all frames were in use, written by the producer, read atomically
+    unsigned high_water; ///< Most frames ever leased at once, written by the producer, read atomically
+    iq_frame_t *frames;
+    unsigned char *frame_buf;
+} iq_pool_t;
+
+/** Create a pool.
+
+    @param n_frames the number of frames
+    @param frame_size the frame size in bytes
+    @return a new pool or NULL on alloc failure
+*/
+iq_pool_t *iq_pool_create(unsigned n_frames, size_t frame_size);
+
+/// Release the owner's reference, the pool is freed once all frames are released, a NULL @p pool is ignored.
+void iq_pool_free(iq_pool_t *pool);
+
+/// Lease a free frame with one reference, producer only, returns NULL if all frames are in use.
+iq_frame_t *iq_pool_lease(iq_pool_t *pool);
+
+/// Add a reference to a frame, the caller must already hold one.
+void iq_frame_retain(iq_frame_t *frame);
+
+/// Drop a reference to a frame, the last reference returns it to the pool, a NULL @p frame is ignored.
+void iq_frame_release(iq_frame_t *frame);
+
+#endif /* INCLUDE_IQ_POOL_H_ */
@@ -18,7 +18,8 @@
 #include "data.h"
 #include "compat_time.h"
 
-#define PD_MAX_PULSES        1200 // Maximum number of pulses before forcing End Of Package
+#define PD_MAX_PULSES        1200 // Maximum number of pulses before forcing End Of Package, FSK packages grow beyond
+#define PD_HARD_MAX_PULSES   9600 // Maximum number of pulses of a growing FSK package before shifting out old pulses
 #define PD_MIN_PULSES        16   // Minimum number of pulses before declaring a proper package
 #define PD_MIN_PULSE_SAMPLES 10   // Minimum number of samples in a pulse for proper detection
 #define PD_MIN_GAP_MS        10   // Minimum gap size in milliseconds to exceed to declare End Of Package
@@ -26,7 +27,11 @@
 #define PD_MAX_GAP_RATIO     10   // Ratio gap/pulse width to exceed to declare End Of Package (heuristic)
 #define PD_MAX_PULSE_MS      100  // Pulse width in ms to exceed to declare End Of Package (e.g. for non OOK packages)
 
-/// Data for a compact representation of generic pulse train.
+/** Data for a compact representation of generic pulse train.
+
+    The pulse and gap widths are allocated to fit, use pulse_data_reserve() before adding pulses
+    and pulse_data_copy() instead of assigning the structure. A zeroed structure is empty.
+*/
 typedef struct pulse_data {
     uint64_t offset;      ///< Offset to first pulse in number of samples from start of stream.
     uint32_t sample_rate; ///< Sample rate the pulses are recorded with.
@@ -34,8 +39,9 @@ typedef struct pulse_data {
     unsigned start_ago;   ///< Start of first pulse in number of samples ago.
     unsigned end_ago;     ///< End of last pulse in number of samples ago.
     unsigned int num_pulses;
-    int pulse[PD_MAX_PULSES]; ///< Width of pulses (high) in number of samples.
-    int gap[PD_MAX_PULSES];   ///< Width of gaps between pulses (low) in number of samples.
+    unsigned capacity;        ///< Number of pulses and gaps allocated.
+    int *pulse;               ///< Width of pulses (high) in number of samples.
+    int *gap;                 ///< Width of gaps between pulses (low) in number of samples.
     int ook_low_estimate;     ///< Estimate for the OOK low level (base noise level) at beginning of package.
     int ook_high_estimate;    ///< Estimate for the OOK high level at end of package.
     int fsk_f1_est;           ///< Estimate for the F1 frequency for FSK.
@@ -49,12 +55,30 @@ typedef struct pulse_data {
     float noise_db;
 } pulse_data_t;
 
-/// Clear the content of a pulse_data_t structure.
+/// Clear the content of a pulse_data_t structure, the allocation is kept.
 void pulse_data_clear(pulse_data_t *data);
 
+/** Grow the pulse and gap arrays to hold at least @p capacity pulses, new entries are zero.
+
+    @return 0 on success, -1 on alloc failure, the data is unchanged then
+*/
+int pulse_data_reserve(pulse_data_t *data, unsigned capacity);
+
+/** Copy a pulse_data_t structure, @p dst keeps its own allocation grown to fit.
+
+    @return 0 on success, -1 on alloc failure, the pulses are truncated to the capacity of @p dst then
+*/
+int pulse_data_copy(pulse_data_t *dst, pulse_data_t const *src);
+
+/// Free the pulse and gap arrays, the structure is empty after, a zeroed structure is ignored.
+void pulse_data_free(pulse_data_t *data);
+
 /// Shift out part of the data to make room for more.
 void pulse_data_shift(pulse_data_t *data);
 
+/// Scale all timings up by an integer factor and the sample rate with it, e.g. to undo decimation.
+void pulse_data_rescale(pulse_data_t *data, unsigned factor);
+
 /// Print the content of a pulse_data_t structure (for debug).
 void pulse_data_print(pulse_data_t const *data);
 
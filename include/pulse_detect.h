@@ -41,6 +41,9 @@ void pulse_detect_free(pulse_detect_t *pulse_detect);
 /// Reset pulse detector to initial values.
 void pulse_detect_reset(pulse_detect_t *pulse_detect);
 
+/// Check if the pulse detector is between packages, i.e. no package is in progress.
+int pulse_detect_idle(pulse_detect_t const *pulse_detect);
+
 /// Set pulse detector level values.
 ///
 /// @param pulse_detect The pulse_detect instance
@@ -61,8 +64,8 @@ void pulse_detect_set_levels(pulse_detect_t *pulse_detect, int use_mag_est, floa
 /// @param len Number of samples in input buffers
 /// @param samp_rate Sample rate in samples per second
 /// @param sample_offset Offset tracking for ringbuffer
-/// @param[in,out] pulses Will return a pulse_data_t structure
-/// @param[in,out] fsk_pulses Will return a pulse_data_t structure for FSK demodulated data
+/// @param[in,out] pulses Will return a pulse_data_t structure, grown as needed
+/// @param[in,out] fsk_pulses Will return a pulse_data_t structure for FSK demodulated data, grown as needed
 /// @param fpdm Index of filter setting to use
 /// @return if a package is detected
 /// @retval 0 all input sample data is processed
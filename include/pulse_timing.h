@@ -0,0 +1,45 @@
+/** @file
+    Timing signature of a pulse package to skip decoders that can't match.
+
+    The widths of the pulses and gaps are counted in quarter octave bins,
+    the bins holding a notable part of the package form the signature.
+    A decoder is compatible if one of its symbol widths, within its tolerance,
+    falls into a signature bin. The check is a heuristic: the slicers accept
+    any width, a skipped decoder might have decoded a badly timed package.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_PULSE_TIMING_H_
+#define INCLUDE_PULSE_TIMING_H_
+
+#include <stdint.h>
+
+#define PULSE_TIMING_BINS 64 // Quarter octave bins of widths from 1 to 2^17 samples, longer widths in the last bin
+
+struct pulse_data;
+struct r_device;
+
+/// Timing signature of a package, a bit set for each bin of the dominant widths.
+typedef struct pulse_timing {
+    uint32_t sample_rate; ///< Sample rate of the package, to scale the decoder widths
+    uint64_t pulses;      ///< Bins of the dominant pulse widths
+    uint64_t gaps;        ///< Bins of the dominant gap widths, without the final gap
+} pulse_timing_t;
+
+/// Compute the timing signature of a package.
+void pulse_timing_analyze(pulse_timing_t *timing, struct pulse_data const *data);
+
+/** Check if the symbol timing of a decoder is compatible with a package.
+
+    Decoders of a modulation without a timing check, and decoders with widths
+    that round to zero samples, are always compatible.
+
+    @return 1 if the decoder might match the package, 0 if it can be skipped
+*/
+int pulse_timing_compatible(pulse_timing_t const *timing, struct r_device const *r_dev);
+
+#endif /* INCLUDE_PULSE_TIMING_H_ */
@@ -19,6 +19,8 @@ struct r_device;
 struct data;
 struct pulse_data;
 struct list;
+struct dm_state;
+struct output_capture;
 struct mg_mgr;
 
 /* general */
@@ -29,9 +31,20 @@ void r_init_cfg(struct r_cfg *cfg);
 
 void r_free_cfg(struct r_cfg *cfg);
 
+/** Create a config to process input files in parallel with @p cfg.
+
+    The job shares the settings, outputs, and data tags of @p cfg,
+    but has its own demodulator state and an instance of each registered decoder.
+*/
+struct r_cfg *r_create_job_cfg(struct r_cfg *cfg);
+
+/// Add the statistics of a job to @p cfg and free the job.
+void r_free_job_cfg(struct r_cfg *job, struct r_cfg *cfg);
+
 /* device decoder protocols */
 
-void register_protocol(struct r_cfg *cfg, struct r_device const *r_dev, char *arg);
+/// Register a decoder, @return 0 on success, -1 if the decoder could not be created, e.g. on bad arguments.
+int register_protocol(struct r_cfg *cfg, struct r_device const *r_dev, char *arg);
 
 void free_protocol(struct r_device *r_dev);
 
@@ -51,6 +64,12 @@ int run_ook_demods(struct list *r_devs, struct pulse_data *pulse_data);
 
 int run_fsk_demods(struct list *r_devs, struct pulse_data *fsk_pulse_data);
 
+/** Run the OOK or FSK decoders of @p demod, the decoders of each priority level spread over the workers of its decoder pool, if any.
+
+    With the timing filter set the decoders with an incompatible symbol timing are skipped and counted.
+*/
+int run_demods(struct dm_state *demod, struct pulse_data *pulse_data, int package_type);
+
 /* handlers */
 
 void r_redirect_logging(struct r_cfg *cfg);
@@ -61,6 +80,21 @@ void log_device_handler(struct r_device *r_dev, int level, struct data *data);
 
 void data_acquired_handler(struct r_device *r_dev, struct data *data);
 
+/// Print all outputs queued by the DSP thread, call on the event loop.
+void pop_dsp_events(struct r_cfg *cfg);
+
+/// Hold back all outputs and log messages of the current thread, e.g. of a job @p cfg, until printed.
+struct output_capture *start_output_capture(struct r_cfg *cfg);
+
+/// Stop holding back outputs of the current thread.
+void stop_output_capture(void);
+
+/// Print and free the held back outputs, call on the thread that prints all outputs.
+void print_output_capture(struct output_capture *capture);
+
+/// Free the held back outputs without printing.
+void discard_output_capture(struct output_capture *capture);
+
 struct data *create_report_data(struct r_cfg *cfg, int level);
 
 void flush_report_data(struct r_cfg *cfg);
@@ -105,6 +139,8 @@ void add_infile(struct r_cfg *cfg, char *in_file);
 
 void add_data_tag(struct r_cfg *cfg, char *param);
 
+void set_channels(struct r_cfg *cfg, unsigned n_channels);
+
 /* runtime */
 
 struct mg_mgr *get_mgr(struct r_cfg *cfg);
@@ -85,10 +85,12 @@ typedef struct r_device {
     unsigned decode_ok;
     unsigned decode_messages;
     unsigned decode_fails[5];
+    unsigned decode_skipped; ///< packages not sliced, the symbol timing did not match
 
     /* private for flex decoder and output callback */
     void *decode_ctx;
     void *output_ctx;
+    char *create_args; ///< Copy of the args given to create_fn, to create more instances
 } r_device;
 
 #endif /* INCLUDE_R_DEVICE_H_ */
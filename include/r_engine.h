@@ -0,0 +1,102 @@
+/** @file
+    Reentrant decoding engine to embed the decoders in other programs.
+
+    An engine has its own settings, demodulator state, and decoder instances.
+    It needs no event loop, signal handlers, or SDR device, the caller pushes
+    IQ or pulse data and receives the decoded events on a callback.
+    Several engines can run concurrently on different threads, they share
+    no mutable state. A single engine must only be used by one thread at a time.
+
+    Log messages of the library still go to the process-wide log handler,
+    see r_logger_set_log_handler(), the engine never changes it.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_R_ENGINE_H_
+#define INCLUDE_R_ENGINE_H_
+
+#include <stdint.h>
+
+struct r_cfg;
+struct data;
+struct pulse_data;
+
+typedef struct r_engine r_engine_t;
+
+/** Event callback, called on the thread pushing the data.
+
+    @param ctx the context given to r_engine_set_event_handler()
+    @param data the decoded event, owned by the engine and freed after the call
+*/
+typedef void (*r_engine_event_fn)(void *ctx, struct data *data);
+
+/** Create an engine without any decoders.
+
+    Events are timed by their sample position in the pushed input, see r_engine_cfg() to change that.
+    @return a new engine or NULL on alloc failure
+*/
+r_engine_t *r_engine_create(void);
+
+/// Free an engine and its decoders, a NULL @p engine is ignored.
+void r_engine_free(r_engine_t *engine);
+
+/** Get the settings of an engine, e.g. to set report_meta or the detector levels.
+
+    Change settings before pushing data, the detector levels are applied by r_engine_set_input().
+*/
+struct r_cfg *r_engine_cfg(r_engine_t *engine);
+
+/// Set the callback for decoded events, a NULL @p fn drops the events.
+void r_engine_set_event_handler(r_engine_t *engine, r_engine_event_fn fn, void *ctx);
+
+/// Register all decoders that are enabled by default.
+void r_engine_register_defaults(r_engine_t *engine);
+
+/** Register a decoder by protocol number, like the -R option.
+
+    @param protocol_num the protocol number, starting at 1
+    @param arg decoder arguments or NULL
+    @return 0 on success, -1 if there is no such protocol
+*/
+int r_engine_register_protocol(r_engine_t *engine, unsigned protocol_num, char *arg);
+
+/** Register a flex decoder, like the -X option.
+
+    @param spec the flex decoder spec
+    @return 0 on success, -1 on an invalid spec, the reason is printed to stderr
+*/
+int r_engine_register_flex(r_engine_t *engine, char *spec);
+
+/** Set the format of the IQ data pushed, data of earlier settings is flushed first.
+
+    @param sample_rate the sample rate in Hz
+    @param center_frequency the center frequency in Hz, reported and used to pick the FSK pulse detector
+    @param sample_size 2 for CU8 or 4 for CS16 samples
+    @return 0 on success, -1 on an invalid sample size
+*/
+int r_engine_set_input(r_engine_t *engine, uint32_t sample_rate, uint32_t center_frequency, int sample_size);
+
+/** Demodulate and decode a block of IQ data, events are passed to the callback before this returns.
+
+    Packages might continue in the next block, call r_engine_flush() at the end of the input.
+    @param iq_buf IQ samples in the format of r_engine_set_input(), only read
+    @param len the length in bytes
+    @return the number of events, or -1 if no input format is set
+*/
+int r_engine_push_iq(r_engine_t *engine, unsigned char const *iq_buf, uint32_t len);
+
+/// Decode the packages still in progress at the end of the input, @return the number of events.
+int r_engine_flush(r_engine_t *engine);
+
+/** Decode pulse data, e.g. from an external detector, with the FSK decoders if fsk_f2_est is set, otherwise OOK.
+
+    @param pulse_data the pulses, copied, see pulse_data_reserve() to set them up
+    @return the number of events
+*/
+int r_engine_push_pulses(r_engine_t *engine, struct pulse_data const *pulse_data);
+
+#endif /* INCLUDE_R_ENGINE_H_ */
@@ -15,11 +15,23 @@
 #include <stdint.h>
 
 struct r_cfg;
+struct dm_package;
 
 int flush_sdr_flow(struct r_cfg *cfg);
 
 void reset_sdr_flow(struct r_cfg *cfg);
 
+/// Check if no package is in progress in the pulse detectors, e.g. before a flush would cut one off.
+int idle_sdr_flow(struct r_cfg *cfg);
+
+/// Free the demodulator buffers, they are allocated again on the next frame.
+void free_sdr_flow(struct r_cfg *cfg);
+
 int push_sdr_flow(struct r_cfg *cfg, unsigned char *iq_buf, uint32_t len);
 
+int slice_sdr_package(struct r_cfg *cfg, struct dm_package *pkg);
+
+/// Free the pulse data owned by a package, see dsp_thread_foreach_package().
+void free_sdr_package(void *package);
+
 #endif /* INCLUDE_R_FLOW_H_ */
@@ -13,9 +13,30 @@
 #include "fileformat.h"
 #include "samp_grab.h"
 #include "am_analyze.h"
+#include "decimator.h"
+#include "channelizer.h"
+#include "decoder_pool.h"
 #include "rtl_433.h"
 #include "compat_time.h"
 
+/// Demodulator state of one channelizer channel.
+typedef struct dm_channel {
+    int32_t freq_offset; ///< Channel center offset from the input center frequency
+    pulse_detect_t *pulse_detect;
+    filter_state_t lowpass_filter_state;
+    demodfm_state_t demod_FM_state;
+    pulse_data_t pulse_data;
+    pulse_data_t fsk_pulse_data;
+} dm_channel_t;
+
+/// A detected package passed from the DSP thread to the slicer thread.
+typedef struct dm_package {
+    int package_type;      ///< PULSE_DATA_OOK or PULSE_DATA_FSK
+    struct timeval now;    ///< Time of the frame the package ended in
+    float sample_file_pos; ///< Sample file position of that frame
+    pulse_data_t pulse_data;
+} dm_package_t;
+
 struct dm_state {
     float auto_level;
     float squelch_offset;
@@ -27,20 +48,28 @@ struct dm_state {
     float fm_low_pass;
     int use_mag_est;
     int detect_verbosity;
+    int squelch_probe; ///< Last frame was squelched, the next may be squelched by a level probe
+    int timing_filter; ///< Skip the decoders with a symbol timing incompatible to the package, see pulse_timing.h
 
-    int16_t am_buf[MAXIMAL_BUF_LENGTH];  // AM demodulated signal (for OOK decoding)
+    int16_t *am_buf;  // AM demodulated signal (for OOK decoding)
     union {
         // These buffers aren't used at the same time, so let's use a union to save some memory
-        int16_t fm[MAXIMAL_BUF_LENGTH];  // FM demodulated signal (for FSK decoding)
-        uint16_t temp[MAXIMAL_BUF_LENGTH];  // Temporary buffer (to be optimized out..)
+        int16_t *fm;  // FM demodulated signal (for FSK decoding)
+        uint16_t *temp;  // Temporary buffer (to be optimized out..)
     } buf;
-    uint8_t u8_buf[MAXIMAL_BUF_LENGTH]; // format conversion buffer
-    float f32_buf[MAXIMAL_BUF_LENGTH]; // format conversion buffer
+    uint8_t *u8_buf; // logic state buffer, only allocated for U8 logic dumpers
+    float *f32_buf; // format conversion buffer of two floats per sample, only allocated for converting dumpers
+    unsigned long buf_samples; ///< Samples the buffers above hold, grown to the largest frame on demand
     int sample_size; // CU8: 2, CS16: 4
     pulse_detect_t *pulse_detect;
     filter_state_t lowpass_filter_state;
     demodfm_state_t demod_FM_state;
     int enable_FM_demod;
+    decimator_t *decimator; ///< Optional decimation of IQ data ahead of the demodulators
+    channelizer_t *channelizer; ///< Optional split of the IQ data into channels, replaces the wideband demodulators
+    dm_channel_t *channels;     ///< Per channel demodulator state, one for each channelizer channel
+    dm_channel_t *channel;      ///< The channel currently being decoded, NULL when decoding the wideband input
+    decoder_pool_t *decoder_pool; ///< Optional workers to run the decoders of each priority level in parallel
     samp_grab_t *samp_grab;
     am_analyze_t *am_analyze;
     int analyze_pulses;
@@ -53,6 +82,8 @@ struct dm_state {
     pulse_data_t    pulse_data;
     pulse_data_t    fsk_pulse_data;
     uint64_t input_pos;
+    uint64_t chunk_from;  ///< First input sample owned by a file chunk job, earlier packages are left to the previous chunk
+    uint64_t chunk_until; ///< End of the input samples owned by a file chunk job, 0 to decode all packages
     unsigned frame_event_count;
     int frame_quality;
     unsigned frame_start_ago;
@@ -69,11 +100,13 @@ struct dm_state {
     int verbosity; ///< 0=normal, 1=verbose, 2=verbose decoders, 3=debug decoders, 4=trace decoding.
     int report_noise;
     list_t *raw_handler;
+    struct iq_frame *iq_frame; ///< the leased frame of the IQ data pushed, NULL if not leased
 
     /* global stats */
     time_t running_since;          ///< program start time statistic
     unsigned total_frames_count;   ///< total frames recieved statistic
     unsigned total_frames_squelch; ///< total frames with noise only statistic
+    unsigned total_frames_probed;  ///< total frames with noise only from the level probe alone statistic
     unsigned total_frames_ook;     ///< total frames with ook demod statistic
     unsigned total_frames_fsk;     ///< total frames with fsk demod statistic
     unsigned total_frames_events;  ///< total frames with decoder events statistic
@@ -83,6 +116,7 @@ struct dm_state {
     unsigned frames_ook;    ///< counter of ook demods for report interval statistic
     unsigned frames_fsk;    ///< counter of fsk demods for report interval statistic
     unsigned frames_events; ///< counter of decoder events for report interval statistic
+    unsigned demods_skipped; ///< counter of decoders skipped by the timing filter for report interval statistic
 };
 
 #endif /* INCLUDE_R_PRIVATE_H_ */
@@ -15,13 +15,15 @@
 #include <stdint.h>
 
 struct raw_output;
+struct iq_frame;
 
 typedef struct raw_output {
-    void (*output_frame)(struct raw_output *output, uint8_t const *data, uint32_t len);
+    void (*output_frame)(struct raw_output *output, uint8_t const *data, uint32_t len, struct iq_frame *frame);
     void (*output_free)(struct raw_output *output);
 } raw_output_t;
 
-void raw_output_frame(struct raw_output *output, uint8_t const *data, uint32_t len);
+/// Output a frame, an output that uses @p data after returning retains the leased @p frame, which is NULL if not leased.
+void raw_output_frame(struct raw_output *output, uint8_t const *data, uint32_t len, struct iq_frame *frame);
 
 void raw_output_free(struct raw_output *output);
 
@@ -21,6 +21,10 @@
 #define MAXIMAL_BUF_LENGTH      (256 * 16384)
 #define SIGNAL_GRABBER_BUFFER   (12 * DEFAULT_BUF_LENGTH)
 #define MAX_FREQS               32
+#define DSP_FRAME_NUMBER        16   // IQ frames buffered for the DSP thread
+#define DSP_PACKAGE_NUMBER      16   // packages buffered for the slicer thread
+#define DSP_EVENT_NUMBER        1024 // outputs buffered for the event loop
+#define MAX_JOBS                64   // input files processed in parallel
 
 #define INPUT_LINE_MAX 8192 /**< enough for a complete textual bitbuffer (25*256) */
 
@@ -61,14 +65,20 @@ typedef struct r_cfg {
     device_mode_t dev_mode; ///< Input device run mode
     device_state_t dev_state; ///< Input device run state
     char *dev_query;
+    list_t dev_queries; ///< All -d device queries, the first is dev_query, each further one gets an SDR input of its own
+    list_t sdr_inputs; ///< The SDR inputs of the further -d devices, each with its own device, demodulator, and DSP thread
+    int sdr_index; ///< Number of this SDR input with several -d devices, tagged on the events, -1 otherwise
     char const *dev_info;
     char *gain_str;
+    char *wisdom_file; ///< Baseband kernel autotune wisdom file, NULL to use the default kernels
     char *settings_str;
     int ppm_error;
     uint32_t out_block_size;
     char const *test_data;
     list_t in_files;
     char const *in_filename;
+    int jobs; ///< Number of input files processed in parallel, 0 or 1 to process them in turn
+    int jobs_split; ///< Also split large IQ input files into overlapped chunks for the jobs
     int in_replay;
     volatile sig_atomic_t hop_now; ///< flag to cause channel hopping, async written by signal handler and push_sdr_flow()
     volatile sig_atomic_t exit_async; ///< flag to cause exiting, async written by signal handler
@@ -111,7 +121,9 @@ typedef struct r_cfg {
     list_t output_handler;
     list_t raw_handler;
     int has_logout;
+    int log_redirected; ///< The process-wide log handler is set to this config, see r_redirect_logging()
     struct dm_state *demod;
+    struct dsp_thread *dsp; ///< Demodulation thread for SDR input, NULL to demodulate on the event loop
     char const *sr_filename;
     int sr_execopen;
     int watchdog; ///< SDR acquire stall watchdog
@@ -19,6 +19,17 @@
 
 typedef struct sdr_dev sdr_dev_t;
 
+struct iq_frame;
+
+/// Input statistics, a snapshot.
+typedef struct sdr_stats {
+    unsigned frames_produced; ///< Frames delivered to the consumers
+    unsigned frames_dropped;  ///< Frames dropped because all frames were still in use
+    unsigned overflows;       ///< Overflows reported by the device, samples were lost
+    unsigned lag_max;         ///< Most frames ever held by the consumers at once
+    unsigned lag_max_ms;      ///< Most frames ever held by the consumers at once, in milliseconds of samples
+} sdr_stats_t;
+
 typedef enum sdr_event_flags {
     SDR_EV_EMPTY = 0,
     SDR_EV_DATA = 1 << 0,
@@ -36,6 +47,7 @@ typedef struct sdr_event {
     char const *gain_str;
     void *buf;
     int len;
+    struct iq_frame *frame; ///< The leased frame of buf, retain it to use buf after the callback returns
 } sdr_event_t;
 
 typedef void (*sdr_event_cb_t)(sdr_event_t *ev, void *ctx);
@@ -81,6 +93,13 @@ int sdr_get_sample_size(sdr_dev_t *dev);
 */
 int sdr_get_sample_signed(sdr_dev_t *dev);
 
+/** Get the input statistics, counted since the device was opened.
+
+    @param dev the device handle, NULL for all zero statistics
+    @param[out] stats the statistics
+*/
+void sdr_get_stats(sdr_dev_t *dev, sdr_stats_t *stats);
+
 /** Set device frequency, optionally report status.
 
     @param dev the device handle
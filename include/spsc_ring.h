@@ -0,0 +1,45 @@
+/** @file
+    Lock-free single-producer single-consumer ring of pointers.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_SPSC_RING_H_
+#define INCLUDE_SPSC_RING_H_
+
+#define SPSC_RING_CACHE_LINE 64
+
+/// Ring state, one thread may push and another thread may pop concurrently.
+typedef struct spsc_ring {
+    void **elems;        ///< Element slots
+    unsigned size;       ///< Number of slots, a power of two
+    unsigned high_water; ///< Most elements ever queued, written by the producer
+    char pad0[SPSC_RING_CACHE_LINE];
+    unsigned head; ///< Next slot to push, written by the producer
+    char pad1[SPSC_RING_CACHE_LINE];
+    unsigned tail; ///< Next slot to pop, written by the consumer
+    char pad2[SPSC_RING_CACHE_LINE];
+} spsc_ring_t;
+
+/** Create a ring.
+
+    @param size the capacity, rounded up to a power of two
+    @return a new ring or NULL on alloc failure
+*/
+spsc_ring_t *spsc_ring_create(unsigned size);
+
+void spsc_ring_free(spsc_ring_t *ring);
+
+/// Push an element, producer only, returns 0 on success or -1 if the ring is full.
+int spsc_ring_push(spsc_ring_t *ring, void *elem);
+
+/// Pop an element, consumer only, returns NULL if the ring is empty.
+void *spsc_ring_pop(spsc_ring_t *ring);
+
+/// Number of queued elements, exact for the producer and the consumer, a snapshot otherwise.
+unsigned spsc_ring_depth(spsc_ring_t *ring);
+
+#endif /* INCLUDE_SPSC_RING_H_ */
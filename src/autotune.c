@@ -0,0 +1,321 @@
+/** @file
+    Startup autotune of the baseband kernels with a persisted wisdom file.
+
+    The fastest implementation of a kernel depends on the CPU and the frame size,
+    the winners are stored per frame size in a small text file, one line per kernel:
+
+        <block size> <kernel name> <implementation name>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "autotune.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "compat_time.h"
+#include "logger.h"
+#include "fatal.h"
+
+#define WISDOM_LINE_MAX 128
+#define WISDOM_MAX_LINES 256
+
+/// Run one kernel over a frame once.
+static void run_kernel(baseband_kernel_t kernel, uint8_t *iq_buf, uint16_t *y_buf, int16_t *fm_buf, uint32_t block_size, demodfm_state_t *fm_state)
+{
+    switch (kernel) {
+    case BASEBAND_KERNEL_ENVELOPE:
+        envelope_detect(iq_buf, y_buf, block_size / 2);
+        break;
+    case BASEBAND_KERNEL_MAG_EST_CU8:
+        magnitude_est_cu8(iq_buf, y_buf, block_size / 2);
+        break;
+    case BASEBAND_KERNEL_MAG_TRUE_CU8:
+        magnitude_true_cu8(iq_buf, y_buf, block_size / 2);
+        break;
+    case BASEBAND_KERNEL_MAG_EST_CS16:
+        magnitude_est_cs16((int16_t *)iq_buf, y_buf, block_size / 4);
+        break;
+    case BASEBAND_KERNEL_MAG_TRUE_CS16:
+        magnitude_true_cs16((int16_t *)iq_buf, y_buf, block_size / 4);
+        break;
+    default:
+        baseband_demod_FM(fm_state, iq_buf, fm_buf, block_size / 2, 1000000, 0.1f);
+        break;
+    }
+}
+
+/// Time the selected implementation of a kernel, returns microseconds per frame.
+static double time_kernel(baseband_kernel_t kernel, uint8_t *iq_buf, uint16_t *y_buf, int16_t *fm_buf, uint32_t block_size, demodfm_state_t *fm_state, unsigned min_ms)
+{
+    run_kernel(kernel, iq_buf, y_buf, fm_buf, block_size, fm_state); // warm up caches
+
+    unsigned long iterations = 0;
+    double us = 0.0;
+    struct timeval start, now, diff;
+    gettimeofday(&start, NULL);
+    do {
+        run_kernel(kernel, iq_buf, y_buf, fm_buf, block_size, fm_state);
+        iterations++;
+        gettimeofday(&now, NULL);
+        timeval_subtract(&diff, &now, &start);
+        us = diff.tv_sec * 1e6 + diff.tv_usec;
+    } while (us < min_ms * 1000.0);
+
+    return us / iterations;
+}
+
+void autotune_run(uint32_t block_size, unsigned min_ms, baseband_impl_t *best)
+{
+    uint8_t *iq_buf = malloc(block_size);
+    if (!iq_buf) {
+        FATAL_MALLOC("autotune_run()");
+    }
+    uint16_t *y_buf = malloc(block_size / 2 * sizeof(*y_buf));
+    if (!y_buf) {
+        FATAL_MALLOC("autotune_run()");
+    }
+    int16_t *fm_buf = malloc(block_size / 2 * sizeof(*fm_buf));
+    if (!fm_buf) {
+        FATAL_MALLOC("autotune_run()");
+    }
+
+    demodfm_state_t fm_state;
+    memset(&fm_state, 0, sizeof(fm_state));
+
+    // noise, the kernels are data independent
+    uint32_t lcg = 433920;
+    for (uint32_t n = 0; n < block_size; ++n) {
+        lcg       = lcg * 1664525 + 1013904223;
+        iq_buf[n] = (uint8_t)(lcg >> 24);
+    }
+
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        double best_us[BASEBAND_IMPL_END] = {0};
+
+        // interleave the rounds so a short disturbance does not favor one implementation
+        for (int round = 0; round < AUTOTUNE_ROUNDS; ++round) {
+            for (int impl = BASEBAND_IMPL_SCALAR; impl < BASEBAND_IMPL_END; ++impl) {
+                if (!baseband_impl_available(impl)) {
+                    continue;
+                }
+                baseband_set_thread_impl(impl);
+                double us = time_kernel(k, iq_buf, y_buf, fm_buf, block_size, &fm_state, min_ms);
+                if (round == 0 || us < best_us[impl]) {
+                    best_us[impl] = us;
+                }
+            }
+        }
+
+        best[k] = BASEBAND_IMPL_SCALAR;
+        for (int impl = BASEBAND_IMPL_SCALAR; impl < BASEBAND_IMPL_END; ++impl) {
+            if (baseband_impl_available(impl) && best_us[impl] < best_us[best[k]]) {
+                best[k] = impl;
+            }
+        }
+        print_logf(LOG_INFO, "Autotune", "Kernel %s: %s (%.1f us per frame, scalar %.1f us)",
+                baseband_kernel_name(k), baseband_impl_name(best[k]), best_us[best[k]], best_us[BASEBAND_IMPL_SCALAR]);
+    }
+    baseband_set_thread_impl(BASEBAND_IMPL_AUTO);
+
+    free(fm_buf);
+    free(y_buf);
+    free(iq_buf);
+}
+
+/// Parse a wisdom line, returns 0 on success.
+static int parse_line(char const *line, uint32_t *block_size, baseband_kernel_t *kernel, baseband_impl_t *impl)
+{
+    char kernel_name[WISDOM_LINE_MAX];
+    char impl_name[WISDOM_LINE_MAX];
+    unsigned size;
+    if (sscanf(line, "%u %127s %127s", &size, kernel_name, impl_name) != 3) {
+        return -1;
+    }
+    *block_size = size;
+
+    *kernel = BASEBAND_KERNEL_END;
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        if (!strcmp(kernel_name, baseband_kernel_name(k))) {
+            *kernel = k;
+        }
+    }
+    *impl = BASEBAND_IMPL_END;
+    for (int i = BASEBAND_IMPL_SCALAR; i < BASEBAND_IMPL_END; ++i) {
+        if (!strcmp(impl_name, baseband_impl_name(i))) {
+            *impl = i;
+        }
+    }
+    return *kernel == BASEBAND_KERNEL_END || *impl == BASEBAND_IMPL_END ? -1 : 0;
+}
+
+int autotune_load(char const *path, uint32_t block_size, baseband_impl_t *best)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        return -1;
+    }
+
+    unsigned found = 0; // bit mask of kernels
+    int stale      = 0;
+    char line[WISDOM_LINE_MAX];
+    while (fgets(line, sizeof(line), fp)) {
+        uint32_t size;
+        baseband_kernel_t kernel;
+        baseband_impl_t impl;
+        if (*line == '#' || parse_line(line, &size, &kernel, &impl) || size != block_size) {
+            continue;
+        }
+        if (!baseband_impl_available(impl)) {
+            stale = 1; // e.g. a wisdom file copied from another machine
+        }
+        best[kernel] = impl;
+        found |= 1u << kernel;
+    }
+    fclose(fp);
+
+    if (stale || found != (1u << BASEBAND_KERNEL_END) - 1) {
+        return -1;
+    }
+    return 0;
+}
+
+int autotune_save(char const *path, uint32_t block_size, baseband_impl_t const *best)
+{
+    // keep the entries for other block sizes
+    char(*kept)[WISDOM_LINE_MAX] = NULL;
+    unsigned n_kept = 0;
+    FILE *fp = fopen(path, "r");
+    if (fp) {
+        kept = malloc(WISDOM_MAX_LINES * sizeof(*kept));
+        if (!kept) {
+            FATAL_MALLOC("autotune_save()");
+        }
+        char line[WISDOM_LINE_MAX];
+        while (n_kept < WISDOM_MAX_LINES && fgets(line, sizeof(line), fp)) {
+            uint32_t size;
+            baseband_kernel_t kernel;
+            baseband_impl_t impl;
+            if (*line != '#' && !parse_line(line, &size, &kernel, &impl) && size != block_size) {
+                snprintf(kept[n_kept++], WISDOM_LINE_MAX, "%u %s %s\n", size, baseband_kernel_name(kernel), baseband_impl_name(impl));
+            }
+        }
+        fclose(fp);
+    }
+
+    fp = fopen(path, "w");
+    if (!fp) {
+        print_logf(LOG_WARNING, "Autotune", "Failed to write wisdom file \"%s\"", path);
+        free(kept);
+        return -1;
+    }
+    fprintf(fp, "# rtl_433 baseband kernel wisdom, delete this file to recalibrate\n");
+    for (unsigned i = 0; i < n_kept; ++i) {
+        fputs(kept[i], fp);
+    }
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        fprintf(fp, "%u %s %s\n", block_size, baseband_kernel_name(k), baseband_impl_name(best[k]));
+    }
+    free(kept);
+    if (fclose(fp)) {
+        print_logf(LOG_WARNING, "Autotune", "Failed to write wisdom file \"%s\"", path);
+        return -1;
+    }
+    return 0;
+}
+
+void autotune_kernels(char const *path, uint32_t block_size)
+{
+    baseband_impl_t best[BASEBAND_KERNEL_END];
+
+    if (autotune_load(path, block_size, best)) {
+        print_logf(LOG_NOTICE, "Autotune", "Calibrating baseband kernels for %u byte frames", block_size);
+        autotune_run(block_size, AUTOTUNE_MIN_MS, best);
+        if (!autotune_save(path, block_size, best)) {
+            print_logf(LOG_INFO, "Autotune", "Saved wisdom to \"%s\"", path);
+        }
+    }
+    else {
+        print_logf(LOG_INFO, "Autotune", "Loaded wisdom for %u byte frames from \"%s\"", block_size, path);
+    }
+
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        baseband_set_kernel_impl(k, best[k]);
+    }
+}
+
+#ifdef _TEST
+#define ASSERT_EQUALS(a, b) \
+    do { \
+        if ((a) == (b)) \
+            ++passed; \
+        else { \
+            ++failed; \
+            fprintf(stderr, "FAIL: %d <> %d\n", (int)(a), (int)(b)); \
+        } \
+    } while (0)
+
+int main(void)
+{
+    unsigned passed = 0;
+    unsigned failed = 0;
+    char const *path = "test_autotune.wisdom";
+    baseband_impl_t best[BASEBAND_KERNEL_END];
+    baseband_impl_t loaded[BASEBAND_KERNEL_END];
+
+    remove(path);
+
+    fprintf(stderr, "autotune::autotune_load(): missing file\n");
+    ASSERT_EQUALS(autotune_load(path, 4096, loaded), -1);
+
+    fprintf(stderr, "autotune::autotune_run(): winners are available\n");
+    autotune_run(4096, 1, best);
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        ASSERT_EQUALS(baseband_impl_available(best[k]), 1);
+    }
+
+    fprintf(stderr, "autotune::autotune_save(): round trip\n");
+    ASSERT_EQUALS(autotune_save(path, 4096, best), 0);
+    ASSERT_EQUALS(autotune_load(path, 4096, loaded), 0);
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        ASSERT_EQUALS(loaded[k], best[k]);
+    }
+    ASSERT_EQUALS(autotune_load(path, 8192, loaded), -1);
+
+    fprintf(stderr, "autotune::autotune_save(): other block sizes are kept\n");
+    baseband_impl_t scalar[BASEBAND_KERNEL_END];
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        scalar[k] = BASEBAND_IMPL_SCALAR;
+    }
+    ASSERT_EQUALS(autotune_save(path, 8192, scalar), 0);
+    ASSERT_EQUALS(autotune_load(path, 4096, loaded), 0);
+    ASSERT_EQUALS(loaded[BASEBAND_KERNEL_ENVELOPE], best[BASEBAND_KERNEL_ENVELOPE]);
+    ASSERT_EQUALS(autotune_load(path, 8192, loaded), 0);
+    ASSERT_EQUALS(loaded[BASEBAND_KERNEL_FM_CU8], BASEBAND_IMPL_SCALAR);
+
+    fprintf(stderr, "autotune::autotune_kernels(): selects the wisdom\n");
+    autotune_kernels(path, 8192);
+    baseband_init();
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        ASSERT_EQUALS(baseband_get_kernel_impl(k), BASEBAND_IMPL_SCALAR);
+    }
+
+    fprintf(stderr, "autotune::autotune_load(): unknown entries are rejected\n");
+    FILE *fp = fopen(path, "w");
+    if (fp) {
+        fprintf(fp, "4096 envelope avx512\n");
+        fclose(fp);
+    }
+    ASSERT_EQUALS(autotune_load(path, 4096, loaded), -1);
+
+    remove(path);
+
+    fprintf(stderr, "autotune:: test (%u passed, %u failed)\n", passed, failed);
+    return failed;
+}
+#endif /* _TEST */
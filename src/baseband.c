@@ -18,51 +18,58 @@
 
 #include "logger.h"
 #include "r_util.h"
+#include "c_util.h"
+#include "compat_atomic.h"
+#include "compat_pthread.h"
 
-static uint16_t scaled_squares[256];
+// SSE2 is baseline on x86-64, AVX2 is compiled per function and selected at runtime.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BASEBAND_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASEBAND_AVX2
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+// NEON is baseline on AArch64 and on ARMv7 builds with -mfpu=neon.
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BASEBAND_NEON
+#include <arm_neon.h>
+#endif
 
-/// precalculate lookup table for envelope detection.
-static void calc_squares(void)
-{
-    if (scaled_squares[0])
-        return; // already initialized
-    int i;
-    for (i = 0; i < 256; i++)
-        scaled_squares[i] = (127 - i) * (127 - i);
-}
+/// Lookup table for envelope detection, constant so concurrent users share no mutable state.
+#define SQ1(i) (uint16_t)((127 - (i)) * (127 - (i)))
+#define SQ4(i) SQ1(i), SQ1((i) + 1), SQ1((i) + 2), SQ1((i) + 3)
+#define SQ16(i) SQ4(i), SQ4((i) + 4), SQ4((i) + 8), SQ4((i) + 12)
+#define SQ64(i) SQ16(i), SQ16((i) + 16), SQ16((i) + 32), SQ16((i) + 48)
+static uint16_t const scaled_squares[256] = {SQ64(0), SQ64(64), SQ64(128), SQ64(192)};
 
-// This will give a noisy envelope of OOK/ASK signals.
-// Subtract the bias (-128) and get an envelope estimation.
-float envelope_detect(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
-{
-    unsigned long i;
-    uint32_t sum = 0;
-    for (i = 0; i < len; i++) {
-        y_buf[i] = scaled_squares[iq_buf[2 * i ]] + scaled_squares[iq_buf[2 * i + 1]];
-        sum += y_buf[i];
-    }
-    return len > 0 && sum >= len ? AMP_TO_DB((float)sum / len) : AMP_TO_DB(1);
-}
+/*
+All kernels below return the (wrapping) uint32 sum of the output samples,
+the exported functions convert that sum to an average level in dB.
+The SIMD variants must give results bit-identical to the scalar reference,
+they process whole vectors and leave the tail to the scalar reference.
+*/
 
-/// This will give a noisy envelope of OOK/ASK signals.
-/// Subtracts the bias (-128) and calculates the norm (scaled by 16384).
-/// Using a LUT is slower for O1 and above.
-float envelope_detect_nolut(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+typedef uint32_t (*kernel_cu8_fn)(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len);
+typedef uint32_t (*kernel_cs16_fn)(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len);
+typedef void (*kernel_fm_fn)(uint8_t const *x_buf, int16_t *y_buf, uint32_t len, int fast_atan);
+typedef void (*convert_cs8_fn)(uint8_t *buf, uint32_t len);
+typedef void (*convert_cf32_fn)(float const *in, int16_t *out, uint32_t len);
+
+static uint32_t envelope_scalar(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
 {
     unsigned long i;
     uint32_t sum = 0;
     for (i = 0; i < len; i++) {
-        int16_t x = 127 - iq_buf[2 * i];
-        int16_t y = 127 - iq_buf[2 * i + 1];
-        y_buf[i]  = x * x + y * y; // max 32768, fs 16384
+        y_buf[i] = scaled_squares[iq_buf[2 * i ]] + scaled_squares[iq_buf[2 * i + 1]];
         sum += y_buf[i];
     }
-    return len > 0 && sum >= len ? AMP_TO_DB((float)sum / len) : AMP_TO_DB(1);
+    return sum;
 }
 
-/// 122/128, 51/128 Magnitude Estimator for CU8 (SIMD has min/max).
-/// Note that magnitude emphasizes quiet signals / deemphasizes loud signals.
-float magnitude_est_cu8(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+static uint32_t magnitude_est_cu8_scalar(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
 {
     unsigned long i;
     uint32_t sum = 0;
@@ -75,11 +82,10 @@ float magnitude_est_cu8(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
         y_buf[i] = mag_est; // max 22144, fs 16384
         sum += y_buf[i];
     }
-    return len > 0 && sum >= len ? MAG_TO_DB((float)sum / len) : MAG_TO_DB(1);
+    return sum;
 }
 
-/// True Magnitude for CU8 (sqrt can SIMD but float is slow).
-float magnitude_true_cu8(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+static uint32_t magnitude_true_cu8_scalar(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
 {
     unsigned long i;
     uint32_t sum = 0;
@@ -89,11 +95,10 @@ float magnitude_true_cu8(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
         y_buf[i]  = (uint16_t)(sqrtf((float)(x * x + y * y)) * 128.0f); // max 181, scaled 23170, fs 16384
         sum += y_buf[i];
     }
-    return len > 0 && sum >= len ? MAG_TO_DB((float)sum / len) : MAG_TO_DB(1);
+    return sum;
 }
 
-/// 122/128, 51/128 Magnitude Estimator for CS16 (SIMD has min/max).
-float magnitude_est_cs16(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+static uint32_t magnitude_est_cs16_scalar(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
 {
     unsigned long i;
     uint32_t sum = 0;
@@ -106,11 +111,10 @@ float magnitude_est_cs16(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
         y_buf[i] = mag_est >> 8; // max 5668864, scaled 22144, fs 16384
         sum += y_buf[i];
     }
-    return len > 0 && sum >= len ? MAG_TO_DB((float)sum / len) : MAG_TO_DB(1);
+    return sum;
 }
 
-/// True Magnitude for CS16 (sqrt can SIMD but float is slow).
-float magnitude_true_cs16(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+static uint32_t magnitude_true_cs16_scalar(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
 {
     unsigned long i;
     uint32_t sum = 0;
@@ -120,9 +124,1062 @@ float magnitude_true_cs16(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
         y_buf[i]  = (int)sqrtf((float)(x * x + y * y)) >> 1; // max 46341, scaled 23170, fs 16384
         sum += y_buf[i];
     }
+    return sum;
+}
+
+#ifdef BASEBAND_SSE2
+static inline uint32_t hsum_epi32_sse2(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+/// Swap each I/Q pair of 16 bit lanes.
+static inline __m128i swap_iq_sse2(__m128i v)
+{
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static uint32_t envelope_sse2(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m128i const zero  = _mm_setzero_si128();
+    __m128i const bias  = _mm_set1_epi16(127);
+    __m128i const ubias = _mm_set1_epi32(32768);
+    __m128i const uflip = _mm_set1_epi16((short)0x8000);
+    __m128i acc         = zero;
+    uint32_t n          = 0;
+    for (; n + 8 <= len; n += 8) {
+        __m128i v  = _mm_loadu_si128((__m128i const *)&iq_buf[2 * n]);
+        __m128i lo = _mm_sub_epi16(bias, _mm_unpacklo_epi8(v, zero));
+        __m128i hi = _mm_sub_epi16(bias, _mm_unpackhi_epi8(v, zero));
+        __m128i el = _mm_madd_epi16(lo, lo); // I*I + Q*Q, max 32768
+        __m128i eh = _mm_madd_epi16(hi, hi);
+        acc        = _mm_add_epi32(acc, _mm_add_epi32(el, eh));
+        // unsigned pack using the signed saturating pack
+        __m128i y = _mm_packs_epi32(_mm_sub_epi32(el, ubias), _mm_sub_epi32(eh, ubias));
+        _mm_storeu_si128((__m128i *)&y_buf[n], _mm_xor_si128(y, uflip));
+    }
+    return hsum_epi32_sse2(acc) + envelope_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+
+/// 122*max + 51*min of |I|,|Q| for 4 CU8 samples.
+static inline __m128i mag_est_cu8_sse2(__m128i v)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const even = _mm_set1_epi32(0x0000ffff);
+    __m128i const coef = _mm_set_epi16(51, 122, 51, 122, 51, 122, 51, 122);
+    __m128i a  = _mm_max_epi16(v, _mm_sub_epi16(zero, v));
+    __m128i s  = swap_iq_sse2(a);
+    __m128i mx = _mm_max_epi16(a, s);
+    __m128i mi = _mm_min_epi16(a, s);
+    __m128i t  = _mm_or_si128(_mm_and_si128(even, mx), _mm_andnot_si128(even, mi));
+    return _mm_madd_epi16(t, coef); // max 22144
+}
+
+static uint32_t magnitude_est_cu8_sse2(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const bias = _mm_set1_epi16(128);
+    __m128i acc        = zero;
+    uint32_t n         = 0;
+    for (; n + 8 <= len; n += 8) {
+        __m128i v  = _mm_loadu_si128((__m128i const *)&iq_buf[2 * n]);
+        __m128i ml = mag_est_cu8_sse2(_mm_sub_epi16(_mm_unpacklo_epi8(v, zero), bias));
+        __m128i mh = mag_est_cu8_sse2(_mm_sub_epi16(_mm_unpackhi_epi8(v, zero), bias));
+        acc        = _mm_add_epi32(acc, _mm_add_epi32(ml, mh));
+        _mm_storeu_si128((__m128i *)&y_buf[n], _mm_packs_epi32(ml, mh));
+    }
+    return hsum_epi32_sse2(acc) + magnitude_est_cu8_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+
+/// sqrt(I*I + Q*Q) * 128 for 4 CU8 samples.
+static inline __m128i mag_true_cu8_sse2(__m128i v)
+{
+    __m128 f = _mm_cvtepi32_ps(_mm_madd_epi16(v, v));
+    return _mm_cvttps_epi32(_mm_mul_ps(_mm_sqrt_ps(f), _mm_set1_ps(128.0f))); // max 23170
+}
+
+static uint32_t magnitude_true_cu8_sse2(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const bias = _mm_set1_epi16(128);
+    __m128i acc        = zero;
+    uint32_t n         = 0;
+    for (; n + 8 <= len; n += 8) {
+        __m128i v  = _mm_loadu_si128((__m128i const *)&iq_buf[2 * n]);
+        __m128i ml = mag_true_cu8_sse2(_mm_sub_epi16(_mm_unpacklo_epi8(v, zero), bias));
+        __m128i mh = mag_true_cu8_sse2(_mm_sub_epi16(_mm_unpackhi_epi8(v, zero), bias));
+        acc        = _mm_add_epi32(acc, _mm_add_epi32(ml, mh));
+        _mm_storeu_si128((__m128i *)&y_buf[n], _mm_packs_epi32(ml, mh));
+    }
+    return hsum_epi32_sse2(acc) + magnitude_true_cu8_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+
+/// (122*max + 51*min of |I|,|Q|) >> 8 for 4 CS16 samples.
+static inline __m128i mag_est_cs16_sse2(__m128i v)
+{
+    __m128i const even  = _mm_set1_epi32(0x0000ffff);
+    __m128i const coef  = _mm_set_epi16(51, 122, 51, 122, 51, 122, 51, 122);
+    __m128i const uflip = _mm_set1_epi16((short)0x8000);
+    __m128i sign = _mm_srai_epi16(v, 15);
+    __m128i a    = _mm_sub_epi16(_mm_xor_si128(v, sign), sign); // unsigned abs, max 32768
+    __m128i af   = _mm_xor_si128(a, uflip);                     // unsigned compare using signed min/max
+    __m128i sf   = swap_iq_sse2(af);
+    __m128i mx   = _mm_xor_si128(_mm_max_epi16(af, sf), uflip);
+    __m128i mi   = _mm_xor_si128(_mm_min_epi16(af, sf), uflip);
+    __m128i t    = _mm_or_si128(_mm_and_si128(even, mx), _mm_andnot_si128(even, mi));
+    __m128i pl   = _mm_mullo_epi16(t, coef);
+    __m128i ph   = _mm_mulhi_epu16(t, coef);
+    __m128i p0   = _mm_unpacklo_epi16(pl, ph); // 32 bit products, samples 0-1
+    __m128i p1   = _mm_unpackhi_epi16(pl, ph); // 32 bit products, samples 2-3
+    p0           = _mm_add_epi32(p0, _mm_srli_epi64(p0, 32));
+    p1           = _mm_add_epi32(p1, _mm_srli_epi64(p1, 32));
+    __m128i m    = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(p0), _mm_castsi128_ps(p1), _MM_SHUFFLE(2, 0, 2, 0)));
+    return _mm_srli_epi32(m, 8); // max 22144
+}
+
+static uint32_t magnitude_est_cs16_sse2(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m128i acc = _mm_setzero_si128();
+    uint32_t n  = 0;
+    for (; n + 8 <= len; n += 8) {
+        __m128i ml = mag_est_cs16_sse2(_mm_loadu_si128((__m128i const *)&iq_buf[2 * n]));
+        __m128i mh = mag_est_cs16_sse2(_mm_loadu_si128((__m128i const *)&iq_buf[2 * n + 8]));
+        acc        = _mm_add_epi32(acc, _mm_add_epi32(ml, mh));
+        _mm_storeu_si128((__m128i *)&y_buf[n], _mm_packs_epi32(ml, mh));
+    }
+    return hsum_epi32_sse2(acc) + magnitude_est_cs16_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+
+/// sqrt(I*I + Q*Q) / 2 for 4 CS16 samples, truncated to 16 bit like the scalar store.
+static inline __m128i mag_true_cs16_sse2(__m128i v)
+{
+    __m128 f  = _mm_cvtepi32_ps(_mm_madd_epi16(v, v));
+    __m128i m = _mm_srai_epi32(_mm_cvttps_epi32(_mm_sqrt_ps(f)), 1);
+    return _mm_srai_epi32(_mm_slli_epi32(m, 16), 16);
+}
+
+static uint32_t magnitude_true_cs16_sse2(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m128i const low16 = _mm_set1_epi32(0x0000ffff);
+    __m128i acc         = _mm_setzero_si128();
+    uint32_t n          = 0;
+    for (; n + 8 <= len; n += 8) {
+        __m128i ml = mag_true_cs16_sse2(_mm_loadu_si128((__m128i const *)&iq_buf[2 * n]));
+        __m128i mh = mag_true_cs16_sse2(_mm_loadu_si128((__m128i const *)&iq_buf[2 * n + 8]));
+        acc        = _mm_add_epi32(acc, _mm_add_epi32(_mm_and_si128(ml, low16), _mm_and_si128(mh, low16)));
+        _mm_storeu_si128((__m128i *)&y_buf[n], _mm_packs_epi32(ml, mh));
+    }
+    return hsum_epi32_sse2(acc) + magnitude_true_cs16_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+#endif /* BASEBAND_SSE2 */
+
+#ifdef BASEBAND_AVX2
+// The in-lane unpack of CU8 and the in-lane pack cancel out, only CS16 needs a lane permute.
+
+TARGET_AVX2
+static inline uint32_t hsum_epi32_avx2(__m256i v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(s);
+}
+
+TARGET_AVX2
+static inline __m256i swap_iq_avx2(__m256i v)
+{
+    v = _mm256_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+TARGET_AVX2
+static uint32_t envelope_avx2(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const bias = _mm256_set1_epi16(127);
+    __m256i acc        = zero;
+    uint32_t n         = 0;
+    for (; n + 16 <= len; n += 16) {
+        __m256i v  = _mm256_loadu_si256((__m256i const *)&iq_buf[2 * n]);
+        __m256i lo = _mm256_sub_epi16(bias, _mm256_unpacklo_epi8(v, zero));
+        __m256i hi = _mm256_sub_epi16(bias, _mm256_unpackhi_epi8(v, zero));
+        __m256i el = _mm256_madd_epi16(lo, lo); // I*I + Q*Q, max 32768
+        __m256i eh = _mm256_madd_epi16(hi, hi);
+        acc        = _mm256_add_epi32(acc, _mm256_add_epi32(el, eh));
+        _mm256_storeu_si256((__m256i *)&y_buf[n], _mm256_packus_epi32(el, eh));
+    }
+    return hsum_epi32_avx2(acc) + envelope_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+
+TARGET_AVX2
+static inline __m256i mag_est_cu8_avx2(__m256i v)
+{
+    __m256i const even = _mm256_set1_epi32(0x0000ffff);
+    __m256i const coef = _mm256_set1_epi32((51 << 16) | 122);
+    __m256i a  = _mm256_abs_epi16(v);
+    __m256i s  = swap_iq_avx2(a);
+    __m256i t  = _mm256_blendv_epi8(_mm256_min_epi16(a, s), _mm256_max_epi16(a, s), even);
+    return _mm256_madd_epi16(t, coef); // max 22144
+}
+
+TARGET_AVX2
+static uint32_t magnitude_est_cu8_avx2(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const bias = _mm256_set1_epi16(128);
+    __m256i acc        = zero;
+    uint32_t n         = 0;
+    for (; n + 16 <= len; n += 16) {
+        __m256i v  = _mm256_loadu_si256((__m256i const *)&iq_buf[2 * n]);
+        __m256i ml = mag_est_cu8_avx2(_mm256_sub_epi16(_mm256_unpacklo_epi8(v, zero), bias));
+        __m256i mh = mag_est_cu8_avx2(_mm256_sub_epi16(_mm256_unpackhi_epi8(v, zero), bias));
+        acc        = _mm256_add_epi32(acc, _mm256_add_epi32(ml, mh));
+        _mm256_storeu_si256((__m256i *)&y_buf[n], _mm256_packs_epi32(ml, mh));
+    }
+    return hsum_epi32_avx2(acc) + magnitude_est_cu8_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+
+TARGET_AVX2
+static inline __m256i mag_true_cu8_avx2(__m256i v)
+{
+    __m256 f = _mm256_cvtepi32_ps(_mm256_madd_epi16(v, v));
+    return _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_sqrt_ps(f), _mm256_set1_ps(128.0f))); // max 23170
+}
+
+TARGET_AVX2
+static uint32_t magnitude_true_cu8_avx2(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const bias = _mm256_set1_epi16(128);
+    __m256i acc        = zero;
+    uint32_t n         = 0;
+    for (; n + 16 <= len; n += 16) {
+        __m256i v  = _mm256_loadu_si256((__m256i const *)&iq_buf[2 * n]);
+        __m256i ml = mag_true_cu8_avx2(_mm256_sub_epi16(_mm256_unpacklo_epi8(v, zero), bias));
+        __m256i mh = mag_true_cu8_avx2(_mm256_sub_epi16(_mm256_unpackhi_epi8(v, zero), bias));
+        acc        = _mm256_add_epi32(acc, _mm256_add_epi32(ml, mh));
+        _mm256_storeu_si256((__m256i *)&y_buf[n], _mm256_packs_epi32(ml, mh));
+    }
+    return hsum_epi32_avx2(acc) + magnitude_true_cu8_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+
+TARGET_AVX2
+static inline __m256i mag_est_cs16_avx2(__m256i v)
+{
+    __m256i const even = _mm256_set1_epi32(0x0000ffff);
+    __m256i const coef = _mm256_set1_epi32((51 << 16) | 122);
+    __m256i a  = _mm256_abs_epi16(v); // unsigned abs, max 32768
+    __m256i s  = swap_iq_avx2(a);
+    __m256i t  = _mm256_blendv_epi8(_mm256_min_epu16(a, s), _mm256_max_epu16(a, s), even);
+    __m256i pl = _mm256_mullo_epi16(t, coef);
+    __m256i ph = _mm256_mulhi_epu16(t, coef);
+    __m256i p0 = _mm256_unpacklo_epi16(pl, ph); // 32 bit products
+    __m256i p1 = _mm256_unpackhi_epi16(pl, ph);
+    p0         = _mm256_add_epi32(p0, _mm256_srli_epi64(p0, 32));
+    p1         = _mm256_add_epi32(p1, _mm256_srli_epi64(p1, 32));
+    __m256i m  = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(p0), _mm256_castsi256_ps(p1), _MM_SHUFFLE(2, 0, 2, 0)));
+    return _mm256_srli_epi32(m, 8); // max 22144
+}
+
+TARGET_AVX2
+static uint32_t magnitude_est_cs16_avx2(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m256i acc = _mm256_setzero_si256();
+    uint32_t n  = 0;
+    for (; n + 16 <= len; n += 16) {
+        __m256i ml = mag_est_cs16_avx2(_mm256_loadu_si256((__m256i const *)&iq_buf[2 * n]));
+        __m256i mh = mag_est_cs16_avx2(_mm256_loadu_si256((__m256i const *)&iq_buf[2 * n + 16]));
+        acc        = _mm256_add_epi32(acc, _mm256_add_epi32(ml, mh));
+        __m256i y  = _mm256_permute4x64_epi64(_mm256_packs_epi32(ml, mh), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)&y_buf[n], y);
+    }
+    return hsum_epi32_avx2(acc) + magnitude_est_cs16_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+
+TARGET_AVX2
+static inline __m256i mag_true_cs16_avx2(__m256i v)
+{
+    __m256 f  = _mm256_cvtepi32_ps(_mm256_madd_epi16(v, v));
+    __m256i m = _mm256_srai_epi32(_mm256_cvttps_epi32(_mm256_sqrt_ps(f)), 1);
+    return _mm256_srai_epi32(_mm256_slli_epi32(m, 16), 16);
+}
+
+TARGET_AVX2
+static uint32_t magnitude_true_cs16_avx2(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    __m256i const low16 = _mm256_set1_epi32(0x0000ffff);
+    __m256i acc         = _mm256_setzero_si256();
+    uint32_t n          = 0;
+    for (; n + 16 <= len; n += 16) {
+        __m256i ml = mag_true_cs16_avx2(_mm256_loadu_si256((__m256i const *)&iq_buf[2 * n]));
+        __m256i mh = mag_true_cs16_avx2(_mm256_loadu_si256((__m256i const *)&iq_buf[2 * n + 16]));
+        acc        = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_and_si256(ml, low16), _mm256_and_si256(mh, low16)));
+        __m256i y  = _mm256_permute4x64_epi64(_mm256_packs_epi32(ml, mh), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)&y_buf[n], y);
+    }
+    return hsum_epi32_avx2(acc) + magnitude_true_cs16_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+#endif /* BASEBAND_AVX2 */
+
+#ifdef BASEBAND_NEON
+static inline uint32_t hsum_u32_neon(uint32x4_t v)
+{
+    return vgetq_lane_u32(v, 0) + vgetq_lane_u32(v, 1) + vgetq_lane_u32(v, 2) + vgetq_lane_u32(v, 3);
+}
+
+static uint32_t envelope_neon(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    int16x8_t const bias = vdupq_n_s16(127);
+    uint32x4_t acc       = vdupq_n_u32(0);
+    uint32_t n           = 0;
+    for (; n + 8 <= len; n += 8) {
+        uint8x8x2_t v = vld2_u8(&iq_buf[2 * n]); // deinterleave I and Q
+        int16x8_t x   = vsubq_s16(bias, vreinterpretq_s16_u16(vmovl_u8(v.val[0])));
+        int16x8_t y   = vsubq_s16(bias, vreinterpretq_s16_u16(vmovl_u8(v.val[1])));
+        // max 32768, wraps in int16 but is exact as uint16
+        uint16x8_t e = vreinterpretq_u16_s16(vmlaq_s16(vmulq_s16(x, x), y, y));
+        vst1q_u16(&y_buf[n], e);
+        acc = vpadalq_u16(acc, e);
+    }
+    return hsum_u32_neon(acc) + envelope_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+
+static uint32_t magnitude_est_cu8_neon(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    uint8x8_t const bias = vdup_n_u8(128);
+    uint32x4_t acc       = vdupq_n_u32(0);
+    uint32_t n           = 0;
+    for (; n + 8 <= len; n += 8) {
+        uint8x8x2_t v = vld2_u8(&iq_buf[2 * n]); // deinterleave I and Q
+        uint16x8_t x  = vabdl_u8(v.val[0], bias);
+        uint16x8_t y  = vabdl_u8(v.val[1], bias);
+        uint16x8_t m  = vmlaq_n_u16(vmulq_n_u16(vmaxq_u16(x, y), 122), vminq_u16(x, y), 51);
+        vst1q_u16(&y_buf[n], m);
+        acc = vpadalq_u16(acc, m);
+    }
+    return hsum_u32_neon(acc) + magnitude_est_cu8_scalar(&iq_buf[2 * n], &y_buf[n], len - n);
+}
+#endif /* BASEBAND_NEON */
+
+/** Integer implementation of atan2() with int16_t normalized output.
+
+    Returns arc tangent of y/x across all quadrants in radians.
+    Error max 0.07 radians.
+    Reference: http://dspguru.com/dsp/tricks/fixed-point-atan2-with-self-normalization
+
+    Written without branches and with the truncating integer division done in double,
+    which is exact for this range, so a loop over a block can be vectorized.
+    @param y Numerator (imaginary value of complex vector)
+    @param x Denominator (real value of complex vector)
+    @return angle in radians (Pi equals INT16_MAX)
+*/
+static inline int16_t atan2_int16(int32_t y, int32_t x)
+{
+    int32_t const I_PI_4   = INT16_MAX / 4;     // M_PI/4
+    int32_t const I_3_PI_4 = 3 * INT16_MAX / 4; // 3*M_PI/4
+
+    int32_t const abs_y = y < 0 ? -y : y;
+    // Quadrant I and IV, or Quadrant II and III
+    int32_t const num   = x >= 0 ? x - abs_y : x + abs_y;
+    int32_t const denom = x >= 0 ? abs_y + x : abs_y - x;
+
+    int32_t angle = (x >= 0 ? I_PI_4 : I_3_PI_4) - (int32_t)((double)(I_PI_4 * num) / (denom ? denom : 1));
+    angle = y < 0 ? -angle : angle; // Negate if in III or IV
+    return denom ? angle : 0; // We would get 8191 for x = y = 0
+}
+
+/** Polynomial approximation of atan2() normalized to Pi.
+
+    Error max 0.0038 radians, branchless float code to allow vectorization.
+    @param y Numerator (imaginary value of complex vector)
+    @param x Denominator (real value of complex vector)
+    @return angle in units of Pi (-1.0 to 1.0)
+*/
+static inline float atan2_poly(float y, float x)
+{
+    float const abs_x = fabsf(x);
+    float const abs_y = fabsf(y);
+    float const mx    = abs_x > abs_y ? abs_x : abs_y;
+    float const mn    = abs_x > abs_y ? abs_y : abs_x;
+    float const z     = mn / (mx > 0.0f ? mx : 1.0f); // 0 to 1
+    // atan(z) = z * (M_PI/4 + 0.273 * (1 - z)), here divided by M_PI
+    float angle = z * (0.25f + 0.0869f * (1.0f - z));
+    angle = abs_y > abs_x ? 0.5f - angle : angle;
+    angle = x < 0.0f ? 1.0f - angle : angle;
+    return y < 0.0f ? -angle : angle;
+}
+
+/// Instantaneous frequency of CU8 samples, y_buf[n] from x[n+1] * conj(x[n]), x_buf holds len + 1 samples.
+static void fm_phase_cu8_scalar(uint8_t const *x_buf, int16_t *y_buf, uint32_t len, int fast_atan)
+{
+    // Calculate phase difference vector: x[n] * conj(x[n-1])
+    // pr = x0r * x1r + x0i * x1i; // May exactly overflow an int16_t (-128*-128 + -128*-128)
+    // pi = x0i * x1r - x0r * x1i;
+    if (fast_atan) {
+        for (unsigned long n = 0; n < len; n++) {
+            int32_t x1r = x_buf[2 * n] - 128;
+            int32_t x1i = x_buf[2 * n + 1] - 128;
+            int32_t x0r = x_buf[2 * n + 2] - 128;
+            int32_t x0i = x_buf[2 * n + 3] - 128;
+            y_buf[n]    = (int16_t)(atan2_poly((float)(x0i * x1r - x0r * x1i), (float)(x0r * x1r + x0i * x1i)) * INT16_MAX);
+        }
+    }
+    else {
+        for (unsigned long n = 0; n < len; n++) {
+            int32_t x1r = x_buf[2 * n] - 128;
+            int32_t x1i = x_buf[2 * n + 1] - 128;
+            int32_t x0r = x_buf[2 * n + 2] - 128;
+            int32_t x0i = x_buf[2 * n + 3] - 128;
+            y_buf[n]    = atan2_int16(x0i * x1r - x0r * x1i, x0r * x1r + x0i * x1i);
+        }
+    }
+}
+
+#ifdef BASEBAND_SSE2
+static inline __m128i select_si128(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// atan2_int16() for 4 samples.
+static inline __m128i atan2_int16_sse2(__m128i y, __m128i x)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128d const pi_4 = _mm_set1_pd(INT16_MAX / 4);
+    __m128i sy    = _mm_srai_epi32(y, 31);
+    __m128i sx    = _mm_srai_epi32(x, 31);
+    __m128i abs_y = _mm_sub_epi32(_mm_xor_si128(y, sy), sy);
+    __m128i abs_x = _mm_sub_epi32(_mm_xor_si128(x, sx), sx);
+    // x >= 0: num = x - abs_y, denom = abs_y + x; x < 0: num = x + abs_y, denom = abs_y - x
+    __m128i nsx   = _mm_xor_si128(sx, _mm_set1_epi32(-1)); // no vector operators, for MSVC
+    __m128i num   = _mm_add_epi32(x, _mm_sub_epi32(_mm_xor_si128(abs_y, nsx), nsx));
+    __m128i denom = _mm_add_epi32(abs_y, abs_x);
+    __m128i dzero = _mm_cmpeq_epi32(denom, zero);
+    __m128i den   = _mm_or_si128(denom, _mm_and_si128(dzero, _mm_set1_epi32(1)));
+    // truncating division in double, exact for this range
+    __m128d q_lo  = _mm_div_pd(_mm_mul_pd(_mm_cvtepi32_pd(num), pi_4), _mm_cvtepi32_pd(den));
+    __m128d q_hi  = _mm_div_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(num, num)), pi_4),
+            _mm_cvtepi32_pd(_mm_unpackhi_epi64(den, den)));
+    __m128i q     = _mm_unpacklo_epi64(_mm_cvttpd_epi32(q_lo), _mm_cvttpd_epi32(q_hi));
+    __m128i base  = select_si128(sx, _mm_set1_epi32(3 * INT16_MAX / 4), _mm_set1_epi32(INT16_MAX / 4));
+    __m128i angle = _mm_sub_epi32(base, q);
+    angle         = _mm_sub_epi32(_mm_xor_si128(angle, sy), sy);
+    return _mm_andnot_si128(dzero, angle);
+}
+
+/// atan2_poly() * INT16_MAX for 4 samples.
+static inline __m128i atan2_poly_sse2(__m128i yi, __m128i xi)
+{
+    __m128 const zero  = _mm_setzero_ps();
+    __m128 const one   = _mm_set1_ps(1.0f);
+    __m128 const sign  = _mm_set1_ps(-0.0f);
+    __m128 y     = _mm_cvtepi32_ps(yi);
+    __m128 x     = _mm_cvtepi32_ps(xi);
+    __m128 abs_x = _mm_andnot_ps(sign, x);
+    __m128 abs_y = _mm_andnot_ps(sign, y);
+    __m128 gt    = _mm_cmpgt_ps(abs_x, abs_y);
+    __m128 mx    = select_ps(gt, abs_x, abs_y);
+    __m128 mn    = select_ps(gt, abs_y, abs_x);
+    __m128 z     = _mm_div_ps(mn, select_ps(_mm_cmpgt_ps(mx, zero), mx, one));
+    __m128 angle = _mm_mul_ps(z, _mm_add_ps(_mm_set1_ps(0.25f), _mm_mul_ps(_mm_set1_ps(0.0869f), _mm_sub_ps(one, z))));
+    angle        = select_ps(_mm_cmpgt_ps(abs_y, abs_x), _mm_sub_ps(_mm_set1_ps(0.5f), angle), angle);
+    angle        = select_ps(_mm_cmplt_ps(x, zero), _mm_sub_ps(one, angle), angle);
+    angle        = select_ps(_mm_cmplt_ps(y, zero), _mm_xor_ps(sign, angle), angle);
+    return _mm_cvttps_epi32(_mm_mul_ps(angle, _mm_set1_ps(INT16_MAX)));
+}
+
+static void fm_phase_cu8_sse2(uint8_t const *x_buf, int16_t *y_buf, uint32_t len, int fast_atan)
+{
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const bias = _mm_set1_epi16(128);
+    __m128i const neg  = _mm_set1_epi32(0x0000ffff); // negate the I lanes
+    uint32_t n         = 0;
+    for (; n + 8 <= len; n += 8) {
+        __m128i v1 = _mm_loadu_si128((__m128i const *)&x_buf[2 * n]);     // x[n-1]
+        __m128i v0 = _mm_loadu_si128((__m128i const *)&x_buf[2 * n + 2]); // x[n]
+        __m128i y[2];
+        for (int h = 0; h < 2; ++h) {
+            __m128i x1 = _mm_sub_epi16(h ? _mm_unpackhi_epi8(v1, zero) : _mm_unpacklo_epi8(v1, zero), bias);
+            __m128i x0 = _mm_sub_epi16(h ? _mm_unpackhi_epi8(v0, zero) : _mm_unpacklo_epi8(v0, zero), bias);
+            __m128i xc = _mm_sub_epi16(_mm_xor_si128(swap_iq_sse2(x1), neg), neg); // -x1i, x1r
+            __m128i pr = _mm_madd_epi16(x0, x1);
+            __m128i pi = _mm_madd_epi16(x0, xc);
+            y[h]       = fast_atan ? atan2_poly_sse2(pi, pr) : atan2_int16_sse2(pi, pr);
+        }
+        _mm_storeu_si128((__m128i *)&y_buf[n], _mm_packs_epi32(y[0], y[1]));
+    }
+    fm_phase_cu8_scalar(&x_buf[2 * n], &y_buf[n], len - n, fast_atan);
+}
+#endif /* BASEBAND_SSE2 */
+
+/*
+Input format converters, in place capable: the output never overtakes the input.
+*/
+
+/// CS8 to CU8, adding the bias is flipping the sign bit.
+static void convert_cs8_cu8_scalar(uint8_t *buf, uint32_t len)
+{
+    for (uint32_t n = 0; n < len; ++n) {
+        buf[n] ^= 0x80;
+    }
+}
+
+/// CF32 to CS16, clamped to [-1,1] and scaled to Q0.15, truncating. NaN gives the negative limit.
+static void convert_cf32_cs16_scalar(float const *in, int16_t *out, uint32_t len)
+{
+    for (uint32_t n = 0; n < len; ++n) {
+        float x = in[n] * INT16_MAX;
+        if (!(x > -INT16_MAX)) {
+            x = -INT16_MAX;
+        }
+        else if (x > INT16_MAX) {
+            x = INT16_MAX;
+        }
+        out[n] = (int16_t)x;
+    }
+}
+
+#ifdef BASEBAND_SSE2
+static void convert_cs8_cu8_sse2(uint8_t *buf, uint32_t len)
+{
+    __m128i const sign = _mm_set1_epi8((char)0x80);
+    uint32_t n         = 0;
+    for (; n + 16 <= len; n += 16) {
+        __m128i v = _mm_loadu_si128((__m128i const *)&buf[n]);
+        _mm_storeu_si128((__m128i *)&buf[n], _mm_xor_si128(v, sign));
+    }
+    convert_cs8_cu8_scalar(&buf[n], len - n);
+}
+
+static void convert_cf32_cs16_sse2(float const *in, int16_t *out, uint32_t len)
+{
+    __m128 const scale = _mm_set1_ps(INT16_MAX);
+    __m128 const lo    = _mm_set1_ps(-INT16_MAX);
+    __m128 const hi    = _mm_set1_ps(INT16_MAX);
+    uint32_t n         = 0;
+    for (; n + 8 <= len; n += 8) {
+        // max() returns the second operand for NaN, like the scalar clamp
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&in[n]), scale), lo), hi);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&in[n + 4]), scale), lo), hi);
+        _mm_storeu_si128((__m128i *)&out[n], _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+    }
+    convert_cf32_cs16_scalar(&in[n], &out[n], len - n);
+}
+#endif /* BASEBAND_SSE2 */
+
+#ifdef BASEBAND_AVX2
+TARGET_AVX2
+static void convert_cs8_cu8_avx2(uint8_t *buf, uint32_t len)
+{
+    __m256i const sign = _mm256_set1_epi8((char)0x80);
+    uint32_t n         = 0;
+    for (; n + 32 <= len; n += 32) {
+        __m256i v = _mm256_loadu_si256((__m256i const *)&buf[n]);
+        _mm256_storeu_si256((__m256i *)&buf[n], _mm256_xor_si256(v, sign));
+    }
+    convert_cs8_cu8_scalar(&buf[n], len - n);
+}
+
+TARGET_AVX2
+static void convert_cf32_cs16_avx2(float const *in, int16_t *out, uint32_t len)
+{
+    __m256 const scale = _mm256_set1_ps(INT16_MAX);
+    __m256 const lo    = _mm256_set1_ps(-INT16_MAX);
+    __m256 const hi    = _mm256_set1_ps(INT16_MAX);
+    uint32_t n         = 0;
+    for (; n + 16 <= len; n += 16) {
+        // max() returns the second operand for NaN, like the scalar clamp
+        __m256 a  = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(&in[n]), scale), lo), hi);
+        __m256 b  = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(&in[n + 8]), scale), lo), hi);
+        __m256i y = _mm256_packs_epi32(_mm256_cvttps_epi32(a), _mm256_cvttps_epi32(b));
+        // both loads are read before the store, so in place conversion is safe
+        _mm256_storeu_si256((__m256i *)&out[n], _mm256_permute4x64_epi64(y, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    convert_cf32_cs16_scalar(&in[n], &out[n], len - n);
+}
+#endif /* BASEBAND_AVX2 */
+
+#ifdef BASEBAND_NEON
+static void convert_cs8_cu8_neon(uint8_t *buf, uint32_t len)
+{
+    uint8x16_t const sign = vdupq_n_u8(0x80);
+    uint32_t n            = 0;
+    for (; n + 16 <= len; n += 16) {
+        vst1q_u8(&buf[n], veorq_u8(vld1q_u8(&buf[n]), sign));
+    }
+    convert_cs8_cu8_scalar(&buf[n], len - n);
+}
+#endif /* BASEBAND_NEON */
+
+/*
+Threshold search of the pulse detector, the index of the first sample above a level or len if none.
+The SIMD variants test whole vectors and locate the sample with the scalar reference.
+*/
+
+typedef uint32_t (*find_above_fn)(int16_t const *buf, uint32_t len, int16_t level);
+
+static uint32_t find_above_scalar(int16_t const *buf, uint32_t len, int16_t level)
+{
+    uint32_t n = 0;
+    while (n < len && buf[n] <= level) {
+        n++;
+    }
+    return n;
+}
+
+#ifdef BASEBAND_SSE2
+static uint32_t find_above_sse2(int16_t const *buf, uint32_t len, int16_t level)
+{
+    __m128i const lvl = _mm_set1_epi16(level);
+    uint32_t n        = 0;
+    for (; n + 16 <= len; n += 16) {
+        __m128i a = _mm_cmpgt_epi16(_mm_loadu_si128((__m128i const *)&buf[n]), lvl);
+        __m128i b = _mm_cmpgt_epi16(_mm_loadu_si128((__m128i const *)&buf[n + 8]), lvl);
+        if (_mm_movemask_epi8(_mm_or_si128(a, b))) {
+            break;
+        }
+    }
+    return n + find_above_scalar(&buf[n], len - n, level);
+}
+#endif /* BASEBAND_SSE2 */
+
+#ifdef BASEBAND_AVX2
+TARGET_AVX2
+static uint32_t find_above_avx2(int16_t const *buf, uint32_t len, int16_t level)
+{
+    __m256i const lvl = _mm256_set1_epi16(level);
+    uint32_t n        = 0;
+    for (; n + 32 <= len; n += 32) {
+        __m256i a = _mm256_cmpgt_epi16(_mm256_loadu_si256((__m256i const *)&buf[n]), lvl);
+        __m256i b = _mm256_cmpgt_epi16(_mm256_loadu_si256((__m256i const *)&buf[n + 16]), lvl);
+        if (_mm256_movemask_epi8(_mm256_or_si256(a, b))) {
+            break;
+        }
+    }
+    return n + find_above_scalar(&buf[n], len - n, level);
+}
+#endif /* BASEBAND_AVX2 */
+
+#ifdef BASEBAND_NEON
+static uint32_t find_above_neon(int16_t const *buf, uint32_t len, int16_t level)
+{
+    int16x8_t const lvl = vdupq_n_s16(level);
+    uint32_t n          = 0;
+    for (; n + 16 <= len; n += 16) {
+        uint16x8_t m = vorrq_u16(vcgtq_s16(vld1q_s16(&buf[n]), lvl), vcgtq_s16(vld1q_s16(&buf[n + 8]), lvl));
+        uint64x2_t w = vreinterpretq_u64_u16(m);
+        if (vgetq_lane_u64(w, 0) | vgetq_lane_u64(w, 1)) {
+            break;
+        }
+    }
+    return n + find_above_scalar(&buf[n], len - n, level);
+}
+#endif /* BASEBAND_NEON */
+
+/// Kernel functions of one implementation.
+struct kernel_set {
+    kernel_cu8_fn envelope;
+    kernel_cu8_fn magnitude_est_cu8;
+    kernel_cu8_fn magnitude_true_cu8;
+    kernel_cs16_fn magnitude_est_cs16;
+    kernel_cs16_fn magnitude_true_cs16;
+    kernel_fm_fn fm_phase_cu8;
+    convert_cs8_fn convert_cs8_cu8;
+    convert_cf32_fn convert_cf32_cs16;
+    find_above_fn find_above;
+};
+
+/// All kernels of each implementation, entries not compiled in stay empty.
+static struct kernel_set const impl_kernels[BASEBAND_IMPL_END] = {
+        [BASEBAND_IMPL_SCALAR] = {
+                envelope_scalar,
+                magnitude_est_cu8_scalar,
+                magnitude_true_cu8_scalar,
+                magnitude_est_cs16_scalar,
+                magnitude_true_cs16_scalar,
+                fm_phase_cu8_scalar,
+                convert_cs8_cu8_scalar,
+                convert_cf32_cs16_scalar,
+                find_above_scalar,
+        },
+#ifdef BASEBAND_SSE2
+        [BASEBAND_IMPL_SSE2] = {
+                envelope_sse2,
+                magnitude_est_cu8_sse2,
+                magnitude_true_cu8_sse2,
+                magnitude_est_cs16_sse2,
+                magnitude_true_cs16_sse2,
+                fm_phase_cu8_sse2,
+                convert_cs8_cu8_sse2,
+                convert_cf32_cs16_sse2,
+                find_above_sse2,
+        },
+#endif
+#ifdef BASEBAND_AVX2
+        [BASEBAND_IMPL_AVX2] = {
+                envelope_avx2,
+                magnitude_est_cu8_avx2,
+                magnitude_true_cu8_avx2,
+                magnitude_est_cs16_avx2,
+                magnitude_true_cs16_avx2,
+                fm_phase_cu8_sse2,
+                convert_cs8_cu8_avx2,
+                convert_cf32_cs16_avx2,
+                find_above_avx2,
+        },
+#endif
+#ifdef BASEBAND_NEON
+        [BASEBAND_IMPL_NEON] = {
+                envelope_neon,
+                magnitude_est_cu8_neon,
+                magnitude_true_cu8_scalar,
+                magnitude_est_cs16_scalar,
+                magnitude_true_cs16_scalar,
+                fm_phase_cu8_scalar,
+                convert_cs8_cu8_neon,
+                convert_cf32_cs16_scalar,
+                find_above_neon,
+        },
+#endif
+};
+
+/// Implementations requested before baseband_init(), only written at startup.
+static baseband_impl_t requested_impl = BASEBAND_IMPL_AUTO;
+static baseband_impl_t requested_kernel_impl[BASEBAND_KERNEL_END];
+static int requested_kernels; ///< Nonzero once requested_kernel_impl is filled
+
+/// The selected kernels, only written once by select_kernels().
+static struct kernel_set kernels = {
+        envelope_scalar,
+        magnitude_est_cu8_scalar,
+        magnitude_true_cu8_scalar,
+        magnitude_est_cs16_scalar,
+        magnitude_true_cs16_scalar,
+        fm_phase_cu8_scalar,
+        convert_cs8_cu8_scalar,
+        convert_cf32_cs16_scalar,
+        find_above_scalar,
+};
+static baseband_impl_t kernels_impl = BASEBAND_IMPL_SCALAR;
+static baseband_impl_t kernel_impl[BASEBAND_KERNEL_END];
+static unsigned kernels_selected;
+
+/// Kernels of a single implementation used by the calling thread instead, see baseband_set_thread_impl().
+static THREAD_LOCAL struct kernel_set const *thread_kernels;
+
+static inline struct kernel_set const *active_kernels(void)
+{
+    return thread_kernels ? thread_kernels : &kernels;
+}
+
+int baseband_impl_available(baseband_impl_t impl)
+{
+    switch (impl) {
+    case BASEBAND_IMPL_SCALAR:
+        return 1;
+#ifdef BASEBAND_SSE2
+    case BASEBAND_IMPL_SSE2:
+        return 1;
+#endif
+#ifdef BASEBAND_AVX2
+    case BASEBAND_IMPL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+#ifdef BASEBAND_NEON
+    case BASEBAND_IMPL_NEON:
+        return 1;
+#endif
+    default:
+        return 0;
+    }
+}
+
+char const *baseband_impl_name(baseband_impl_t impl)
+{
+    switch (impl) {
+    case BASEBAND_IMPL_SCALAR:
+        return "scalar";
+    case BASEBAND_IMPL_SSE2:
+        return "sse2";
+    case BASEBAND_IMPL_AVX2:
+        return "avx2";
+    case BASEBAND_IMPL_NEON:
+        return "neon";
+    default:
+        return "unknown";
+    }
+}
+
+static baseband_impl_t best_impl(void)
+{
+    baseband_impl_t impl = BASEBAND_IMPL_SCALAR;
+    for (int i = BASEBAND_IMPL_SCALAR; i < BASEBAND_IMPL_END; ++i) {
+        if (baseband_impl_available(i)) {
+            impl = i;
+        }
+    }
+    return impl;
+}
+
+/// Check that the kernels can still be chosen, they are fixed once selected.
+static int selection_open(void)
+{
+    if (ATOMIC_LOAD_ACQUIRE(&kernels_selected)) {
+        print_logf(LOG_WARNING, "Baseband", "Kernels are already selected, choose them before the first input");
+        return 0;
+    }
+    return 1;
+}
+
+baseband_impl_t baseband_get_impl(void)
+{
+    if (thread_kernels) {
+        return (baseband_impl_t)(thread_kernels - impl_kernels);
+    }
+    if (!ATOMIC_LOAD_ACQUIRE(&kernels_selected)) {
+        return requested_impl == BASEBAND_IMPL_AUTO ? best_impl() : requested_impl;
+    }
+    return kernels_impl;
+}
+
+baseband_impl_t baseband_set_impl(baseband_impl_t impl)
+{
+    if (impl == BASEBAND_IMPL_AUTO) {
+        impl = best_impl();
+    }
+    if (!baseband_impl_available(impl)) {
+        print_logf(LOG_WARNING, "Baseband", "Kernels \"%s\" not available on this CPU", baseband_impl_name(impl));
+        return baseband_get_impl();
+    }
+    if (!selection_open()) {
+        return baseband_get_impl();
+    }
+
+    requested_impl = impl;
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        requested_kernel_impl[k] = impl;
+    }
+    requested_kernels = 1;
+    return impl;
+}
+
+baseband_impl_t baseband_set_thread_impl(baseband_impl_t impl)
+{
+    if (impl == BASEBAND_IMPL_AUTO) {
+        thread_kernels = NULL;
+        return baseband_get_impl();
+    }
+    if (!baseband_impl_available(impl)) {
+        print_logf(LOG_WARNING, "Baseband", "Kernels \"%s\" not available on this CPU", baseband_impl_name(impl));
+        return baseband_get_impl();
+    }
+    thread_kernels = &impl_kernels[impl];
+    return impl;
+}
+
+char const *baseband_kernel_name(baseband_kernel_t kernel)
+{
+    switch (kernel) {
+    case BASEBAND_KERNEL_ENVELOPE:
+        return "envelope";
+    case BASEBAND_KERNEL_MAG_EST_CU8:
+        return "magnitude_est_cu8";
+    case BASEBAND_KERNEL_MAG_TRUE_CU8:
+        return "magnitude_true_cu8";
+    case BASEBAND_KERNEL_MAG_EST_CS16:
+        return "magnitude_est_cs16";
+    case BASEBAND_KERNEL_MAG_TRUE_CS16:
+        return "magnitude_true_cs16";
+    case BASEBAND_KERNEL_FM_CU8:
+        return "fm_cu8";
+    default:
+        return "unknown";
+    }
+}
+
+baseband_impl_t baseband_get_kernel_impl(baseband_kernel_t kernel)
+{
+    if ((int)kernel < 0 || kernel >= BASEBAND_KERNEL_END || thread_kernels) {
+        return baseband_get_impl();
+    }
+    if (!ATOMIC_LOAD_ACQUIRE(&kernels_selected)) {
+        return requested_kernels ? requested_kernel_impl[kernel] : baseband_get_impl();
+    }
+    return kernel_impl[kernel];
+}
+
+baseband_impl_t baseband_set_kernel_impl(baseband_kernel_t kernel, baseband_impl_t impl)
+{
+    if ((int)kernel < 0 || kernel >= BASEBAND_KERNEL_END || !baseband_impl_available(impl)
+            || !selection_open()) {
+        return baseband_get_kernel_impl(kernel);
+    }
+
+    if (!requested_kernels) {
+        baseband_set_impl(requested_impl);
+    }
+    requested_kernel_impl[kernel] = impl;
+    return impl;
+}
+
+/// Fill the kernels from the requested implementations, runs once.
+static void select_kernels(void)
+{
+    if (!requested_kernels) {
+        baseband_set_impl(requested_impl);
+    }
+
+    kernels_impl = requested_impl;
+    kernels      = impl_kernels[requested_impl];
+    for (int k = 0; k < BASEBAND_KERNEL_END; ++k) {
+        kernel_impl[k] = requested_kernel_impl[k];
+    }
+    kernels.envelope            = impl_kernels[kernel_impl[BASEBAND_KERNEL_ENVELOPE]].envelope;
+    kernels.magnitude_est_cu8   = impl_kernels[kernel_impl[BASEBAND_KERNEL_MAG_EST_CU8]].magnitude_est_cu8;
+    kernels.magnitude_true_cu8  = impl_kernels[kernel_impl[BASEBAND_KERNEL_MAG_TRUE_CU8]].magnitude_true_cu8;
+    kernels.magnitude_est_cs16  = impl_kernels[kernel_impl[BASEBAND_KERNEL_MAG_EST_CS16]].magnitude_est_cs16;
+    kernels.magnitude_true_cs16 = impl_kernels[kernel_impl[BASEBAND_KERNEL_MAG_TRUE_CS16]].magnitude_true_cs16;
+    kernels.fm_phase_cu8        = impl_kernels[kernel_impl[BASEBAND_KERNEL_FM_CU8]].fm_phase_cu8;
+
+    ATOMIC_STORE_RELEASE(&kernels_selected, 1);
+}
+
+// This will give a noisy envelope of OOK/ASK signals.
+// Subtract the bias (-128) and get an envelope estimation.
+float envelope_detect(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    uint32_t sum = active_kernels()->envelope(iq_buf, y_buf, len);
+    return len > 0 && sum >= len ? AMP_TO_DB((float)sum / len) : AMP_TO_DB(1);
+}
+
+/// This will give a noisy envelope of OOK/ASK signals.
+/// Subtracts the bias (-128) and calculates the norm (scaled by 16384).
+/// Using a LUT is slower for O1 and above.
+float envelope_detect_nolut(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    unsigned long i;
+    uint32_t sum = 0;
+    for (i = 0; i < len; i++) {
+        int16_t x = 127 - iq_buf[2 * i];
+        int16_t y = 127 - iq_buf[2 * i + 1];
+        y_buf[i]  = x * x + y * y; // max 32768, fs 16384
+        sum += y_buf[i];
+    }
+    return len > 0 && sum >= len ? AMP_TO_DB((float)sum / len) : AMP_TO_DB(1);
+}
+
+/// 122/128, 51/128 Magnitude Estimator for CU8 (SIMD has min/max).
+/// Note that magnitude emphasizes quiet signals / deemphasizes loud signals.
+float magnitude_est_cu8(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    uint32_t sum = active_kernels()->magnitude_est_cu8(iq_buf, y_buf, len);
+    return len > 0 && sum >= len ? MAG_TO_DB((float)sum / len) : MAG_TO_DB(1);
+}
+
+/// True Magnitude for CU8 (sqrt can SIMD but float is slow).
+float magnitude_true_cu8(uint8_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    uint32_t sum = active_kernels()->magnitude_true_cu8(iq_buf, y_buf, len);
     return len > 0 && sum >= len ? MAG_TO_DB((float)sum / len) : MAG_TO_DB(1);
 }
 
+/// 122/128, 51/128 Magnitude Estimator for CS16 (SIMD has min/max).
+float magnitude_est_cs16(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    uint32_t sum = active_kernels()->magnitude_est_cs16(iq_buf, y_buf, len);
+    return len > 0 && sum >= len ? MAG_TO_DB((float)sum / len) : MAG_TO_DB(1);
+}
+
+/// True Magnitude for CS16 (sqrt can SIMD but float is slow).
+float magnitude_true_cs16(int16_t const *iq_buf, uint16_t *y_buf, uint32_t len)
+{
+    uint32_t sum = active_kernels()->magnitude_true_cs16(iq_buf, y_buf, len);
+    return len > 0 && sum >= len ? MAG_TO_DB((float)sum / len) : MAG_TO_DB(1);
+}
+
+void baseband_convert_cs8_cu8(uint8_t *buf, uint32_t len)
+{
+    active_kernels()->convert_cs8_cu8(buf, len);
+}
+
+uint32_t baseband_find_above(int16_t const *buf, uint32_t len, int16_t level)
+{
+    return active_kernels()->find_above(buf, len, level);
+}
+
+void baseband_convert_cf32_cs16(float const *in, int16_t *out, uint32_t len)
+{
+    active_kernels()->convert_cf32_cs16(in, out, len);
+}
+
+/// Sum the levels of every stride-th sample in [from, to), the same per sample values as the kernels.
+static uint32_t probe_sum(void const *iq_buf, int sample_size, int use_mag_est, uint32_t from, uint32_t to, unsigned stride)
+{
+    uint32_t sum = 0;
+    if (sample_size == 4) { // CS16
+        int16_t const *iq = iq_buf;
+        for (uint32_t i = from; i < to; i += stride) {
+            uint32_t x  = abs(iq[2 * i]);
+            uint32_t y  = abs(iq[2 * i + 1]);
+            uint32_t mi = x < y ? x : y;
+            uint32_t mx = x > y ? x : y;
+            sum += (122 * mx + 51 * mi) >> 8;
+        }
+    }
+    else if (use_mag_est) { // CU8 magnitude
+        uint8_t const *iq = iq_buf;
+        for (uint32_t i = from; i < to; i += stride) {
+            uint32_t x  = abs(iq[2 * i] - 128);
+            uint32_t y  = abs(iq[2 * i + 1] - 128);
+            uint32_t mi = x < y ? x : y;
+            uint32_t mx = x > y ? x : y;
+            sum += 122 * mx + 51 * mi;
+        }
+    }
+    else { // CU8 amplitude
+        uint8_t const *iq = iq_buf;
+        for (uint32_t i = from; i < to; i += stride) {
+            sum += scaled_squares[iq[2 * i]] + scaled_squares[iq[2 * i + 1]];
+        }
+    }
+    return sum;
+}
+
+/// Convert a level sum over n samples to dB, like the estimators.
+static float probe_db(int sample_size, int use_mag_est, uint32_t sum, uint32_t n)
+{
+    if (sample_size == 2 && !use_mag_est) {
+        return n > 0 && sum >= n ? AMP_TO_DB((float)sum / n) : AMP_TO_DB(1);
+    }
+    return n > 0 && sum >= n ? MAG_TO_DB((float)sum / n) : MAG_TO_DB(1);
+}
+
+float baseband_probe_level(void const *iq_buf, int sample_size, int use_mag_est, uint32_t len, unsigned stride, float *tail_db)
+{
+    if (stride < 1) {
+        stride = 1;
+    }
+    // the tail starts on the stride grid so a stride of 1 reads every sample exactly once
+    uint32_t tail   = (len - len / 16) / stride * stride;
+    uint32_t n_head = (tail + stride - 1) / stride;
+    uint32_t n_tail = (len - tail + stride - 1) / stride;
+
+    uint32_t sum_head = probe_sum(iq_buf, sample_size, use_mag_est, 0, tail, stride);
+    uint32_t sum_tail = probe_sum(iq_buf, sample_size, use_mag_est, tail, len, stride);
+
+    *tail_db = probe_db(sample_size, use_mag_est, sum_tail, n_tail);
+    return probe_db(sample_size, use_mag_est, sum_head + sum_tail, n_head + n_tail);
+}
+
 void baseband_low_pass_filter_reset(filter_state_t *lowpass_filter)
 {
     *lowpass_filter = (filter_state_t){0};
@@ -169,41 +1226,11 @@ void baseband_low_pass_filter(filter_state_t *state, uint16_t const *x_buf, int1
 }
 
 
-/** Integer implementation of atan2() with int16_t normalized output.
-
-    Returns arc tangent of y/x across all quadrants in radians.
-    Error max 0.07 radians.
-    Reference: http://dspguru.com/dsp/tricks/fixed-point-atan2-with-self-normalization
-    @param y Numerator (imaginary value of complex vector)
-    @param x Denominator (real value of complex vector)
-    @return angle in radians (Pi equals INT16_MAX)
-*/
-static int16_t atan2_int16(int32_t y, int32_t x)
-{
-    static int32_t const I_PI_4 = INT16_MAX/4;      // M_PI/4
-    static int32_t const I_3_PI_4 = 3*INT16_MAX/4;  // 3*M_PI/4
-
-    int32_t const abs_y = abs(y);
-    int32_t angle;
-
-    if (!x && !y) return 0; // We would get 8191 with the code below
-
-    if (x >= 0) {    // Quadrant I and IV
-        int32_t denom = (abs_y + x);
-        if (denom == 0) denom = 1;  // Prevent divide by zero
-        angle = I_PI_4 - I_PI_4 * (x - abs_y) / denom;
-    } else {        // Quadrant II and III
-        int32_t denom = (abs_y - x);
-        if (denom == 0) denom = 1;  // Prevent divide by zero
-        angle = I_3_PI_4 - I_PI_4 * (x + abs_y) / denom;
-    }
-    if (y < 0) angle = -angle;    // Negate if in III or IV
-    return angle;
-}
-
 void baseband_demod_FM_reset(demodfm_state_t *demod_fm)
 {
+    int fast_atan = demod_fm->fast_atan; // a setting, not state
     *demod_fm = (demodfm_state_t){0};
+    demod_fm->fast_atan = fast_atan;
 }
 
 /// Fast Instantaneous frequency and Low Pass filter, CU8 samples
@@ -233,41 +1260,33 @@ void baseband_demod_FM(demodfm_state_t *state, uint8_t const *x_buf, int16_t *y_
     int32_t const *alp = state->alp_16;
     int32_t const *blp = state->blp_16;
 
-    // Pre-feed old sample
-    int16_t x0r = state->xr; // IQ sample: x[n], real
-    int16_t x0i = state->xi; // IQ sample: x[n], imag
-    int16_t x0f = state->xf; // Instantaneous frequency
-    int16_t y0f = state->yf; // Instantaneous frequency, low pass filtered
+    if (num_samples == 0) {
+        return;
+    }
 
-    for (unsigned n = 0; n < num_samples; n++) {
-        int16_t x1r, x1i; // Old IQ sample: x[n-1]
-        int16_t x1f, y1f; // Instantaneous frequency, old sample
-        int32_t pr, pi;   // Phase difference vector
-
-        // delay old sample
-        x1r = x0r;
-        x1i = x0i;
-        y1f = y0f;
-        x1f = x0f;
-        // get new sample
-        x0r = *x_buf++ - 128;
-        x0i = *x_buf++ - 128;
-        // Calculate phase difference vector: x[n] * conj(x[n-1])
-        pr = x0r * x1r + x0i * x1i; // May exactly overflow an int16_t (-128*-128 + -128*-128)
-        pi = x0i * x1r - x0r * x1i;
-        // xlp = (int16_t)((atan2f(pi, pr) / M_PI) * INT16_MAX); // Floating point implementation
-        x0f = atan2_int16(pi, pr); // Integer implementation
-        // xlp = pi; // Cheat and use only imaginary part (works OK, but is amplitude sensitive)
-        // Low pass filter
+    // First pass over the block: Instantaneous frequency of each sample into y_buf.
+    int32_t x0r = x_buf[0] - 128;
+    int32_t x0i = x_buf[1] - 128;
+    int32_t pr  = x0r * state->xr + x0i * state->xi;
+    int32_t pi  = x0i * state->xr - x0r * state->xi;
+    y_buf[0]    = state->fast_atan ? (int16_t)(atan2_poly((float)pi, (float)pr) * INT16_MAX) : atan2_int16(pi, pr);
+    active_kernels()->fm_phase_cu8(x_buf, &y_buf[1], num_samples - 1, state->fast_atan);
+
+    // Second pass: Low pass filter in place, the recursion carries over from the previous block.
+    int16_t x1f = state->xf; // Instantaneous frequency, old sample
+    int16_t y0f = state->yf; // Instantaneous frequency, low pass filtered
+    for (unsigned long n = 0; n < num_samples; n++) {
+        int16_t x0f = y_buf[n];
         // y0f      = ((alp[1] * y1f >> 1) + (blp[0] * x0f >> 1) + (blp[1] * x1f >> 1)) >> (F_SCALE - 1);
-        y0f      = (alp[1] * y1f + blp[0] * (x0f + x1f)) >> (F_SCALE - 1); // note: prescaled, blp[0]==blp[1]
-        *y_buf++ = y0f;
+        y0f      = (alp[1] * y0f + blp[0] * (x0f + x1f)) >> (F_SCALE - 1); // note: prescaled, blp[0]==blp[1]
+        y_buf[n] = y0f;
+        x1f      = x0f;
     }
 
     // Store newest sample for next run
-    state->xr = x0r;
-    state->xi = x0i;
-    state->xf = x0f;
+    state->xr = x_buf[2 * num_samples - 2] - 128;
+    state->xi = x_buf[2 * num_samples - 1] - 128;
+    state->xf = x1f;
     state->yf = y0f;
 }
 
@@ -277,6 +1296,9 @@ void baseband_demod_FM(demodfm_state_t *state, uint8_t const *x_buf, int16_t *y_
 #define S_CONST32 (1 << F_SCALE32)
 #define FIX32(x) ((int)(x * S_CONST32))
 
+/// Number of CS16 samples demodulated per pass.
+#define FM_CHUNK_SIZE 1024
+
 /// for evaluation.
 static int32_t atan2_int32(int32_t y, int32_t x)
 {
@@ -326,46 +1348,115 @@ void baseband_demod_FM_cs16(demodfm_state_t *state, int16_t const *x_buf, int16_
     int64_t const *alp = state->alp_32;
     int64_t const *blp = state->blp_32;
 
-    // Pre-feed old sample
-    int32_t x0r = state->xr; // IQ sample: x[n], real
-    int32_t x0i = state->xi; // IQ sample: x[n], imag
-    int32_t x0f = state->xf; // Instantaneous frequency
+    // Work in chunks to keep the 32 bit Instantaneous frequency off the output buffer
+    int32_t freq[FM_CHUNK_SIZE];
+    int32_t x1r = state->xr; // Old IQ sample: x[n-1], real
+    int32_t x1i = state->xi; // Old IQ sample: x[n-1], imag
+    int32_t x1f = state->xf; // Instantaneous frequency, old sample
     int32_t y0f = state->yf; // Instantaneous frequency, low pass filtered
 
-    for (unsigned n = 0; n < num_samples; n++) {
-        int32_t x1r, x1i; // Old IQ sample: x[n-1]
-        int32_t x1f, y1f; // Instantaneous frequency, old sample
-        int64_t pr, pi;   // Phase difference vector
-
-        // delay old sample
-        x1r = x0r;
-        x1i = x0i;
-        y1f = y0f;
-        x1f = x0f;
-        // get new sample
-        x0r = *x_buf++;
-        x0i = *x_buf++;
+    for (unsigned long pos = 0; pos < num_samples; pos += FM_CHUNK_SIZE) {
+        unsigned long len = MIN(FM_CHUNK_SIZE, num_samples - pos);
+        int16_t const *x  = &x_buf[2 * pos];
+
+        // First pass over the chunk: Instantaneous frequency of each sample.
         // Calculate phase difference vector: x[n] * conj(x[n-1])
-        pr = (int64_t)x0r * x1r + (int64_t)x0i * x1i; // May exactly overflow an int32_t (-32768*-32768 + -32768*-32768)
-        pi = (int64_t)x0i * x1r - (int64_t)x0r * x1i;
-        // xlp = (int32_t)((atan2f(pi, pr) / M_PI) * INT32_MAX); // Floating point implementation
-        x0f = atan2_int32(pi, pr); // Integer implementation
-        // xlp = atan2_int16(pi >> 16, pr >> 16) << 16; // Integer implementation, truncated
-        // xlp = pi; // Cheat and use only imaginary part (works OK, but is amplitude sensitive)
-        // Low pass filter
-        // y0f      = (alp[1] * y1f + blp[0] * x0f + blp[1] * x1f) >> F_SCALE32;
-        y0f      = (alp[1] * y1f + blp[0] * ((int64_t)x0f + x1f)) >> F_SCALE32; // note: blp[0]==blp[1]
-        *y_buf++ = y0f >> 16; // not really losing info here, maybe optimize earlier
+        // pr = x0r * x1r + x0i * x1i; // May exactly overflow an int32_t (-32768*-32768 + -32768*-32768)
+        // pi = x0i * x1r - x0r * x1i;
+        int64_t pr = (int64_t)x[0] * x1r + (int64_t)x[1] * x1i;
+        int64_t pi = (int64_t)x[1] * x1r - (int64_t)x[0] * x1i;
+        if (state->fast_atan) {
+            freq[0] = (int32_t)(atan2_poly((float)pi, (float)pr) * (double)INT32_MAX);
+            for (unsigned long n = 1; n < len; n++) {
+                int64_t qr = (int64_t)x[2 * n] * x[2 * n - 2] + (int64_t)x[2 * n + 1] * x[2 * n - 1];
+                int64_t qi = (int64_t)x[2 * n + 1] * x[2 * n - 2] - (int64_t)x[2 * n] * x[2 * n - 1];
+                freq[n]    = (int32_t)(atan2_poly((float)qi, (float)qr) * (double)INT32_MAX);
+            }
+        }
+        else {
+            // xlp = (int32_t)((atan2f(pi, pr) / M_PI) * INT32_MAX); // Floating point implementation
+            // xlp = atan2_int16(pi >> 16, pr >> 16) << 16; // Integer implementation, truncated
+            // xlp = pi; // Cheat and use only imaginary part (works OK, but is amplitude sensitive)
+            freq[0] = atan2_int32(pi, pr); // Integer implementation
+            for (unsigned long n = 1; n < len; n++) {
+                int64_t qr = (int64_t)x[2 * n] * x[2 * n - 2] + (int64_t)x[2 * n + 1] * x[2 * n - 1];
+                int64_t qi = (int64_t)x[2 * n + 1] * x[2 * n - 2] - (int64_t)x[2 * n] * x[2 * n - 1];
+                freq[n]    = atan2_int32(qi, qr);
+            }
+        }
+
+        // Second pass: Low pass filter, the recursion carries over from the previous chunk.
+        for (unsigned long n = 0; n < len; n++) {
+            // y0f      = (alp[1] * y1f + blp[0] * x0f + blp[1] * x1f) >> F_SCALE32;
+            y0f            = (alp[1] * y0f + blp[0] * ((int64_t)freq[n] + x1f)) >> F_SCALE32; // note: blp[0]==blp[1]
+            y_buf[pos + n] = y0f >> 16; // not really losing info here, maybe optimize earlier
+            x1f            = freq[n];
+        }
+
+        x1r = x[2 * len - 2];
+        x1i = x[2 * len - 1];
     }
 
     // Store newest sample for next run
-    state->xr = x0r;
-    state->xi = x0i;
-    state->xf = x0f;
+    state->xr = x1r;
+    state->xi = x1i;
+    state->xf = x1f;
     state->yf = y0f;
 }
 
+/// Number of samples per chunk of the fused front end, the chunk buffers stay in L1 cache.
+#define FUSED_CHUNK_SIZE 1024
+
+float baseband_demod_AM_FM(filter_state_t *lp_state, demodfm_state_t *fm_state, int use_mag_est,
+        uint8_t const *iq_buf, int16_t *am_buf, int16_t *fm_buf, uint32_t len, uint32_t samp_rate, float low_pass)
+{
+    uint16_t env[FUSED_CHUNK_SIZE];
+    uint32_t sum = 0;
+    for (uint32_t pos = 0; pos < len; pos += FUSED_CHUNK_SIZE) {
+        uint32_t n = MIN(FUSED_CHUNK_SIZE, len - pos);
+        uint8_t const *x = &iq_buf[2 * pos];
+        // the IQ chunk is read from memory once, the second read hits the cache
+        if (use_mag_est) {
+            sum += active_kernels()->magnitude_est_cu8(x, env, n);
+        }
+        else {
+            sum += active_kernels()->envelope(x, env, n);
+        }
+        baseband_low_pass_filter(lp_state, env, &am_buf[pos], n);
+        baseband_demod_FM(fm_state, x, &fm_buf[pos], n, samp_rate, low_pass);
+    }
+    if (use_mag_est) {
+        return len > 0 && sum >= len ? MAG_TO_DB((float)sum / len) : MAG_TO_DB(1);
+    }
+    return len > 0 && sum >= len ? AMP_TO_DB((float)sum / len) : AMP_TO_DB(1);
+}
+
+float baseband_demod_AM_FM_cs16(filter_state_t *lp_state, demodfm_state_t *fm_state,
+        int16_t const *iq_buf, int16_t *am_buf, int16_t *fm_buf, uint32_t len, uint32_t samp_rate, float low_pass)
+{
+    uint16_t env[FUSED_CHUNK_SIZE];
+    uint32_t sum = 0;
+    for (uint32_t pos = 0; pos < len; pos += FUSED_CHUNK_SIZE) {
+        uint32_t n = MIN(FUSED_CHUNK_SIZE, len - pos);
+        int16_t const *x = &iq_buf[2 * pos];
+        sum += active_kernels()->magnitude_est_cs16(x, env, n);
+        baseband_low_pass_filter(lp_state, env, &am_buf[pos], n);
+        baseband_demod_FM_cs16(fm_state, x, &fm_buf[pos], n, samp_rate, low_pass);
+    }
+    return len > 0 && sum >= len ? MAG_TO_DB((float)sum / len) : MAG_TO_DB(1);
+}
+
+#ifdef THREADS
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+#endif
+
 void baseband_init(void)
 {
-    calc_squares();
+#ifdef THREADS
+    pthread_once(&kernels_once, select_kernels);
+#else
+    if (!kernels_selected) {
+        select_kernels();
+    }
+#endif
 }
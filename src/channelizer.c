@@ -0,0 +1,257 @@
+/** @file
+    Polyphase filterbank channelizer for wideband IQ input.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "channelizer.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "fatal.h"
+
+channelizer_t *channelizer_create(unsigned n_channels)
+{
+    if (n_channels < CHANNELIZER_MIN_CHANNELS || n_channels > CHANNELIZER_MAX_CHANNELS) {
+        return NULL;
+    }
+
+    channelizer_t *chz = calloc(1, sizeof(*chz));
+    if (!chz) {
+        WARN_CALLOC("channelizer_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    chz->n_channels = n_channels;
+    chz->taps       = n_channels * CHANNELIZER_TAPS_PER_CHANNEL;
+
+    // coeffs, twiddle factors, and history share one allocation
+    chz->coeffs = calloc(chz->taps + n_channels * 2 + (chz->taps + n_channels) * 2, sizeof(float));
+    if (!chz->coeffs) {
+        WARN_CALLOC("channelizer_create()");
+        free(chz);
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    chz->twiddle = chz->coeffs + chz->taps;
+    chz->hist    = chz->twiddle + n_channels * 2;
+
+    // Hamming windowed sinc low pass, cutoff at half the channel spacing, unity DC gain
+    double const fc     = 0.5 / n_channels;
+    double const center = (chz->taps - 1) / 2.0;
+    double sum          = 0.0;
+    for (unsigned l = 0; l < chz->taps; ++l) {
+        double x   = l - center;
+        double h   = x == 0.0 ? 2.0 * fc : sin(2.0 * M_PI * fc * x) / (M_PI * x);
+        double win = 0.54 - 0.46 * cos(2.0 * M_PI * l / (chz->taps - 1));
+        chz->coeffs[l] = (float)(h * win);
+        sum += h * win;
+    }
+    for (unsigned l = 0; l < chz->taps; ++l) {
+        chz->coeffs[l] = (float)(chz->coeffs[l] / sum);
+    }
+
+    for (unsigned p = 0; p < n_channels; ++p) {
+        chz->twiddle[2 * p]     = (float)cos(2.0 * M_PI * p / n_channels);
+        chz->twiddle[2 * p + 1] = (float)sin(2.0 * M_PI * p / n_channels);
+    }
+
+    return chz;
+}
+
+void channelizer_free(channelizer_t *chz)
+{
+    if (!chz) {
+        return;
+    }
+    free(chz->coeffs);
+    free(chz->buf);
+    free(chz);
+}
+
+void channelizer_reset(channelizer_t *chz)
+{
+    chz->phase = 0;
+    memset(chz->hist, 0, (chz->taps + chz->n_channels) * 2 * sizeof(*chz->hist));
+}
+
+/// Saturate a scaled float sample to int16.
+static inline int16_t float_to_s16(float x)
+{
+    x *= 32767.0f;
+    if (x > 32767.0f) {
+        return 32767;
+    }
+    if (x < -32768.0f) {
+        return -32768;
+    }
+    return (int16_t)lrintf(x);
+}
+
+/// Compute one output sample for all channels from the current history.
+static void channelizer_output_sample(channelizer_t *chz, unsigned long n)
+{
+    unsigned const n_channels = chz->n_channels;
+    unsigned const taps       = chz->taps;
+    float const *coeffs       = chz->coeffs;
+    float const *twiddle      = chz->twiddle;
+    // the newest sample is at taps + n_channels - 1, the window reaches back over all taps
+    float const *z = &chz->hist[2 * (taps + n_channels - 1)];
+
+    // Polyphase partition: v_p = sum over t of h[t*N + p] * z[t*N + p]
+    float v[2 * CHANNELIZER_MAX_CHANNELS] = {0};
+    for (unsigned l = 0; l < taps; l += n_channels) {
+        for (unsigned p = 0; p < n_channels; ++p) {
+            v[2 * p] += coeffs[l + p] * z[-2 * (int)(l + p)];
+            v[2 * p + 1] += coeffs[l + p] * z[-2 * (int)(l + p) + 1];
+        }
+    }
+
+    // Inverse DFT over the branches: y_k = sum over p of v_p * e^(j*2*pi*k*p/N)
+    // A plain DFT, N is small and there are only N outputs per N inputs.
+    for (unsigned k = 0; k < n_channels; ++k) {
+        float yr = 0.0f;
+        float yi = 0.0f;
+        unsigned m = 0; // k * p mod N
+        for (unsigned p = 0; p < n_channels; ++p) {
+            float c = twiddle[2 * m];
+            float s = twiddle[2 * m + 1];
+            yr += v[2 * p] * c - v[2 * p + 1] * s;
+            yi += v[2 * p] * s + v[2 * p + 1] * c;
+            m += k;
+            if (m >= n_channels) {
+                m -= n_channels;
+            }
+        }
+        int16_t *out = &chz->buf[2 * (k * chz->buf_len + n)];
+        out[0] = float_to_s16(yr);
+        out[1] = float_to_s16(yi);
+    }
+}
+
+unsigned long channelizer_push(channelizer_t *chz, void const *iq_buf, unsigned long n_samples, int sample_size)
+{
+    unsigned const n_channels = chz->n_channels;
+    unsigned const taps       = chz->taps;
+
+    unsigned long out_max = (chz->phase + n_samples) / n_channels;
+    if (out_max > chz->buf_len) {
+        int16_t *buf = realloc(chz->buf, out_max * n_channels * 2 * sizeof(*buf));
+        if (!buf) {
+            FATAL_REALLOC("channelizer_push()");
+        }
+        chz->buf     = buf;
+        chz->buf_len = out_max;
+    }
+
+    float *hist         = chz->hist;
+    unsigned long n_out = 0;
+    for (unsigned long n = 0; n < n_samples; ++n) {
+        float *x = &hist[2 * (taps + chz->phase)];
+        if (sample_size == 2) { // CU8, remove the bias
+            uint8_t const *in = iq_buf;
+            x[0] = (in[2 * n] - 127.5f) * (1.0f / 128);
+            x[1] = (in[2 * n + 1] - 127.5f) * (1.0f / 128);
+        }
+        else { // CS16
+            int16_t const *in = iq_buf;
+            x[0] = in[2 * n] * (1.0f / 32768);
+            x[1] = in[2 * n + 1] * (1.0f / 32768);
+        }
+        if (++chz->phase == n_channels) {
+            chz->phase = 0;
+            channelizer_output_sample(chz, n_out++);
+            memmove(hist, &hist[2 * n_channels], taps * 2 * sizeof(*hist));
+        }
+    }
+
+    return n_out;
+}
+
+int16_t *channelizer_output(channelizer_t *chz, unsigned k)
+{
+    return &chz->buf[2 * k * chz->buf_len];
+}
+
+int32_t channelizer_offset(channelizer_t const *chz, unsigned k, uint32_t samp_rate)
+{
+    int n = chz->n_channels;
+    int i = (int)k < (n + 1) / 2 ? (int)k : (int)k - n;
+    return (int32_t)((int64_t)i * samp_rate / n);
+}
+
+#ifdef _TEST
+#define ASSERT_EQUALS(a, b) \
+    do { \
+        if ((a) == (b)) \
+            ++passed; \
+        else { \
+            ++failed; \
+            fprintf(stderr, "FAIL: %d <> %d\n", (int)(a), (int)(b)); \
+        } \
+    } while (0)
+
+/// Mean magnitude of the last half of a channel output.
+static double channel_level(channelizer_t *chz, unsigned k, unsigned long n_out)
+{
+    int16_t const *y = channelizer_output(chz, k);
+    double sum = 0.0;
+    for (unsigned long n = n_out / 2; n < n_out; ++n) {
+        sum += sqrt((double)y[2 * n] * y[2 * n] + (double)y[2 * n + 1] * y[2 * n + 1]);
+    }
+    return sum / (n_out - n_out / 2);
+}
+
+int main(void)
+{
+    unsigned passed = 0;
+    unsigned failed = 0;
+
+    fprintf(stderr, "channelizer::channelizer_create(): bad channel counts\n");
+    ASSERT_EQUALS(channelizer_create(1) == NULL, 1);
+    ASSERT_EQUALS(channelizer_create(CHANNELIZER_MAX_CHANNELS + 1) == NULL, 1);
+
+    fprintf(stderr, "channelizer::channelizer_offset(): channel centers\n");
+    channelizer_t *chz = channelizer_create(8);
+    ASSERT_EQUALS(channelizer_offset(chz, 0, 2400000), 0);
+    ASSERT_EQUALS(channelizer_offset(chz, 3, 2400000), 900000);
+    ASSERT_EQUALS(channelizer_offset(chz, 5, 2400000), -900000);
+    ASSERT_EQUALS(channelizer_offset(chz, 7, 2400000), -300000);
+
+    fprintf(stderr, "channelizer::channelizer_push(): output count\n");
+    int16_t cs16[2 * 1024];
+    memset(cs16, 0, sizeof(cs16));
+    ASSERT_EQUALS(channelizer_push(chz, cs16, 20, 4), 2);
+    // the phase carries over: 4 + 20 samples give 3 outputs
+    ASSERT_EQUALS(channelizer_push(chz, cs16, 20, 4), 3);
+
+    // a tone at each channel center lands in that channel only
+    for (unsigned k = 0; k < 8; ++k) {
+        fprintf(stderr, "channelizer::channelizer_push(): tone in channel %u\n", k);
+        channelizer_reset(chz);
+        for (int n = 0; n < 1024; ++n) {
+            double arg = 2.0 * M_PI * channelizer_offset(chz, k, 8000) * n / 8000;
+            cs16[2 * n]     = (int16_t)(16000 * cos(arg));
+            cs16[2 * n + 1] = (int16_t)(16000 * sin(arg));
+        }
+        unsigned long n_out = channelizer_push(chz, cs16, 1024, 4);
+        ASSERT_EQUALS(n_out, 128);
+        double level = channel_level(chz, k, n_out);
+        ASSERT_EQUALS(fabs(level - 16000) < 160, 1); // within 1%
+        for (unsigned j = 0; j < 8; ++j) {
+            if (j != k) {
+                ASSERT_EQUALS(channel_level(chz, j, n_out) < level / 100, 1); // at least 40 dB down
+            }
+        }
+    }
+
+    channelizer_free(chz);
+
+    fprintf(stderr, "channelizer:: test (%u passed, %u failed)\n", passed, failed);
+    return failed;
+}
+#endif /* _TEST */
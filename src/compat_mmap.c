@@ -0,0 +1,98 @@
+/** @file
+    compat_mmap addresses compatibility read-only file mapping.
+
+    topic: reading large input files without copying
+    issue: mmap() is POSIX only, Windows uses file mapping objects
+    solution: map a whole file read-only with either, report failure otherwise
+*/
+
+#include "compat_mmap.h"
+
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <io.h>
+
+int mmap_view_open(mmap_view_t *view, FILE *file)
+{
+    memset(view, 0, sizeof(*view));
+
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    if (handle == INVALID_HANDLE_VALUE || GetFileType(handle) != FILE_TYPE_DISK) {
+        return -1;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart <= 0 || (uint64_t)size.QuadPart > SIZE_MAX) {
+        return -1;
+    }
+    HANDLE mapping = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        return -1;
+    }
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        return -1;
+    }
+
+    view->data    = data;
+    view->size    = (size_t)size.QuadPart;
+    view->mapping = mapping;
+    return 0;
+}
+
+void mmap_view_close(mmap_view_t *view)
+{
+    if (!view->data) {
+        return;
+    }
+    UnmapViewOfFile(view->data);
+    CloseHandle(view->mapping);
+    memset(view, 0, sizeof(*view));
+}
+
+#else
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+int mmap_view_open(mmap_view_t *view, FILE *file)
+{
+    memset(view, 0, sizeof(*view));
+
+    int fd = fileno(file);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return -1;
+    }
+    if (st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX) {
+        return -1;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+#ifdef MADV_SEQUENTIAL
+    // aggressive read-ahead, pages behind the reader can be dropped early
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    view->data = data;
+    view->size = (size_t)st.st_size;
+    return 0;
+}
+
+void mmap_view_close(mmap_view_t *view)
+{
+    if (!view->data) {
+        return;
+    }
+    munmap((void *)view->data, view->size);
+    memset(view, 0, sizeof(*view));
+}
+
+#endif /* _WIN32 */
@@ -54,7 +54,7 @@ typedef struct {
     value_release_fn value_release;
 } data_meta_type_t;
 
-static data_meta_type_t dmt[DATA_COUNT] = {
+static data_meta_type_t const dmt[DATA_COUNT] = {
     //  DATA_DATA
     { .array_element_size       = sizeof(data_t*),
       .array_is_boxed           = true,
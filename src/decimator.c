@@ -0,0 +1,171 @@
+/** @file
+    IQ decimating front end (CIC filter).
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "decimator.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fatal.h"
+
+decimator_t *decimator_create(unsigned factor)
+{
+    if (factor < 2 || factor > DECIMATOR_MAX_FACTOR) {
+        return NULL;
+    }
+
+    decimator_t *dec = calloc(1, sizeof(*dec));
+    if (!dec) {
+        WARN_CALLOC("decimator_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    dec->factor = factor;
+
+    return dec;
+}
+
+void decimator_free(decimator_t *dec)
+{
+    if (!dec) {
+        return;
+    }
+    free(dec->buf);
+    free(dec);
+}
+
+void decimator_reset(decimator_t *dec)
+{
+    dec->phase = 0;
+    memset(dec->integ, 0, sizeof(dec->integ));
+    memset(dec->comb, 0, sizeof(dec->comb));
+}
+
+/// Run one channel sample through the integrators, returns the last integrator.
+static inline uint32_t cic_integrate(uint32_t *integ, int32_t x)
+{
+    integ[0] += x;
+    integ[1] += integ[0];
+    integ[2] += integ[1];
+    return integ[2];
+}
+
+/// Run the decimated integrator output through the combs.
+static inline int32_t cic_comb(uint32_t *comb, uint32_t y)
+{
+    for (int i = 0; i < DECIMATOR_ORDER; ++i) {
+        uint32_t d = y - comb[i];
+        comb[i]    = y;
+        y          = d;
+    }
+    // the wrapped result is exact as the true value fits 32 bit
+    return (int32_t)y;
+}
+
+void *decimator_push(decimator_t *dec, void const *iq_buf, unsigned long n_samples, int sample_size, unsigned long *out_samples)
+{
+    unsigned const factor = dec->factor;
+    int32_t const gain    = factor * factor * factor; // R^N
+
+    unsigned long out_max = (dec->phase + n_samples) / factor;
+    if (out_max * sample_size > dec->buf_size) {
+        void *buf = realloc(dec->buf, out_max * sample_size);
+        if (!buf) {
+            FATAL_REALLOC("decimator_push()");
+        }
+        dec->buf      = buf;
+        dec->buf_size = out_max * sample_size;
+    }
+
+    unsigned long n_out = 0;
+    if (sample_size == 2) { // CU8, the filter has unity DC gain so the bias can stay
+        uint8_t const *in = iq_buf;
+        uint8_t *out      = dec->buf;
+        for (unsigned long n = 0; n < n_samples; ++n) {
+            uint32_t yi = cic_integrate(dec->integ[0], in[2 * n]);
+            uint32_t yq = cic_integrate(dec->integ[1], in[2 * n + 1]);
+            if (++dec->phase == factor) {
+                dec->phase         = 0;
+                out[2 * n_out]     = (cic_comb(dec->comb[0], yi) + gain / 2) / gain;
+                out[2 * n_out + 1] = (cic_comb(dec->comb[1], yq) + gain / 2) / gain;
+                n_out++;
+            }
+        }
+    }
+    else { // CS16, biased to positive to round the division
+        int16_t const *in  = iq_buf;
+        int16_t *out       = dec->buf;
+        int32_t const bias = 32768 * gain + gain / 2;
+        for (unsigned long n = 0; n < n_samples; ++n) {
+            uint32_t yi = cic_integrate(dec->integ[0], in[2 * n]);
+            uint32_t yq = cic_integrate(dec->integ[1], in[2 * n + 1]);
+            if (++dec->phase == factor) {
+                dec->phase         = 0;
+                out[2 * n_out]     = (cic_comb(dec->comb[0], yi) + bias) / gain - 32768;
+                out[2 * n_out + 1] = (cic_comb(dec->comb[1], yq) + bias) / gain - 32768;
+                n_out++;
+            }
+        }
+    }
+
+    *out_samples = n_out;
+    return dec->buf;
+}
+
+#ifdef _TEST
+#define ASSERT_EQUALS(a, b) \
+    do { \
+        if ((a) == (b)) \
+            ++passed; \
+        else { \
+            ++failed; \
+            fprintf(stderr, "FAIL: %d <> %d\n", (int)(a), (int)(b)); \
+        } \
+    } while (0)
+
+int main(void)
+{
+    unsigned passed = 0;
+    unsigned failed = 0;
+    unsigned long n_out;
+
+    fprintf(stderr, "decimator::decimator_create(): bad factors\n");
+    ASSERT_EQUALS(decimator_create(1) == NULL, 1);
+    ASSERT_EQUALS(decimator_create(DECIMATOR_MAX_FACTOR + 1) == NULL, 1);
+
+    fprintf(stderr, "decimator::decimator_push(): CU8 DC level and output count\n");
+    decimator_t *dec = decimator_create(4);
+    uint8_t cu8[2 * 10];
+    memset(cu8, 200, sizeof(cu8));
+    uint8_t *out8 = decimator_push(dec, cu8, 10, 2, &n_out);
+    ASSERT_EQUALS(n_out, 2);
+    // the phase carries over: 2 + 10 samples give 3 outputs
+    out8 = decimator_push(dec, cu8, 10, 2, &n_out);
+    ASSERT_EQUALS(n_out, 3);
+    ASSERT_EQUALS(out8[2 * n_out - 2], 200); // settled after N * R samples
+    ASSERT_EQUALS(out8[2 * n_out - 1], 200);
+
+    fprintf(stderr, "decimator::decimator_push(): CS16 extremes\n");
+    decimator_reset(dec);
+    int16_t cs16[2 * 16];
+    for (int i = 0; i < 16; ++i) {
+        cs16[2 * i]     = -32768;
+        cs16[2 * i + 1] = 32767;
+    }
+    int16_t *out16 = decimator_push(dec, cs16, 16, 4, &n_out);
+    ASSERT_EQUALS(n_out, 4);
+    ASSERT_EQUALS(out16[2 * n_out - 2], -32768);
+    ASSERT_EQUALS(out16[2 * n_out - 1], 32767);
+
+    decimator_free(dec);
+
+    fprintf(stderr, "decimator:: test (%u passed, %u failed)\n", passed, failed);
+    return failed;
+}
+#endif /* _TEST */
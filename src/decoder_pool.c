@@ -0,0 +1,289 @@
+/** @file
+    Worker pool to run the decoders of one priority level in parallel.
+
+    A batch is a count of tasks, the workers and the calling thread take the
+    next task index until all are taken, the calling thread then waits for the
+    tasks still running.
+    Batches are short and rare (one per detected package), a single mutex is
+    simple and cheap enough.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "decoder_pool.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "logger.h"
+#include "fatal.h"
+
+#ifdef THREADS
+
+#include <signal.h>
+
+#include "compat_pthread.h"
+
+struct decoder_pool {
+    unsigned n_threads; ///< worker threads, not counting the calling thread
+    pthread_t *threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond; ///< signaled on a new batch and on exit
+    pthread_cond_t done_cond; ///< signaled when the last task of a batch is done
+    int exit;
+
+    // the current batch, guarded by lock
+    decoder_pool_fn fn;
+    void *ctx;
+    unsigned n;    ///< number of tasks
+    unsigned next; ///< next task to take
+    unsigned done; ///< number of tasks done
+};
+
+/// Take and run tasks until all are taken, called with the lock held.
+static void run_tasks(decoder_pool_t *pool)
+{
+    while (pool->next < pool->n) {
+        unsigned i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        pool->fn(pool->ctx, i);
+        pthread_mutex_lock(&pool->lock);
+        if (++pool->done == pool->n) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+}
+
+static THREAD_RETURN THREAD_CALL worker_run(void *arg)
+{
+    decoder_pool_t *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->exit) {
+        if (pool->next < pool->n) {
+            run_tasks(pool);
+        }
+        else {
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return (THREAD_RETURN)0;
+}
+
+decoder_pool_t *decoder_pool_create(unsigned n_workers)
+{
+    if (n_workers < 2) {
+        return NULL; // the calling thread alone needs no pool
+    }
+    if (n_workers > DECODER_POOL_MAX_WORKERS) {
+        n_workers = DECODER_POOL_MAX_WORKERS;
+    }
+
+    decoder_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        WARN_CALLOC("decoder_pool_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    pool->threads = calloc(n_workers - 1, sizeof(*pool->threads));
+    if (!pool->threads) {
+        WARN_CALLOC("decoder_pool_create()");
+        free(pool);
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+#ifndef _WIN32
+    // Block all signals from the worker threads
+    sigset_t sigset;
+    sigset_t oldset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_SETMASK, &sigset, &oldset);
+#endif
+    for (unsigned i = 0; i < n_workers - 1; ++i) {
+        int r = pthread_create(&pool->threads[i], NULL, worker_run, pool);
+        if (r) {
+            print_logf(LOG_ERROR, "Decoder pool", "Error in pthread_create, rc: %d", r);
+            break;
+        }
+        pool->n_threads++;
+    }
+#ifndef _WIN32
+    pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+#endif
+
+    if (!pool->n_threads) {
+        decoder_pool_free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void decoder_pool_free(decoder_pool_t *pool)
+{
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->exit = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned i = 0; i < pool->n_threads; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->done_cond);
+    free(pool->threads);
+    free(pool);
+}
+
+unsigned decoder_pool_workers(decoder_pool_t *pool)
+{
+    return pool ? pool->n_threads + 1 : 1;
+}
+
+void decoder_pool_run(decoder_pool_t *pool, unsigned n, decoder_pool_fn fn, void *ctx)
+{
+    if (!pool || n < 2) {
+        for (unsigned i = 0; i < n; ++i) {
+            fn(ctx, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn   = fn;
+    pool->ctx  = ctx;
+    pool->n    = n;
+    pool->next = 0;
+    pool->done = 0;
+    pthread_cond_broadcast(&pool->work_cond);
+
+    run_tasks(pool);
+    while (pool->done < pool->n) {
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    }
+    pool->n    = 0;
+    pool->next = 0;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+#else /* !THREADS */
+
+decoder_pool_t *decoder_pool_create(unsigned n_workers)
+{
+    (void)n_workers;
+    return NULL; // decode on the calling thread
+}
+
+void decoder_pool_free(decoder_pool_t *pool)
+{
+    (void)pool;
+}
+
+unsigned decoder_pool_workers(decoder_pool_t *pool)
+{
+    (void)pool;
+    return 1;
+}
+
+void decoder_pool_run(decoder_pool_t *pool, unsigned n, decoder_pool_fn fn, void *ctx)
+{
+    (void)pool;
+    for (unsigned i = 0; i < n; ++i) {
+        fn(ctx, i);
+    }
+}
+
+#endif /* THREADS */
+
+#ifdef _TEST
+#define ASSERT_EQUALS(a, b) \
+    do { \
+        if ((a) == (b)) \
+            ++passed; \
+        else { \
+            ++failed; \
+            fprintf(stderr, "FAIL: %d <> %d\n", (int)(a), (int)(b)); \
+        } \
+    } while (0)
+
+#define TEST_TASKS 1000
+
+typedef struct test_batch {
+    unsigned order[TEST_TASKS];
+    unsigned count; // only written by the serial run
+    unsigned result[TEST_TASKS];
+} test_batch_t;
+
+static void test_task(void *ctx, unsigned i)
+{
+    test_batch_t *batch = ctx;
+    unsigned x          = i;
+    for (int k = 0; k < 100; ++k) {
+        x = x * 1103515245 + 12345;
+    }
+    batch->result[i] += x | 1;
+}
+
+static void test_order(void *ctx, unsigned i)
+{
+    test_batch_t *batch = ctx;
+    batch->order[batch->count++] = i;
+}
+
+int main(void)
+{
+    unsigned passed = 0;
+    unsigned failed = 0;
+    test_batch_t batch = {0};
+
+    fprintf(stderr, "decoder_pool::decoder_pool_run(): no pool runs in order\n");
+    decoder_pool_run(NULL, TEST_TASKS, test_order, &batch);
+    ASSERT_EQUALS(batch.count, TEST_TASKS);
+    ASSERT_EQUALS(batch.order[0], 0);
+    ASSERT_EQUALS(batch.order[TEST_TASKS - 1], TEST_TASKS - 1);
+
+    fprintf(stderr, "decoder_pool::decoder_pool_create(): a single worker needs no pool\n");
+    ASSERT_EQUALS(decoder_pool_create(1) == NULL, 1);
+
+    decoder_pool_t *pool = decoder_pool_create(4);
+#ifdef THREADS
+    ASSERT_EQUALS(decoder_pool_workers(pool), 4);
+#endif
+
+    fprintf(stderr, "decoder_pool::decoder_pool_run(): every task runs exactly once per batch\n");
+    for (int round = 0; round < 50; ++round) {
+        decoder_pool_run(pool, TEST_TASKS, test_task, &batch);
+    }
+    unsigned once = 0;
+    for (unsigned i = 0; i < TEST_TASKS; ++i) {
+        test_batch_t single = {0};
+        test_task(&single, i);
+        once += batch.result[i] == single.result[i] * 50;
+    }
+    ASSERT_EQUALS(once, TEST_TASKS);
+
+    fprintf(stderr, "decoder_pool::decoder_pool_run(): empty and single task batches\n");
+    decoder_pool_run(pool, 0, test_task, &batch);
+    batch.count = 0;
+    decoder_pool_run(pool, 1, test_order, &batch);
+    ASSERT_EQUALS(batch.count, 1);
+
+    decoder_pool_free(pool);
+
+    fprintf(stderr, "decoder_pool:: test (%u passed, %u failed)\n", passed, failed);
+    return failed;
+}
+#endif /* _TEST */
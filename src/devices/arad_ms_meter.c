@@ -38,6 +38,7 @@ typedef struct {
     float user_gear;
     int user_units_set;
     arad_unit_t user_units;
+    uint64_t keys[88]; ///< checksum keys, see arad_lfsr_init()
 } arad_mm_ctx_t;
 
 static char *arad_trim(char *s)
@@ -251,35 +252,28 @@ static uint64_t arad_lfsr_roll(uint64_t key)
 }
 
 // Per-bit checksum key for each of the 88 payload bit positions, in message
-// bit order (index 0 is the MSB of the first payload byte). Zero-initialized
-// and populated from the LFSR on first use.
-static uint64_t arad_keys[88];
-
-static void arad_lfsr_init(void)
+// bit order (index 0 is the MSB of the first payload byte). Populated from
+// the LFSR when the decoder instance is created.
+static void arad_lfsr_init(uint64_t keys[88])
 {
-    if (arad_keys[87])
-        return; // already populated (seed slot is non-zero)
-
     // The key runs from the last payload bit towards the first.
     uint64_t key = ARAD_LFSR_KEY;
     for (int j = 87; j >= 0; --j) {
-        arad_keys[j] = key;
+        keys[j] = key;
         key = arad_lfsr_roll(key);
     }
 }
 
-static uint64_t arad_checksum(uint8_t const *b)
+static uint64_t arad_checksum(uint64_t const keys[88], uint8_t const *b)
 {
     uint64_t sum = 0;
 
-    arad_lfsr_init();
-
     // Process message from first byte to last byte, bits MSB to LSB
     for (int n = 0; n < 11; n++) {
         for (int i = 0; i < 8; i++) {
             // XOR key into sum if data bit is set
             if ((b[n] >> (7 - i)) & 1)
-                sum ^= arad_keys[n * 8 + i];
+                sum ^= keys[n * 8 + i];
         }
     }
     return sum;
@@ -292,16 +286,14 @@ static void arad_flip_payload_bit(uint8_t *b, int bit_index)
     b[byte_idx] ^= (uint8_t)(1u << (7 - bit_in_byte));
 }
 
-static int arad_correct_bits(uint8_t *b, uint64_t syndrome)
+static int arad_correct_bits(uint64_t const keys[88], uint8_t *b, uint64_t syndrome)
 {
     int i;
     int j;
     int k;
 
-    arad_lfsr_init();
-
     for (i = 0; i < 88; i++) {
-        if (arad_keys[i] == syndrome) {
+        if (keys[i] == syndrome) {
             arad_flip_payload_bit(b, i);
             return 1;
         }
@@ -309,7 +301,7 @@ static int arad_correct_bits(uint8_t *b, uint64_t syndrome)
 
     for (i = 0; i < 88; i++) {
         for (j = i + 1; j < 88; j++) {
-            if ((arad_keys[i] ^ arad_keys[j]) == syndrome) {
+            if ((keys[i] ^ keys[j]) == syndrome) {
                 arad_flip_payload_bit(b, i);
                 arad_flip_payload_bit(b, j);
                 return 2;
@@ -319,9 +311,9 @@ static int arad_correct_bits(uint8_t *b, uint64_t syndrome)
 
     for (i = 0; i < 88; i++) {
         for (j = i + 1; j < 88; j++) {
-            uint64_t x = arad_keys[i] ^ arad_keys[j];
+            uint64_t x = keys[i] ^ keys[j];
             for (k = j + 1; k < 88; k++) {
-                if ((x ^ arad_keys[k]) == syndrome) {
+                if ((x ^ keys[k]) == syndrome) {
                     arad_flip_payload_bit(b, i);
                     arad_flip_payload_bit(b, j);
                     arad_flip_payload_bit(b, k);
@@ -353,6 +345,7 @@ static r_device *arad_ms_meter_create(char const *args)
     ctx->user_gear      = 0.1f;
     ctx->user_units_set = 0;
     ctx->user_units     = ARAD_UNIT_M3;
+    arad_lfsr_init(ctx->keys);
 
     if (!args)
         return dev;
@@ -571,9 +564,9 @@ static int arad_mm_dialog3g_decode(r_device *decoder, bitbuffer_t *bitbuffer)
               ((uint64_t)b[14] << 8) |
               b[15];
 
-    xor_cal = arad_checksum(b);
+    xor_cal = arad_checksum(ctx->keys, b);
     if (xor_raw != xor_cal) {
-        corrections = arad_correct_bits(b, xor_raw ^ xor_cal);
+        corrections = arad_correct_bits(ctx->keys, b, xor_raw ^ xor_cal);
         if (corrections < 0)
             return DECODE_FAIL_MIC;
     }
@@ -383,7 +383,6 @@ static void usage(void)
 {
     fprintf(stderr,
             "Use -X <spec> to add a general purpose decoder. For usage use -X help\n");
-    exit(1);
 }
 
 static void help(void)
@@ -448,7 +447,7 @@ static void help(void)
     exit(0);
 }
 
-static float parse_atoiv(char const *str, int def, char const *error_hint)
+static float parse_atoiv(char const *str, int def, char const *error_hint, int *err)
 {
     if (!str) {
         return def;
@@ -463,22 +462,24 @@ static float parse_atoiv(char const *str, int def, char const *error_hint)
 
     if (str == endptr) {
         fprintf(stderr, "%sinvalid number argument (%s)\n", error_hint, str);
-        exit(1);
+        *err = 1;
     }
 
     return val;
 }
 
-static float parse_float(char const *str, char const *error_hint)
+static float parse_float(char const *str, char const *error_hint, int *err)
 {
     if (!str) {
         fprintf(stderr, "%smissing number argument\n", error_hint);
-        exit(1);
+        *err = 1;
+        return 0;
     }
 
     if (!*str) {
         fprintf(stderr, "%sempty number argument\n", error_hint);
-        exit(1);
+        *err = 1;
+        return 0;
     }
 
     char *endptr;
@@ -486,19 +487,21 @@ static float parse_float(char const *str, char const *error_hint)
 
     if (str == endptr) {
         fprintf(stderr, "%sinvalid number argument (%s)\n", error_hint, str);
-        exit(1);
+        *err = 1;
+        return 0;
     }
 
     if (*endptr != '\0') {
         fprintf(stderr, "%strailing characters in number argument (%s)\n", error_hint, str);
-        exit(1);
+        *err = 1;
+        return 0;
     }
 
     return val;
 
 }
 
-static unsigned parse_modulation(char const *str)
+static unsigned parse_modulation(char const *str, int *err)
 {
     if (!strcasecmp(str, "OOK_MC_ZEROBIT"))
         return OOK_PULSE_MANCHESTER_ZEROBIT;
@@ -526,42 +529,46 @@ static unsigned parse_modulation(char const *str)
         return FSK_PULSE_MANCHESTER_ZEROBIT;
     else {
         fprintf(stderr, "Bad flex spec, unknown modulation!\n");
-        usage();
+        *err = 1;
     }
     return 0;
 }
 
 // used for match, preamble, getter, limited to 1024 bits (128 byte).
-static unsigned parse_bits(const char *code, uint8_t *bitrow)
+static unsigned parse_bits(const char *code, uint8_t *bitrow, int *err)
 {
     bitbuffer_t bits = {0};
     bitbuffer_parse(&bits, code);
     if (bits.num_rows != 1) {
         fprintf(stderr, "Bad flex spec, \"match\", \"preamble\", and getter mask need exactly one bit row (%d found)!\n", bits.num_rows);
-        usage();
+        *err = 1;
+        return 0;
     }
     unsigned len = bits.bits_per_row[0];
     if (len > 1024) {
         fprintf(stderr, "Bad flex spec, \"match\", \"preamble\", and getter mask may have up to 1024 bits (%u found)!\n", len);
-        usage();
+        *err = 1;
+        return 0;
     }
     memcpy(bitrow, bits.bb[0], (len + 7) / 8);
     return len;
 }
 
 // used for symbol decode, limited to 27 bits (32 - 5).
-static uint32_t parse_symbol(const char *code)
+static uint32_t parse_symbol(const char *code, int *err)
 {
     bitbuffer_t bits = {0};
     bitbuffer_parse(&bits, code);
     if (bits.num_rows != 1) {
         fprintf(stderr, "Bad flex spec, \"symbol\" needs exactly one bit row (%d found)!\n", bits.num_rows);
-        usage();
+        *err = 1;
+        return 0;
     }
     unsigned len = bits.bits_per_row[0];
     if (len > 27) {
         fprintf(stderr, "Bad flex spec, \"symbol\" may have up to 27 bits (%u found)!\n", len);
-        usage();
+        *err = 1;
+        return 0;
     }
     uint8_t *b = bits.bb[0];
     return ((uint32_t)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | (b[3] << 0) | len;
@@ -607,7 +614,7 @@ static const char *parse_map(const char *arg, struct flex_get *getter)
     return c;
 }
 
-static void parse_getter(char *arg, struct flex_get *getter)
+static void parse_getter(char *arg, struct flex_get *getter, int *err)
 {
     uint8_t bitrow[128];
     while (arg && *arg) {
@@ -621,7 +628,9 @@ static void parse_getter(char *arg, struct flex_get *getter)
         if (*arg == '@')
             getter->bit_offset = strtol(++arg, NULL, 0);
         else if (*arg == '{' || (*arg >= '0' && *arg <= '9')) {
-            getter->bit_count = parse_bits(arg, bitrow);
+            getter->bit_count = parse_bits(arg, bitrow, err);
+            if (*err)
+                return;
             getter->mask = extract_number(bitrow, 0, getter->bit_count);
         }
         else if (*arg == '%') {
@@ -640,7 +649,7 @@ static void parse_getter(char *arg, struct flex_get *getter)
     }
     if (!getter->name[0]) {
         fprintf(stderr, "Bad flex spec, \"get\" missing name!\n");
-        usage();
+        *err = 1;
     }
     /*
         fprintf(stderr, "parse_getter() bit_offset: %d bit_count: %d mask: %lx name: %s\n",
@@ -648,7 +657,7 @@ static void parse_getter(char *arg, struct flex_get *getter)
     */
 }
 
-static unsigned parse_uart_mode(char const *str)
+static unsigned parse_uart_mode(char const *str, int *err)
 {
     if (!strcasecmp(str, "8n1"))
         return UART_MODE_8N1;
@@ -658,11 +667,22 @@ static unsigned parse_uart_mode(char const *str)
         return UART_MODE_8O1;
     else {
         fprintf(stderr, "Bad flex spec, unknown uart mode!\n");
-        usage();
+        *err = 1;
     }
     return 0;
 }
 
+/// Free a decoder with a bad spec, @return NULL to pass on.
+static r_device *bad_spec(r_device *dev, char *spec)
+{
+    usage();
+    free(spec);
+    free(dev->decode_ctx);
+    free(dev);
+    return NULL;
+}
+
+/// Create a flex decoder, @return NULL on a bad spec or alloc failure.
 static r_device *flex_create_device(char const *spec)
 {
     if (!spec || !*spec || *spec == '?' || !strncasecmp(spec, "help", strlen(spec))) {
@@ -675,6 +695,7 @@ static r_device *flex_create_device(char const *spec)
     }
     struct flex_params *params = decoder_user_data(dev);
     int get_count = 0;
+    int err       = 0;
 
     char * mutable_spec = strdup(spec); // spec will be mutated by getkwargs()
     if (!mutable_spec)
@@ -705,86 +726,89 @@ static r_device *flex_create_device(char const *spec)
         }
 
         else if (!strcasecmp(key, "m") || !strcasecmp(key, "modulation"))
-            dev->modulation = parse_modulation(val);
+            dev->modulation = parse_modulation(val, &err);
         else if (!strcasecmp(key, "s") || !strcasecmp(key, "short"))
-            dev->short_width = parse_float(val, "short: ");
+            dev->short_width = parse_float(val, "short: ", &err);
         else if (!strcasecmp(key, "l") || !strcasecmp(key, "long"))
-            dev->long_width = parse_float(val, "long: ");
+            dev->long_width = parse_float(val, "long: ", &err);
         else if (!strcasecmp(key, "y") || !strcasecmp(key, "sync"))
-            dev->sync_width = parse_float(val, "sync: ");
+            dev->sync_width = parse_float(val, "sync: ", &err);
         else if (!strcasecmp(key, "g") || !strcasecmp(key, "gap"))
-            dev->gap_limit = parse_float(val, "gap: ");
+            dev->gap_limit = parse_float(val, "gap: ", &err);
         else if (!strcasecmp(key, "r") || !strcasecmp(key, "reset"))
-            dev->reset_limit = parse_float(val, "reset: ");
+            dev->reset_limit = parse_float(val, "reset: ", &err);
         else if (!strcasecmp(key, "t") || !strcasecmp(key, "tolerance"))
-            dev->tolerance = parse_float(val, "tolerance: ");
+            dev->tolerance = parse_float(val, "tolerance: ", &err);
         else if (!strcasecmp(key, "prio") || !strcasecmp(key, "priority"))
-            dev->priority = parse_atoiv(val, 0, "priority: ");
+            dev->priority = parse_atoiv(val, 0, "priority: ", &err);
 
         else if (!strcasecmp(key, "bits>"))
-            params->min_bits = parse_atoiv(val, 0, "bits: ");
+            params->min_bits = parse_atoiv(val, 0, "bits: ", &err);
         else if (!strcasecmp(key, "bits<"))
-            params->max_bits = parse_atoiv(val, 0, "bits: ");
+            params->max_bits = parse_atoiv(val, 0, "bits: ", &err);
         else if (!strcasecmp(key, "bits"))
-            params->min_bits = params->max_bits = parse_atoiv(val, 0, "bits:");
+            params->min_bits = params->max_bits = parse_atoiv(val, 0, "bits:", &err);
 
         else if (!strcasecmp(key, "rows>"))
-            params->min_rows = parse_atoiv(val, 0, "rows: ");
+            params->min_rows = parse_atoiv(val, 0, "rows: ", &err);
         else if (!strcasecmp(key, "rows<"))
-            params->max_rows = parse_atoiv(val, 0, "rows: ");
+            params->max_rows = parse_atoiv(val, 0, "rows: ", &err);
         else if (!strcasecmp(key, "rows"))
-            params->min_rows = params->max_rows = parse_atoiv(val, 0, "rows: ");
+            params->min_rows = params->max_rows = parse_atoiv(val, 0, "rows: ", &err);
 
         else if (!strcasecmp(key, "repeats>"))
-            params->min_repeats = parse_atoiv(val, 0, "repeats: ");
+            params->min_repeats = parse_atoiv(val, 0, "repeats: ", &err);
         else if (!strcasecmp(key, "repeats<"))
-            params->max_repeats = parse_atoiv(val, 0, "repeats: ");
+            params->max_repeats = parse_atoiv(val, 0, "repeats: ", &err);
         else if (!strcasecmp(key, "repeats"))
-            params->min_repeats = params->max_repeats = parse_atoiv(val, 0, "repeats: ");
+            params->min_repeats = params->max_repeats = parse_atoiv(val, 0, "repeats: ", &err);
 
         else if (!strcasecmp(key, "invert"))
-            params->invert = parse_atoiv(val, 1, "invert: ");
+            params->invert = parse_atoiv(val, 1, "invert: ", &err);
         else if (!strcasecmp(key, "reflect"))
-            params->reflect = parse_atoiv(val, 1, "reflect: ");
+            params->reflect = parse_atoiv(val, 1, "reflect: ", &err);
 
         else if (!strcasecmp(key, "match"))
-            params->match_len = parse_bits(val, params->match_bits);
+            params->match_len = parse_bits(val, params->match_bits, &err);
 
         else if (!strcasecmp(key, "preamble"))
-            params->preamble_len = parse_bits(val, params->preamble_bits);
+            params->preamble_len = parse_bits(val, params->preamble_bits, &err);
 
         else if (!strcasecmp(key, "countonly"))
-            params->count_only = parse_atoiv(val, 1, "countonly: ");
+            params->count_only = parse_atoiv(val, 1, "countonly: ", &err);
 
         else if (!strcasecmp(key, "unique"))
-            params->unique = parse_atoiv(val, 1, "unique: ");
+            params->unique = parse_atoiv(val, 1, "unique: ", &err);
 
         else if (!strcasecmp(key, "decode_uart"))
-            params->decode_uart = parse_uart_mode(val);
+            params->decode_uart = parse_uart_mode(val, &err);
         else if (!strcasecmp(key, "decode_dm"))
-            params->decode_dm = parse_atoiv(val, 1, "decode_dm: ");
+            params->decode_dm = parse_atoiv(val, 1, "decode_dm: ", &err);
         else if (!strcasecmp(key, "decode_mc"))
-            params->decode_mc = parse_atoiv(val, 1, "decode_mc: ");
+            params->decode_mc = parse_atoiv(val, 1, "decode_mc: ", &err);
 
         else if (!strcasecmp(key, "symbol_zero"))
-            params->symbol_zero = parse_symbol(val);
+            params->symbol_zero = parse_symbol(val, &err);
         else if (!strcasecmp(key, "symbol_one"))
-            params->symbol_one = parse_symbol(val);
+            params->symbol_one = parse_symbol(val, &err);
         else if (!strcasecmp(key, "symbol_sync"))
-            params->symbol_sync = parse_symbol(val);
+            params->symbol_sync = parse_symbol(val, &err);
 
         else if (!strcasecmp(key, "get")) {
             if (get_count < GETTER_SLOTS)
-                parse_getter(val, &params->getter[get_count++]);
+                parse_getter(val, &params->getter[get_count++], &err);
             else {
                 fprintf(stderr, "Maximum getter slots exceeded (%d)!\n", GETTER_SLOTS);
-                usage();
+                err = 1;
             }
 
         } else {
             fprintf(stderr, "Bad flex spec, unknown keyword (%s)!\n", key);
-            usage();
+            err = 1;
         }
+
+        if (err)
+            return bad_spec(dev, (char *)spec);
     }
 
     if (params->min_bits < params->match_len)
@@ -811,30 +835,30 @@ static r_device *flex_create_device(char const *spec)
 
     if (!params->name[0]) {
         fprintf(stderr, "Bad flex spec, missing name!\n");
-        usage();
+        return bad_spec(dev, (char *)spec);
     }
 
     if (!dev->modulation) {
         fprintf(stderr, "Bad flex spec, missing modulation!\n");
-        usage();
+        return bad_spec(dev, (char *)spec);
     }
 
     if (!dev->short_width) {
         fprintf(stderr, "Bad flex spec, missing short width!\n");
-        usage();
+        return bad_spec(dev, (char *)spec);
     }
 
     if (dev->modulation != OOK_PULSE_MANCHESTER_ZEROBIT
             && dev->modulation != FSK_PULSE_MANCHESTER_ZEROBIT) {
         if (!dev->long_width) {
             fprintf(stderr, "Bad flex spec, missing long width!\n");
-            usage();
+            return bad_spec(dev, (char *)spec);
         }
     }
 
     if (!dev->reset_limit) {
         fprintf(stderr, "Bad flex spec, missing reset limit!\n");
-        usage();
+        return bad_spec(dev, (char *)spec);
     }
 
     if (dev->modulation == OOK_PULSE_DMC
@@ -842,17 +866,17 @@ static r_device *flex_create_device(char const *spec)
             || dev->modulation == OOK_PULSE_PIWM_DC) {
         if (!dev->tolerance) {
             fprintf(stderr, "Bad flex spec, missing tolerance limit!\n");
-            usage();
+            return bad_spec(dev, (char *)spec);
         }
     }
 
     if (params->symbol_zero && !params->symbol_one) {
         fprintf(stderr, "Bad flex spec, symbol-one missing!\n");
-        usage();
+        return bad_spec(dev, (char *)spec);
     }
     if (params->symbol_one && !params->symbol_zero) {
         fprintf(stderr, "Bad flex spec, symbol-zero missing!\n");
-        usage();
+        return bad_spec(dev, (char *)spec);
     }
 
     /*
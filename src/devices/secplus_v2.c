@@ -252,21 +252,24 @@ Security+ 2.0 rolling code.
 @sa secplus_v2_decode_v2_half()
 */
 
-// Cache for accumulating two halves across separate callback invocations.
+// Cache per decoder instance for accumulating two halves across separate callback invocations.
 // The Security+ 2.0 protocol sends two packets (Set 1 and Set 2) separated
 // by ~10ms. The PCM demodulator delivers each as a separate callback.
 #define SECPLUS_V2_CACHE_TIMEOUT_US 800000 // 800ms max between halves
 
-static bitbuffer_t cached_fixed_1   = {0};
-static uint8_t cached_rolling_1[16] = {0};
-static bitbuffer_t cached_fixed_2   = {0};
-static uint8_t cached_rolling_2[16] = {0};
-static struct timeval cached_v2_tv  = {0};
-static int cached_v2_have_1 = 0;
-static int cached_v2_have_2 = 0;
+struct secplus_v2_context {
+    bitbuffer_t cached_fixed_1;
+    uint8_t cached_rolling_1[16];
+    bitbuffer_t cached_fixed_2;
+    uint8_t cached_rolling_2[16];
+    struct timeval cached_v2_tv;
+    int cached_v2_have_1;
+    int cached_v2_have_2;
+};
 
 static int secplus_v2_callback(r_device *decoder, bitbuffer_t *bitbuffer)
 {
+    struct secplus_v2_context *const context = decoder_user_data(decoder);
     unsigned search_index = 0;
     bitbuffer_t bits = {0};
     // int i            = 0;
@@ -324,9 +327,9 @@ static int secplus_v2_callback(r_device *decoder, bitbuffer_t *bitbuffer)
     if (fixed_1.bits_per_row[0] > 1 && fixed_2.bits_per_row[0] > 1) {
         // Got both halves, proceed to decode below
         // Also clear cache since we have a complete message
-        cached_v2_have_1 = 0;
-        cached_v2_have_2 = 0;
-        cached_v2_tv.tv_sec = 0;
+        context->cached_v2_have_1 = 0;
+        context->cached_v2_have_2 = 0;
+        context->cached_v2_tv.tv_sec = 0;
     }
     else {
         // Only got one half - cache it and wait for the other
@@ -334,40 +337,40 @@ static int secplus_v2_callback(r_device *decoder, bitbuffer_t *bitbuffer)
         gettimeofday(&cur_tv, NULL);
 
         if (fixed_1.bits_per_row[0] > 1) {
-            memcpy(&cached_fixed_1, &fixed_1, sizeof(bitbuffer_t));
-            memcpy(cached_rolling_1, rolling_1, sizeof(cached_rolling_1));
-            cached_v2_have_1 = 1;
-            cached_v2_tv = cur_tv;
+            memcpy(&context->cached_fixed_1, &fixed_1, sizeof(bitbuffer_t));
+            memcpy(context->cached_rolling_1, rolling_1, sizeof(context->cached_rolling_1));
+            context->cached_v2_have_1 = 1;
+            context->cached_v2_tv = cur_tv;
             decoder_log(decoder, 1, __func__, "Cached Set 1, waiting for Set 2");
         }
         if (fixed_2.bits_per_row[0] > 1) {
-            memcpy(&cached_fixed_2, &fixed_2, sizeof(bitbuffer_t));
-            memcpy(cached_rolling_2, rolling_2, sizeof(cached_rolling_2));
-            cached_v2_have_2 = 1;
-            cached_v2_tv = cur_tv;
+            memcpy(&context->cached_fixed_2, &fixed_2, sizeof(bitbuffer_t));
+            memcpy(context->cached_rolling_2, rolling_2, sizeof(context->cached_rolling_2));
+            context->cached_v2_have_2 = 1;
+            context->cached_v2_tv = cur_tv;
             decoder_log(decoder, 1, __func__, "Cached Set 2, waiting for Set 1");
         }
 
         // Check if the other half is in the cache
-        if (cached_v2_have_1 && cached_v2_have_2) {
+        if (context->cached_v2_have_1 && context->cached_v2_have_2) {
             struct timeval res_tv;
-            timeval_subtract(&res_tv, &cur_tv, &cached_v2_tv);
+            timeval_subtract(&res_tv, &cur_tv, &context->cached_v2_tv);
             if (res_tv.tv_sec == 0 && res_tv.tv_usec < SECPLUS_V2_CACHE_TIMEOUT_US) {
                 // Use cached halves
-                memcpy(&fixed_1, &cached_fixed_1, sizeof(bitbuffer_t));
-                memcpy(rolling_1, cached_rolling_1, sizeof(rolling_1));
-                memcpy(&fixed_2, &cached_fixed_2, sizeof(bitbuffer_t));
-                memcpy(rolling_2, cached_rolling_2, sizeof(rolling_2));
-                cached_v2_have_1 = 0;
-                cached_v2_have_2 = 0;
-                cached_v2_tv.tv_sec = 0;
+                memcpy(&fixed_1, &context->cached_fixed_1, sizeof(bitbuffer_t));
+                memcpy(rolling_1, context->cached_rolling_1, sizeof(rolling_1));
+                memcpy(&fixed_2, &context->cached_fixed_2, sizeof(bitbuffer_t));
+                memcpy(rolling_2, context->cached_rolling_2, sizeof(rolling_2));
+                context->cached_v2_have_1 = 0;
+                context->cached_v2_have_2 = 0;
+                context->cached_v2_tv.tv_sec = 0;
                 decoder_log(decoder, 1, __func__, "Combined cached halves");
             }
             else {
                 // Cache too old, discard
-                cached_v2_have_1 = 0;
-                cached_v2_have_2 = 0;
-                cached_v2_tv.tv_sec = 0;
+                context->cached_v2_have_1 = 0;
+                context->cached_v2_have_2 = 0;
+                context->cached_v2_tv.tv_sec = 0;
                 decoder_log(decoder, 1, __func__, "Cache expired");
                 return DECODE_FAIL_SANITY;
             }
@@ -474,6 +477,14 @@ static char const *const output_fields[] = {
 //      Freq 310.01M
 //  -X "n=vI3,m=OOK_PCM,s=230,l=230,t=40,r=10000,g=7400,match={24}0xaaaa9560"
 
+r_device const secplus_v2;
+
+static r_device *secplus_v2_create(char const *arg)
+{
+    (void)arg;
+    return decoder_create(&secplus_v2, sizeof(struct secplus_v2_context));
+}
+
 r_device const secplus_v2 = {
         .name        = "Security+ 2.0 (Keyfob)",
         .modulation  = OOK_PULSE_PCM,
@@ -483,5 +494,6 @@ r_device const secplus_v2 = {
         .gap_limit   = 1500,
         .reset_limit = 9000,
         .decode_fn   = &secplus_v2_callback,
+        .create_fn   = &secplus_v2_create,
         .fields      = output_fields,
 };
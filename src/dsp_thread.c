@@ -0,0 +1,619 @@
+/** @file
+    Demodulation pipeline threads fed by a lock-free ring of IQ frames.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "dsp_thread.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "logger.h"
+#include "fatal.h"
+
+#ifdef THREADS
+
+#include <signal.h>
+
+#include "compat_pthread.h"
+#include "compat_atomic.h"
+#include "spsc_ring.h"
+
+/// The pipeline of the current thread, NULL on other threads.
+static THREAD_LOCAL dsp_thread_t *current_dsp;
+/// The event ring of the current pipeline thread, NULL on other threads.
+static THREAD_LOCAL spsc_ring_t *event_ring;
+/// The package being sliced on the current thread.
+static THREAD_LOCAL void *current_package;
+/// The processing lock held by the current pipeline thread, released while it waits.
+static THREAD_LOCAL pthread_mutex_t *processing_lock;
+
+/// A slot for a queued IQ frame.
+typedef struct dsp_frame {
+    uint32_t len;
+    uint32_t sample_rate;
+    uint32_t center_frequency;
+    iq_frame_t *iq; ///< retained while queued and processed
+} dsp_frame_t;
+
+/// A condition to wait on until a ring has elements.
+typedef struct dsp_waiter {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned waiting; ///< the consumer is waiting, the producer needs to signal
+} dsp_waiter_t;
+
+struct dsp_thread {
+    pthread_t thread;
+    pthread_t slicer_thread;
+    pthread_mutex_t frame_lock;   ///< held while processing a frame
+    pthread_mutex_t package_lock; ///< held while slicing a package
+    dsp_waiter_t frame_wait;      ///< the DSP thread waits for frames
+    dsp_waiter_t package_wait;    ///< the slicer thread waits for packages
+    dsp_waiter_t spare_wait;      ///< the DSP thread waits for spare packages
+    dsp_waiter_t events_wait;     ///< the DSP thread waits for event slots
+    dsp_waiter_t slicer_wait;     ///< the slicer thread waits for event slots
+    unsigned wake_pending;        ///< the event loop was woken and did not pop all events yet
+    unsigned exit;
+
+    dsp_frame_fn frame_fn;
+    dsp_package_fn package_fn;
+    dsp_wake_fn wake_fn;
+    void *ctx;
+
+    dsp_frame_t *frames;         ///< the frame slots
+    spsc_ring_t *spare;          ///< empty frames, DSP thread to acquire thread
+    spsc_ring_t *queued;         ///< filled frames, acquire thread to DSP thread
+    unsigned char *package_buf;  ///< the package pool, zeroed on creation
+    unsigned n_packages;         ///< the number of packages in the pool
+    size_t package_size;         ///< the size of a package in the pool
+    spsc_ring_t *spare_packages; ///< empty packages, slicer thread to DSP thread
+    spsc_ring_t *packages;       ///< filled packages, DSP thread to slicer thread
+    spsc_ring_t *events;         ///< events, DSP thread to event loop
+    spsc_ring_t *slicer_events;  ///< events, slicer thread to event loop
+    unsigned frames_dropped;     ///< written by the acquire thread
+    unsigned packages_stalled;   ///< written by the DSP thread
+    unsigned events_stalled;     ///< written by the DSP and slicer threads
+    unsigned events_dropped;     ///< written by the DSP and slicer threads
+};
+
+static void waiter_init(dsp_waiter_t *w)
+{
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->cond, NULL);
+}
+
+static void waiter_destroy(dsp_waiter_t *w)
+{
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->cond);
+}
+
+/** Wait until the ring depth changes from @p depth or the pipeline exits.
+
+    A depth of 0 waits for elements, called by the consumer of the ring,
+    a depth of the ring size waits for free slots, called by the producer of the ring.
+*/
+static void waiter_wait(dsp_thread_t *dsp, dsp_waiter_t *w, spsc_ring_t *ring, unsigned depth)
+{
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        // recheck after announcing the wait, a push in between will signal
+        ATOMIC_EXCHANGE(&w->waiting, 1);
+        if (ATOMIC_LOAD_ACQUIRE(&dsp->exit) || spsc_ring_depth(ring) != depth) {
+            break;
+        }
+        pthread_cond_wait(&w->cond, &w->lock);
+    }
+    ATOMIC_EXCHANGE(&w->waiting, 0);
+    pthread_mutex_unlock(&w->lock);
+}
+
+/// Signal a waiting consumer after a push, or a waiting producer after a pop.
+static void waiter_notify(dsp_waiter_t *w)
+{
+    // only take the lock if the consumer might be waiting
+    if (ATOMIC_EXCHANGE(&w->waiting, 0)) {
+        pthread_mutex_lock(&w->lock);
+        pthread_cond_signal(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+    }
+}
+
+/// Signal a consumer to exit.
+static void waiter_exit(dsp_waiter_t *w)
+{
+    pthread_mutex_lock(&w->lock);
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void wake_event_loop(dsp_thread_t *dsp)
+{
+    // wake at most once until the event loop popped all events
+    if (!ATOMIC_EXCHANGE(&dsp->wake_pending, 1)) {
+        dsp->wake_fn(dsp->ctx);
+    }
+}
+
+static THREAD_RETURN THREAD_CALL dsp_thread_run(void *arg)
+{
+    dsp_thread_t *dsp = arg;
+    current_dsp       = dsp;
+    event_ring        = dsp->events;
+    processing_lock   = &dsp->frame_lock;
+
+    while (!ATOMIC_LOAD_ACQUIRE(&dsp->exit)) {
+        dsp_frame_t *frame = spsc_ring_pop(dsp->queued);
+        if (!frame) {
+            waiter_wait(dsp, &dsp->frame_wait, dsp->queued, 0);
+            continue;
+        }
+
+        pthread_mutex_lock(&dsp->frame_lock);
+        dsp->frame_fn(dsp->ctx, frame->iq, frame->len, frame->sample_rate, frame->center_frequency);
+        pthread_mutex_unlock(&dsp->frame_lock);
+
+        iq_frame_release(frame->iq);
+        frame->iq = NULL;
+
+        spsc_ring_push(dsp->spare, frame); // can't fail, the ring holds all frames
+        wake_event_loop(dsp);
+    }
+
+    return (THREAD_RETURN)0;
+}
+
+static THREAD_RETURN THREAD_CALL dsp_slicer_run(void *arg)
+{
+    dsp_thread_t *dsp = arg;
+    current_dsp       = dsp;
+    event_ring        = dsp->slicer_events;
+    processing_lock   = &dsp->package_lock;
+
+    while (!ATOMIC_LOAD_ACQUIRE(&dsp->exit)) {
+        void *package = spsc_ring_pop(dsp->packages);
+        if (!package) {
+            waiter_wait(dsp, &dsp->package_wait, dsp->packages, 0);
+            continue;
+        }
+
+        pthread_mutex_lock(&dsp->package_lock);
+        current_package = package;
+        dsp->package_fn(dsp->ctx, package);
+        current_package = NULL;
+        pthread_mutex_unlock(&dsp->package_lock);
+
+        spsc_ring_push(dsp->spare_packages, package); // can't fail, the ring holds all packages
+        waiter_notify(&dsp->spare_wait);
+        wake_event_loop(dsp);
+    }
+
+    return (THREAD_RETURN)0;
+}
+
+static void free_pipeline(dsp_thread_t *dsp)
+{
+    spsc_ring_free(dsp->spare);
+    spsc_ring_free(dsp->queued);
+    spsc_ring_free(dsp->spare_packages);
+    spsc_ring_free(dsp->packages);
+    spsc_ring_free(dsp->events);
+    spsc_ring_free(dsp->slicer_events);
+    free(dsp->package_buf);
+    free(dsp->frames);
+    free(dsp);
+}
+
+static int start_thread(pthread_t *thread, THREAD_RETURN (THREAD_CALL *fn)(void *), void *arg)
+{
+#ifndef _WIN32
+    // Block all signals from the worker thread
+    sigset_t sigset;
+    sigset_t oldset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_SETMASK, &sigset, &oldset);
+#endif
+    int r = pthread_create(thread, NULL, fn, arg);
+#ifndef _WIN32
+    pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+#endif
+    if (r) {
+        print_logf(LOG_ERROR, "DSP", "Error in pthread_create, rc: %d", r);
+    }
+    return r;
+}
+
+dsp_thread_t *dsp_thread_start(unsigned n_frames, dsp_frame_fn frame_fn,
+        unsigned n_packages, size_t package_size, dsp_package_fn package_fn,
+        unsigned n_events, dsp_wake_fn wake_fn, void *ctx)
+{
+    dsp_thread_t *dsp = calloc(1, sizeof(*dsp));
+    if (!dsp) {
+        WARN_CALLOC("dsp_thread_start()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    dsp->frame_fn   = frame_fn;
+    dsp->package_fn = n_packages ? package_fn : NULL;
+    dsp->wake_fn    = wake_fn;
+    dsp->ctx        = ctx;
+
+    dsp->frames = calloc(n_frames, sizeof(*dsp->frames));
+    if (!dsp->frames) {
+        WARN_CALLOC("dsp_thread_start()");
+        free(dsp);
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    dsp->spare         = spsc_ring_create(n_frames);
+    dsp->queued        = spsc_ring_create(n_frames);
+    dsp->events        = spsc_ring_create(n_events);
+    dsp->slicer_events = spsc_ring_create(n_events);
+    if (!dsp->spare || !dsp->queued || !dsp->events || !dsp->slicer_events) {
+        free_pipeline(dsp);
+        return NULL;
+    }
+    for (unsigned i = 0; i < n_frames; ++i) {
+        spsc_ring_push(dsp->spare, &dsp->frames[i]);
+    }
+    dsp->spare->high_water = 0; // only meaningful for the other rings
+
+    if (dsp->package_fn) {
+        dsp->package_buf = calloc(n_packages, package_size);
+        if (!dsp->package_buf) {
+            WARN_CALLOC("dsp_thread_start()");
+            free_pipeline(dsp);
+            return NULL; // NOTE: returns NULL on alloc failure.
+        }
+        dsp->n_packages   = n_packages;
+        dsp->package_size = package_size;
+        dsp->spare_packages = spsc_ring_create(n_packages);
+        dsp->packages       = spsc_ring_create(n_packages);
+        if (!dsp->spare_packages || !dsp->packages) {
+            free_pipeline(dsp);
+            return NULL;
+        }
+        for (unsigned i = 0; i < n_packages; ++i) {
+            spsc_ring_push(dsp->spare_packages, &dsp->package_buf[i * package_size]);
+        }
+        dsp->spare_packages->high_water = 0; // only meaningful for the other rings
+    }
+
+    pthread_mutex_init(&dsp->frame_lock, NULL);
+    pthread_mutex_init(&dsp->package_lock, NULL);
+    waiter_init(&dsp->frame_wait);
+    waiter_init(&dsp->package_wait);
+    waiter_init(&dsp->spare_wait);
+    waiter_init(&dsp->events_wait);
+    waiter_init(&dsp->slicer_wait);
+
+    // start the consumer first, the DSP thread might push packages right away
+    int r = dsp->package_fn ? start_thread(&dsp->slicer_thread, dsp_slicer_run, dsp) : 0;
+    if (!r) {
+        r = start_thread(&dsp->thread, dsp_thread_run, dsp);
+        if (r && dsp->package_fn) {
+            ATOMIC_EXCHANGE(&dsp->exit, 1);
+            waiter_exit(&dsp->package_wait);
+            pthread_join(dsp->slicer_thread, NULL);
+        }
+    }
+    if (r) {
+        pthread_mutex_destroy(&dsp->frame_lock);
+        pthread_mutex_destroy(&dsp->package_lock);
+        waiter_destroy(&dsp->frame_wait);
+        waiter_destroy(&dsp->package_wait);
+        waiter_destroy(&dsp->spare_wait);
+        waiter_destroy(&dsp->events_wait);
+        waiter_destroy(&dsp->slicer_wait);
+        free_pipeline(dsp);
+        return NULL;
+    }
+
+    return dsp;
+}
+
+void dsp_thread_stop(dsp_thread_t *dsp)
+{
+    if (!dsp) {
+        return;
+    }
+
+    ATOMIC_EXCHANGE(&dsp->exit, 1);
+    waiter_exit(&dsp->frame_wait);
+    waiter_exit(&dsp->spare_wait);
+    waiter_exit(&dsp->package_wait);
+    waiter_exit(&dsp->events_wait);
+    waiter_exit(&dsp->slicer_wait);
+    pthread_join(dsp->thread, NULL);
+    if (dsp->package_fn) {
+        pthread_join(dsp->slicer_thread, NULL);
+    }
+}
+
+void dsp_thread_foreach_package(dsp_thread_t *dsp, void (*fn)(void *package))
+{
+    if (!dsp) {
+        return;
+    }
+    for (unsigned i = 0; i < dsp->n_packages; ++i) {
+        fn(&dsp->package_buf[i * dsp->package_size]);
+    }
+}
+
+void dsp_thread_free(dsp_thread_t *dsp)
+{
+    if (!dsp) {
+        return;
+    }
+
+    unsigned events = spsc_ring_depth(dsp->events) + spsc_ring_depth(dsp->slicer_events);
+    if (events) {
+        print_logf(LOG_WARNING, "DSP", "%u events not popped", events);
+    }
+
+    // return the frames still queued to their pool
+    for (dsp_frame_t *frame; (frame = spsc_ring_pop(dsp->queued));) {
+        iq_frame_release(frame->iq);
+    }
+
+    pthread_mutex_destroy(&dsp->frame_lock);
+    pthread_mutex_destroy(&dsp->package_lock);
+    waiter_destroy(&dsp->frame_wait);
+    waiter_destroy(&dsp->package_wait);
+    waiter_destroy(&dsp->spare_wait);
+    waiter_destroy(&dsp->events_wait);
+    waiter_destroy(&dsp->slicer_wait);
+    free_pipeline(dsp);
+}
+
+int dsp_thread_push_frame(dsp_thread_t *dsp, iq_frame_t *iq, uint32_t len, uint32_t sample_rate, uint32_t center_frequency)
+{
+    dsp_frame_t *frame = spsc_ring_pop(dsp->spare);
+    if (!frame) {
+        ATOMIC_FETCH_ADD(&dsp->frames_dropped, 1);
+        return -1;
+    }
+    iq_frame_retain(iq);
+    frame->iq               = iq;
+    frame->len              = len;
+    frame->sample_rate      = sample_rate;
+    frame->center_frequency = center_frequency;
+    spsc_ring_push(dsp->queued, frame); // can't fail, the ring holds all frames
+
+    waiter_notify(&dsp->frame_wait);
+    return 0;
+}
+
+int dsp_thread_sliced(dsp_thread_t *dsp)
+{
+    return dsp && dsp->package_fn && event_ring == dsp->events;
+}
+
+void *dsp_thread_get_package(dsp_thread_t *dsp)
+{
+    void *package = spsc_ring_pop(dsp->spare_packages);
+    if (!package) {
+        // backpressure, the frame ring buffers the input meanwhile
+        ATOMIC_FETCH_ADD(&dsp->packages_stalled, 1);
+        // the slicer might wait for the event loop, which might wait for the processing lock
+        pthread_mutex_unlock(processing_lock);
+        do {
+            waiter_wait(dsp, &dsp->spare_wait, dsp->spare_packages, 0);
+            package = spsc_ring_pop(dsp->spare_packages);
+        } while (!package && !ATOMIC_LOAD_ACQUIRE(&dsp->exit));
+        pthread_mutex_lock(processing_lock);
+    }
+    return package;
+}
+
+void dsp_thread_push_package(dsp_thread_t *dsp, void *package)
+{
+    spsc_ring_push(dsp->packages, package); // can't fail, the ring holds all packages
+    waiter_notify(&dsp->package_wait);
+}
+
+void *dsp_thread_package(void)
+{
+    return current_package;
+}
+
+int dsp_thread_push_event(void *event)
+{
+    // the pipeline of this thread, the event might belong to another input's config
+    dsp_thread_t *dsp = current_dsp;
+    if (!spsc_ring_push(event_ring, event)) {
+        return 0;
+    }
+
+    // backpressure, the event loop is too slow, wait for it to pop events
+    ATOMIC_FETCH_ADD(&dsp->events_stalled, 1);
+    dsp_waiter_t *w = event_ring == dsp->events ? &dsp->events_wait : &dsp->slicer_wait;
+    // the event loop might wait for the processing lock
+    pthread_mutex_unlock(processing_lock);
+    int r;
+    do {
+        wake_event_loop(dsp);
+        waiter_wait(dsp, w, event_ring, event_ring->size);
+        r = spsc_ring_push(event_ring, event);
+    } while (r && !ATOMIC_LOAD_ACQUIRE(&dsp->exit));
+    pthread_mutex_lock(processing_lock);
+
+    if (r) {
+        ATOMIC_FETCH_ADD(&dsp->events_dropped, 1); // only on stop
+    }
+    return r;
+}
+
+static void *pop_any_event(dsp_thread_t *dsp)
+{
+    void *event = spsc_ring_pop(dsp->events);
+    if (event) {
+        waiter_notify(&dsp->events_wait);
+        return event;
+    }
+    event = spsc_ring_pop(dsp->slicer_events);
+    if (event) {
+        waiter_notify(&dsp->slicer_wait);
+    }
+    return event;
+}
+
+void *dsp_thread_pop_event(dsp_thread_t *dsp)
+{
+    void *event = pop_any_event(dsp);
+    if (!event) {
+        // allow a new wake up, then recheck for an event pushed in between
+        ATOMIC_EXCHANGE(&dsp->wake_pending, 0);
+        event = pop_any_event(dsp);
+    }
+    return event;
+}
+
+int dsp_thread_current(void)
+{
+    return event_ring != NULL;
+}
+
+void dsp_thread_lock(dsp_thread_t *dsp)
+{
+    if (dsp) {
+        pthread_mutex_lock(&dsp->frame_lock);
+        pthread_mutex_lock(&dsp->package_lock);
+    }
+}
+
+void dsp_thread_unlock(dsp_thread_t *dsp)
+{
+    if (dsp) {
+        pthread_mutex_unlock(&dsp->package_lock);
+        pthread_mutex_unlock(&dsp->frame_lock);
+    }
+}
+
+void dsp_thread_stats(dsp_thread_t *dsp, dsp_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (!dsp) {
+        return;
+    }
+    stats->frames_size       = dsp->queued->size;
+    stats->frames_depth      = spsc_ring_depth(dsp->queued);
+    stats->frames_high_water = dsp->queued->high_water;
+    stats->frames_dropped    = ATOMIC_LOAD_ACQUIRE(&dsp->frames_dropped);
+    if (dsp->package_fn) {
+        stats->packages_size       = dsp->packages->size;
+        stats->packages_depth      = spsc_ring_depth(dsp->packages);
+        stats->packages_high_water = dsp->packages->high_water;
+        stats->packages_stalled    = ATOMIC_LOAD_ACQUIRE(&dsp->packages_stalled);
+    }
+    stats->events_size       = dsp->events->size + dsp->slicer_events->size;
+    stats->events_depth      = spsc_ring_depth(dsp->events) + spsc_ring_depth(dsp->slicer_events);
+    stats->events_high_water = dsp->events->high_water + dsp->slicer_events->high_water;
+    stats->events_stalled    = ATOMIC_LOAD_ACQUIRE(&dsp->events_stalled);
+    stats->events_dropped    = ATOMIC_LOAD_ACQUIRE(&dsp->events_dropped);
+}
+
+#else /* !THREADS */
+
+dsp_thread_t *dsp_thread_start(unsigned n_frames, dsp_frame_fn frame_fn,
+        unsigned n_packages, size_t package_size, dsp_package_fn package_fn,
+        unsigned n_events, dsp_wake_fn wake_fn, void *ctx)
+{
+    (void)n_frames;
+    (void)frame_fn;
+    (void)n_packages;
+    (void)package_size;
+    (void)package_fn;
+    (void)n_events;
+    (void)wake_fn;
+    (void)ctx;
+    return NULL; // demodulate on the event loop
+}
+
+void dsp_thread_stop(dsp_thread_t *dsp)
+{
+    (void)dsp;
+}
+
+void dsp_thread_foreach_package(dsp_thread_t *dsp, void (*fn)(void *package))
+{
+    (void)dsp;
+    (void)fn;
+}
+
+void dsp_thread_free(dsp_thread_t *dsp)
+{
+    (void)dsp;
+}
+
+int dsp_thread_push_frame(dsp_thread_t *dsp, iq_frame_t *iq, uint32_t len, uint32_t sample_rate, uint32_t center_frequency)
+{
+    (void)dsp;
+    (void)iq;
+    (void)len;
+    (void)sample_rate;
+    (void)center_frequency;
+    return -1;
+}
+
+int dsp_thread_sliced(dsp_thread_t *dsp)
+{
+    (void)dsp;
+    return 0;
+}
+
+void *dsp_thread_get_package(dsp_thread_t *dsp)
+{
+    (void)dsp;
+    return NULL;
+}
+
+void dsp_thread_push_package(dsp_thread_t *dsp, void *package)
+{
+    (void)dsp;
+    (void)package;
+}
+
+void *dsp_thread_package(void)
+{
+    return NULL;
+}
+
+int dsp_thread_push_event(void *event)
+{
+    (void)event;
+    return -1;
+}
+
+void *dsp_thread_pop_event(dsp_thread_t *dsp)
+{
+    (void)dsp;
+    return NULL;
+}
+
+int dsp_thread_current(void)
+{
+    return 0;
+}
+
+void dsp_thread_lock(dsp_thread_t *dsp)
+{
+    (void)dsp;
+}
+
+void dsp_thread_unlock(dsp_thread_t *dsp)
+{
+    (void)dsp;
+}
+
+void dsp_thread_stats(dsp_thread_t *dsp, dsp_stats_t *stats)
+{
+    (void)dsp;
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif /* THREADS */
@@ -100,6 +100,8 @@ or `(echo "GET /stream HTTP/1.0\n"; sleep 600) | socat - tcp:127.0.0.1:8433`
 #include "r_device.h" // used for protocols
 #include "r_private.h" // used for protocols
 #include "r_util.h"
+#include "sdr.h"
+#include "dsp_thread.h"
 #include "optparse.h"
 #include "abuf.h"
 #include "list.h" // used for protocols
@@ -790,7 +792,14 @@ static void handle_openmetrics(struct mg_connection *nc, struct http_message *hm
     time_t now;
     time(&now);
 
-    char buf[2000];
+    // frames are dropped by the SDR if all frames are in use, or by the DSP thread if its ring is full
+    sdr_stats_t input;
+    sdr_get_stats(cfg->dev, &input);
+    dsp_stats_t dsp;
+    dsp_thread_stats(cfg->dsp, &dsp);
+    unsigned dropped = input.frames_dropped + dsp.frames_dropped;
+
+    char buf[3000];
     int len = snprintf(buf, sizeof(buf),
             "# TYPE uptime_seconds counter\n"
             "# UNIT uptime_seconds seconds\n"
@@ -813,6 +822,10 @@ static void handle_openmetrics(struct mg_connection *nc, struct http_message *hm
             "# UNIT input_squelch_frames frames\n"
             "# HELP input_squelch_frames Number of SDR frames skipped by squelch.\n"
             "input_squelch_frames_total %u\n"
+            "# TYPE input_probed_frames counter\n"
+            "# UNIT input_probed_frames frames\n"
+            "# HELP input_probed_frames Number of SDR frames skipped by squelch from a subsampled level probe alone.\n"
+            "input_probed_frames_total %u\n"
             "# TYPE input_ook_frames counter\n"
             "# UNIT input_ook_frames frames\n"
             "# HELP input_ook_frames Number of SDR frames with OOK demodulation.\n"
@@ -825,6 +838,25 @@ static void handle_openmetrics(struct mg_connection *nc, struct http_message *hm
             "# UNIT input_event_frames frames\n"
             "# HELP input_event_frames Number of SDR frames with decode events.\n"
             "input_event_frames_total %u\n"
+            "# TYPE input_produced_frames counter\n"
+            "# UNIT input_produced_frames frames\n"
+            "# HELP input_produced_frames Number of SDR frames delivered by the receiver.\n"
+            "input_produced_frames_total %u\n"
+            "# TYPE input_dropped_frames counter\n"
+            "# UNIT input_dropped_frames frames\n"
+            "# HELP input_dropped_frames Number of SDR frames dropped because processing fell behind.\n"
+            "input_dropped_frames_total %u\n"
+            "# TYPE input_overflows counter\n"
+            "# HELP input_overflows Number of receiver overflows, samples were lost before reading.\n"
+            "input_overflows_total %u\n"
+            "# TYPE input_lag_max_frames gauge\n"
+            "# UNIT input_lag_max_frames frames\n"
+            "# HELP input_lag_max_frames Most SDR frames waiting for or in processing at once.\n"
+            "input_lag_max_frames %u\n"
+            "# TYPE input_lag_max_seconds gauge\n"
+            "# UNIT input_lag_max_seconds seconds\n"
+            "# HELP input_lag_max_seconds Most SDR frames waiting for or in processing at once, in seconds of samples.\n"
+            "input_lag_max_seconds %.3f\n"
             "# EOF\n",
             (float)(now - cfg->demod->running_since), // uptime_seconds_total,
             (float)cfg->demod->running_since,         // uptime_seconds_created,
@@ -833,9 +865,15 @@ static void handle_openmetrics(struct mg_connection *nc, struct http_message *hm
             (float)cfg->sdr_since,                    // input_uptime_seconds_created,
             cfg->demod->total_frames_count,           // input_count_frames_total,
             cfg->demod->total_frames_squelch,         // input_squelch_frames_total,
+            cfg->demod->total_frames_probed,          // input_probed_frames_total,
             cfg->demod->total_frames_ook,             // input_ook_frames_total,
             cfg->demod->total_frames_fsk,             // input_fsk_frames_total,
-            cfg->demod->total_frames_events);         // input_event_frames_total,
+            cfg->demod->total_frames_events,          // input_event_frames_total,
+            input.frames_produced,                    // input_produced_frames_total,
+            dropped,                                  // input_dropped_frames_total,
+            input.overflows,                          // input_overflows_total,
+            input.lag_max,                            // input_lag_max_frames,
+            input.lag_max_ms * 0.001);                // input_lag_max_seconds,
 
     mg_printf(nc,
             "HTTP/1.1 200 OK\r\n"
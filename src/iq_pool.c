@@ -0,0 +1,169 @@
+/** @file
+    Pool of refcounted IQ frames, leased by the acquire thread to the consumers.
+
+    The producer scans round-robin for a frame without references, an acquire
+    load of the count pairs with the release of the last reference so the
+    consumers are done reading before the frame is filled again.
+    Frames can outlive the owner, e.g. queued frames when a device is closed,
+    the pool memory is freed with the last leased frame.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "iq_pool.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "compat_atomic.h"
+#include "fatal.h"
+
+iq_pool_t *iq_pool_create(unsigned n_frames, size_t frame_size)
+{
+    iq_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        WARN_CALLOC("iq_pool_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    pool->frames = calloc(n_frames, sizeof(*pool->frames));
+    if (!pool->frames) {
+        WARN_CALLOC("iq_pool_create()");
+        free(pool);
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    pool->frame_buf = malloc(n_frames * frame_size);
+    if (!pool->frame_buf) {
+        WARN_MALLOC("iq_pool_create()");
+        free(pool->frames);
+        free(pool);
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    pool->n_frames   = n_frames;
+    pool->frame_size = frame_size;
+    pool->users      = 1;
+    for (unsigned i = 0; i < n_frames; ++i) {
+        pool->frames[i].pool = pool;
+        pool->frames[i].buf  = &pool->frame_buf[i * frame_size];
+    }
+
+    return pool;
+}
+
+static void pool_unuse(iq_pool_t *pool)
+{
+    if (ATOMIC_FETCH_SUB_ACQ_REL(&pool->users, 1) != 1) {
+        return;
+    }
+    free(pool->frame_buf);
+    free(pool->frames);
+    free(pool);
+}
+
+void iq_pool_free(iq_pool_t *pool)
+{
+    if (!pool) {
+        return;
+    }
+    pool_unuse(pool);
+}
+
+iq_frame_t *iq_pool_lease(iq_pool_t *pool)
+{
+    for (unsigned i = 0; i < pool->n_frames; ++i) {
+        unsigned idx      = (pool->next + i) % pool->n_frames;
+        iq_frame_t *frame = &pool->frames[idx];
+        if (ATOMIC_LOAD_ACQUIRE(&frame->refs) == 0) {
+            // the owner is one user, the previous count is the number of leased frames with this one
+            unsigned leased = ATOMIC_FETCH_ADD(&pool->users, 1);
+            if (leased > pool->high_water) {
+                ATOMIC_STORE_RELEASE(&pool->high_water, leased); // read by the stats
+            }
+            ATOMIC_STORE_RELEASE(&frame->refs, 1);
+            pool->next = idx + 1;
+            return frame;
+        }
+    }
+    ATOMIC_FETCH_ADD(&pool->exhausted, 1);
+    return NULL;
+}
+
+void iq_frame_retain(iq_frame_t *frame)
+{
+    ATOMIC_FETCH_ADD(&frame->refs, 1);
+}
+
+void iq_frame_release(iq_frame_t *frame)
+{
+    if (!frame) {
+        return;
+    }
+    if (ATOMIC_FETCH_SUB_ACQ_REL(&frame->refs, 1) == 1) {
+        pool_unuse(frame->pool);
+    }
+}
+
+#ifdef _TEST
+#define ASSERT_EQUALS(a, b) \
+    do { \
+        if ((a) == (b)) \
+            ++passed; \
+        else { \
+            ++failed; \
+            fprintf(stderr, "FAIL: %d <> %d\n", (int)(a), (int)(b)); \
+        } \
+    } while (0)
+
+int main(void)
+{
+    unsigned passed = 0;
+    unsigned failed = 0;
+    iq_frame_t *frames[4];
+
+    fprintf(stderr, "iq_pool::iq_pool_lease(): lease all frames and exhaust\n");
+    iq_pool_t *pool = iq_pool_create(3, 16);
+    for (int i = 0; i < 3; ++i) {
+        frames[i] = iq_pool_lease(pool);
+        ASSERT_EQUALS(frames[i] != NULL, 1);
+        ASSERT_EQUALS(frames[i]->refs, 1);
+    }
+    ASSERT_EQUALS(frames[0]->buf + 16 == frames[1]->buf, 1);
+    ASSERT_EQUALS(iq_pool_lease(pool) == NULL, 1);
+    ASSERT_EQUALS(pool->exhausted, 1);
+    ASSERT_EQUALS(pool->users, 4);
+    ASSERT_EQUALS(pool->high_water, 3);
+
+    fprintf(stderr, "iq_pool::iq_frame_release(): a retained frame is not leased again\n");
+    iq_frame_retain(frames[1]);
+    iq_frame_release(frames[1]);
+    ASSERT_EQUALS(iq_pool_lease(pool) == NULL, 1);
+    iq_frame_release(frames[1]);
+    frames[3] = iq_pool_lease(pool);
+    ASSERT_EQUALS(frames[3] == frames[1], 1);
+
+    fprintf(stderr, "iq_pool::iq_pool_lease(): round-robin after release\n");
+    iq_frame_release(frames[0]);
+    iq_frame_release(frames[2]);
+    ASSERT_EQUALS(iq_pool_lease(pool) == frames[2], 1);
+    ASSERT_EQUALS(iq_pool_lease(pool) == frames[0], 1);
+    ASSERT_EQUALS(pool->users, 4);
+    ASSERT_EQUALS(pool->high_water, 3);
+
+    fprintf(stderr, "iq_pool::iq_pool_free(): the pool outlives the owner until the last release\n");
+    iq_pool_free(pool);
+    iq_frame_release(frames[0]);
+    iq_frame_release(frames[1]);
+    ASSERT_EQUALS(pool->users, 1);
+    frames[2]->buf[15] = 0x5a; // still valid
+    ASSERT_EQUALS(frames[2]->buf[15], 0x5a);
+    iq_frame_release(frames[2]); // frees the pool
+
+    iq_frame_release(NULL);
+    iq_pool_free(NULL);
+
+    fprintf(stderr, "iq_pool:: test (%u passed, %u failed)\n", passed, failed);
+    return failed;
+}
+#endif /* _TEST */
@@ -11,6 +11,7 @@
 
 #include "output_rtltcp.h"
 
+#include "iq_pool.h"
 #include "rtl_433.h"
 #include "r_api.h"
 #include "r_util.h"
@@ -110,6 +111,7 @@ typedef struct rtltcp_server {
     uint8_t const *data_buf; ///< data buffer with most recent data, NULL otherwise
     uint32_t data_len;       ///< data buffer length in bytes, 0 otherwise
     unsigned data_cnt;       ///< data buffer update counter
+    iq_frame_t *data_frame;  ///< leased frame of the data buffer, retained, NULL if not leased
 
     pthread_t thread;
     pthread_mutex_t lock; ///< lock for data buffer
@@ -239,18 +241,24 @@ static int parse_command(r_cfg_t *cfg, int control, uint8_t const *buf, int len)
 }
 
 // event handler to broadcast to all our sockets
-static void rtltcp_broadcast_send(rtltcp_server_t *srv, uint8_t const *data, uint32_t len)
+static void rtltcp_broadcast_send(rtltcp_server_t *srv, uint8_t const *data, uint32_t len, iq_frame_t *frame)
 {
     // print_logf(LOG_TRACE, __func__, "%d byte frame", len);
+    if (frame) {
+        iq_frame_retain(frame); // keep the data until the next frame
+    }
     pthread_mutex_lock(&srv->lock);
 
     // update the data buffer reference
-    srv->data_buf = data;
-    srv->data_len = len;
+    iq_frame_t *prev_frame = srv->data_frame;
+    srv->data_buf   = data;
+    srv->data_len   = len;
+    srv->data_frame = frame;
     srv->data_cnt += 1;
 
     pthread_mutex_unlock(&srv->lock);
     pthread_cond_signal(&srv->cond);
+    iq_frame_release(prev_frame);
     // perhaps broadcast if we want to support multiple clients
     //int pthread_cond_broadcast(&srv->cond);
 }
@@ -361,14 +369,19 @@ static THREAD_RETURN THREAD_CALL accept_thread(void *arg)
             // pthread_cond_timedwait(&srv->cond, &srv->lock, const struct timespec *abstime);
 
             // Get data buffer reference
-            void const *data = srv->data_buf;
-            int data_len     = srv->data_len;
-            prev_cnt         = srv->data_cnt;
+            void const *data  = srv->data_buf;
+            int data_len      = srv->data_len;
+            iq_frame_t *frame = srv->data_frame;
+            prev_cnt          = srv->data_cnt;
+            if (frame) {
+                iq_frame_retain(frame); // keep the data while sending
+            }
 
             pthread_mutex_unlock(&srv->lock);
 
             // Send frame
             send_all(sock, data, data_len, MSG_NOSIGNAL); // ignore SIGPIPE
+            iq_frame_release(frame);
         }
 
         pthread_mutex_lock(&srv->lock);
@@ -475,6 +488,8 @@ static int rtltcp_server_stop(rtltcp_server_t *srv)
     pthread_cond_destroy(&srv->cond);
 
     srv->client_count = 0;
+    iq_frame_release(srv->data_frame);
+    srv->data_frame = NULL;
 
     // close server socket
     int ret = 0;
@@ -497,11 +512,11 @@ typedef struct raw_output_rtltcp {
     rtltcp_server_t server;
 } raw_output_rtltcp_t;
 
-static void raw_output_rtltcp_frame(raw_output_t *output, uint8_t const *data, uint32_t len)
+static void raw_output_rtltcp_frame(raw_output_t *output, uint8_t const *data, uint32_t len, struct iq_frame *frame)
 {
     raw_output_rtltcp_t *rtltcp = (raw_output_rtltcp_t *)output;
 
-    rtltcp_broadcast_send(&rtltcp->server, data, len);
+    rtltcp_broadcast_send(&rtltcp->server, data, len, frame);
 }
 
 static void raw_output_rtltcp_free(raw_output_t *output)
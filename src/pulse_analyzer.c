@@ -221,14 +221,18 @@ int pulse_analyzer_check(pulse_data_t *data, int package_type, r_device *device)
         return 0;
     }
 
-    // Generate pulse period data (pulse + gap, trailing gap)
     pulse_data_t pulse_periods_pg = {0};
+    pulse_data_t pulse_periods_gp = {0};
+    if (pulse_data_reserve(&pulse_periods_pg, data->num_pulses) || pulse_data_reserve(&pulse_periods_gp, data->num_pulses)) {
+        pulse_data_free(&pulse_periods_pg);
+        return 0;
+    }
+    // Generate pulse period data (pulse + gap, trailing gap)
     pulse_periods_pg.num_pulses   = data->num_pulses;
     for (unsigned n = 0; n < pulse_periods_pg.num_pulses; ++n) {
         pulse_periods_pg.pulse[n] = data->pulse[n] + data->gap[n];
     }
     // Generate pulse period data (gap + pulse, leading gap)
-    pulse_data_t pulse_periods_gp = {0};
     pulse_periods_gp.num_pulses   = data->num_pulses;
     pulse_periods_gp.pulse[0]     = data->pulse[0];
     for (unsigned n = 1; n < pulse_periods_gp.num_pulses; ++n) {
@@ -248,6 +252,8 @@ int pulse_analyzer_check(pulse_data_t *data, int package_type, r_device *device)
     histogram_sum(&hist_periods_gp, pulse_periods_gp.pulse, pulse_periods_gp.num_pulses, TOLERANCE);
     histogram_sum(&hist_timings, data->pulse, data->num_pulses, TOLERANCE);
     histogram_sum(&hist_timings, data->gap, data->num_pulses, TOLERANCE);
+    pulse_data_free(&pulse_periods_pg);
+    pulse_data_free(&pulse_periods_gp);
 
     // Fuse overlapping bins
     histogram_fuse_bins(&hist_pulses, TOLERANCE);
@@ -285,9 +291,14 @@ void pulse_analyzer(pulse_data_t *data, int package_type, r_device* device)
 
     double to_ms = 1e3 / data->sample_rate;
     double to_us = 1e6 / data->sample_rate;
+    pulse_data_t pulse_periods_pg = {0};
+    pulse_data_t pulse_periods_gp = {0};
+    if (pulse_data_reserve(&pulse_periods_pg, data->num_pulses) || pulse_data_reserve(&pulse_periods_gp, data->num_pulses)) {
+        pulse_data_free(&pulse_periods_pg);
+        return;
+    }
     // Generate pulse period data (pulse + gap, trailing gap)
     int pulse_total_period = 0;
-    pulse_data_t pulse_periods_pg = {0};
     pulse_periods_pg.num_pulses = data->num_pulses;
     for (unsigned n = 0; n < pulse_periods_pg.num_pulses; ++n) {
         pulse_periods_pg.pulse[n] = data->pulse[n] + data->gap[n];
@@ -295,7 +306,6 @@ void pulse_analyzer(pulse_data_t *data, int package_type, r_device* device)
     }
     pulse_total_period -= data->gap[pulse_periods_pg.num_pulses - 1];
     // Generate pulse period data (gap + pulse, leading gap)
-    pulse_data_t pulse_periods_gp = {0};
     pulse_periods_gp.num_pulses   = data->num_pulses;
     pulse_periods_gp.pulse[0] = data->pulse[0];
     for (unsigned n = 1; n < pulse_periods_gp.num_pulses; ++n) {
@@ -315,6 +325,8 @@ void pulse_analyzer(pulse_data_t *data, int package_type, r_device* device)
     histogram_sum(&hist_periods_gp, pulse_periods_gp.pulse, pulse_periods_gp.num_pulses, TOLERANCE);
     histogram_sum(&hist_timings, data->pulse, data->num_pulses, TOLERANCE);
     histogram_sum(&hist_timings, data->gap, data->num_pulses, TOLERANCE);
+    pulse_data_free(&pulse_periods_pg);
+    pulse_data_free(&pulse_periods_gp);
 
     // Fuse overlapping bins
     histogram_fuse_bins(&hist_pulses, TOLERANCE);
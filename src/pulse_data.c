@@ -15,24 +15,94 @@
 #include "r_util.h"
 #include "logger.h"
 #include "fatal.h"
+#include "c_util.h" // for MIN()
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 void pulse_data_clear(pulse_data_t *data)
 {
+    // only the used part and the next pulse can be non-zero
+    unsigned used = MIN(data->num_pulses + 1, data->capacity);
+    if (used) {
+        memset(data->pulse, 0, used * sizeof(*data->pulse));
+        memset(data->gap, 0, used * sizeof(*data->gap));
+    }
+    *data = (pulse_data_t const){.capacity = data->capacity, .pulse = data->pulse, .gap = data->gap};
+}
+
+int pulse_data_reserve(pulse_data_t *data, unsigned capacity)
+{
+    if (capacity <= data->capacity) {
+        return 0;
+    }
+    // pulses and gaps share one allocation
+    int *buf = calloc(2 * (size_t)capacity, sizeof(*buf));
+    if (!buf) {
+        WARN_CALLOC("pulse_data_reserve()");
+        return -1; // NOTE: returns -1 on alloc failure.
+    }
+    if (data->capacity) {
+        memcpy(buf, data->pulse, data->capacity * sizeof(*buf));
+        memcpy(&buf[capacity], data->gap, data->capacity * sizeof(*buf));
+    }
+    free(data->pulse);
+    data->pulse    = buf;
+    data->gap      = &buf[capacity];
+    data->capacity = capacity;
+    return 0;
+}
+
+int pulse_data_copy(pulse_data_t *dst, pulse_data_t const *src)
+{
+    // the next pulse is kept valid and zero, like in a fresh structure
+    int ret = pulse_data_reserve(dst, src->num_pulses + 1);
+
+    pulse_data_t data = *src;
+    data.num_pulses   = MIN(src->num_pulses, dst->capacity ? dst->capacity - 1 : 0);
+    data.capacity     = dst->capacity;
+    data.pulse        = dst->pulse;
+    data.gap          = dst->gap;
+    if (data.capacity) {
+        memcpy(data.pulse, src->pulse, data.num_pulses * sizeof(*data.pulse));
+        memcpy(data.gap, src->gap, data.num_pulses * sizeof(*data.gap));
+        data.pulse[data.num_pulses] = 0;
+        data.gap[data.num_pulses]   = 0;
+    }
+    *dst = data;
+    return ret;
+}
+
+void pulse_data_free(pulse_data_t *data)
+{
+    free(data->pulse);
     *data = (pulse_data_t const){0};
 }
 
 void pulse_data_shift(pulse_data_t *data)
 {
-    int offs = PD_MAX_PULSES / 2; // shift out half the data
-    memmove(data->pulse, &data->pulse[offs], (PD_MAX_PULSES - offs) * sizeof(*data->pulse));
-    memmove(data->gap, &data->gap[offs], (PD_MAX_PULSES - offs) * sizeof(*data->gap));
+    int offs = data->num_pulses / 2; // shift out half the data
+    memmove(data->pulse, &data->pulse[offs], (data->num_pulses - offs) * sizeof(*data->pulse));
+    memmove(data->gap, &data->gap[offs], (data->num_pulses - offs) * sizeof(*data->gap));
     data->num_pulses -= offs;
     data->offset += offs;
 }
 
+void pulse_data_rescale(pulse_data_t *data, unsigned factor)
+{
+    for (unsigned n = 0; n < data->num_pulses; ++n) {
+        data->pulse[n] *= factor;
+        data->gap[n] *= factor;
+    }
+    data->offset *= factor;
+    data->sample_rate *= factor;
+    data->start_ago *= factor;
+    data->end_ago *= factor;
+    // frequency estimates are relative to the sample rate
+    data->fsk_f1_est /= (int)factor;
+    data->fsk_f2_est /= (int)factor;
+}
+
 void pulse_data_print(pulse_data_t const *data)
 {
     fprintf(stderr, "Pulse data: %u pulses\n", data->num_pulses);
@@ -124,9 +194,12 @@ void pulse_data_load(FILE *file, struct timeval *now, pulse_data_t *data, uint32
 {
     char s[1024];
     int i    = 0;
-    int size = sizeof(data->pulse) / sizeof(*data->pulse);
+    int size = PD_MAX_PULSES;
 
     pulse_data_clear(data);
+    if (pulse_data_reserve(data, PD_MAX_PULSES)) {
+        return;
+    }
     data->sample_rate = sample_rate;
     double to_sample  = sample_rate / 1e6;
     // read line-by-line
@@ -225,7 +298,11 @@ void pulse_data_dump(FILE *file, pulse_data_t const *data)
 
 data_t *pulse_data_print_data(pulse_data_t const *data)
 {
-    int pulses[2 * PD_MAX_PULSES];
+    int *pulses = malloc(2 * (data->num_pulses + 1) * sizeof(*pulses));
+    if (!pulses) {
+        WARN_MALLOC("pulse_data_print_data()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
     double to_us = 1e6 / data->sample_rate;
     for (unsigned i = 0; i < data->num_pulses; ++i) {
         pulses[i * 2 + 0] = data->pulse[i] * to_us;
@@ -233,7 +310,7 @@ data_t *pulse_data_print_data(pulse_data_t const *data)
     }
 
     /* clang-format off */
-    return data_make(
+    data_t *out = data_make(
             "mod",              "", DATA_STRING, (data->fsk_f2_est) ? "FSK" : "OOK",
             "count",            "", DATA_INT,    data->num_pulses,
             "pulses",           "", DATA_ARRAY,  data_array(2 * data->num_pulses, DATA_INT, pulses),
@@ -248,4 +325,127 @@ data_t *pulse_data_print_data(pulse_data_t const *data)
             "noise_dB",         "", DATA_FORMAT, "%.1f dB", DATA_DOUBLE, data->noise_db,
             NULL);
     /* clang-format on */
+    free(pulses);
+    return out;
+}
+
+#ifdef _TEST
+#define ASSERT_EQUALS(a, b) \
+    do { \
+        if ((a) == (b)) \
+            ++passed; \
+        else { \
+            ++failed; \
+            fprintf(stderr, "FAIL: %d <> %d\n", (int)(a), (int)(b)); \
+        } \
+    } while (0)
+
+/// Check that @p n pulses and gaps count up from @p first, gaps negated.
+static int pattern_ok(pulse_data_t const *data, unsigned first, unsigned n)
+{
+    for (unsigned i = 0; i < n; ++i) {
+        if (data->pulse[i] != (int)(first + i) || data->gap[i] != -(int)(first + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void)
+{
+    unsigned passed = 0;
+    unsigned failed = 0;
+    pulse_data_t data = {0};
+    pulse_data_t copy = {0};
+
+    fprintf(stderr, "pulse_data:: test\n");
+
+    // Grow like the FSK detector does, doubling up to the hard limit, the pulses
+    // and gaps written so far must survive every reallocation.
+    fprintf(stderr, "pulse_data::pulse_data_reserve(): growth\n");
+    ASSERT_EQUALS(pulse_data_reserve(&data, PD_MAX_PULSES), 0);
+    ASSERT_EQUALS(data.capacity, PD_MAX_PULSES);
+    for (unsigned i = 0; i < PD_HARD_MAX_PULSES; ++i) {
+        if (i == data.capacity) {
+            ASSERT_EQUALS(pulse_data_reserve(&data, MIN(2 * data.capacity, PD_HARD_MAX_PULSES)), 0);
+            ASSERT_EQUALS(pattern_ok(&data, 0, i), 1);
+        }
+        data.pulse[i] = (int)i;
+        data.gap[i]   = -(int)i;
+        data.num_pulses++;
+    }
+    ASSERT_EQUALS(data.capacity, PD_HARD_MAX_PULSES);
+    ASSERT_EQUALS(pattern_ok(&data, 0, PD_HARD_MAX_PULSES), 1);
+    // a smaller reserve keeps the allocation
+    int *pulse = data.pulse;
+    ASSERT_EQUALS(pulse_data_reserve(&data, PD_MAX_PULSES), 0);
+    ASSERT_EQUALS(data.pulse == pulse, 1);
+
+    // The copy holds all pulses plus a zeroed next pulse, even over stale data.
+    fprintf(stderr, "pulse_data::pulse_data_copy(): grown source\n");
+    ASSERT_EQUALS(pulse_data_reserve(&copy, 16), 0);
+    copy.pulse[3] = 42;
+    data.num_pulses = PD_HARD_MAX_PULSES - 1;
+    data.offset     = 1000;
+    ASSERT_EQUALS(pulse_data_copy(&copy, &data), 0);
+    ASSERT_EQUALS(copy.num_pulses, PD_HARD_MAX_PULSES - 1);
+    ASSERT_EQUALS(copy.capacity >= PD_HARD_MAX_PULSES, 1);
+    ASSERT_EQUALS(copy.offset, 1000);
+    ASSERT_EQUALS(copy.pulse != data.pulse, 1);
+    ASSERT_EQUALS(pattern_ok(&copy, 0, copy.num_pulses), 1);
+    ASSERT_EQUALS(copy.pulse[copy.num_pulses], 0);
+    ASSERT_EQUALS(copy.gap[copy.num_pulses], 0);
+
+    fprintf(stderr, "pulse_data::pulse_data_copy(): short source keeps the allocation\n");
+    pulse_data_t small = {0};
+    ASSERT_EQUALS(pulse_data_reserve(&small, 8), 0);
+    for (unsigned i = 0; i < 5; ++i) {
+        small.pulse[i] = (int)i;
+        small.gap[i]   = -(int)i;
+    }
+    small.num_pulses = 5;
+    pulse = copy.pulse;
+    ASSERT_EQUALS(pulse_data_copy(&copy, &small), 0);
+    ASSERT_EQUALS(copy.pulse == pulse, 1);
+    ASSERT_EQUALS(copy.num_pulses, 5);
+    ASSERT_EQUALS(pattern_ok(&copy, 0, 5), 1);
+    ASSERT_EQUALS(copy.pulse[5], 0);
+    ASSERT_EQUALS(copy.gap[5], 0);
+    pulse_data_free(&small);
+
+    // Shifting out half of a full package keeps the newest pulses.
+    fprintf(stderr, "pulse_data::pulse_data_shift(): after growth\n");
+    data.num_pulses = PD_HARD_MAX_PULSES;
+    data.offset     = 1000;
+    pulse_data_shift(&data);
+    ASSERT_EQUALS(data.num_pulses, PD_HARD_MAX_PULSES / 2);
+    ASSERT_EQUALS(data.offset, 1000 + PD_HARD_MAX_PULSES / 2);
+    ASSERT_EQUALS(data.capacity, PD_HARD_MAX_PULSES);
+    ASSERT_EQUALS(pattern_ok(&data, PD_HARD_MAX_PULSES / 2, data.num_pulses), 1);
+
+    fprintf(stderr, "pulse_data::pulse_data_clear(): keeps the allocation\n");
+    pulse = data.pulse;
+    pulse_data_clear(&data);
+    ASSERT_EQUALS(data.num_pulses, 0);
+    ASSERT_EQUALS(data.offset, 0);
+    ASSERT_EQUALS(data.pulse == pulse, 1);
+    ASSERT_EQUALS(data.capacity, PD_HARD_MAX_PULSES);
+    ASSERT_EQUALS(data.pulse[0], 0);
+
+    // A freed structure is empty and can be reused or freed again.
+    fprintf(stderr, "pulse_data::pulse_data_free(): empty again\n");
+    pulse_data_free(&data);
+    ASSERT_EQUALS(data.pulse == NULL, 1);
+    ASSERT_EQUALS(data.gap == NULL, 1);
+    ASSERT_EQUALS(data.capacity, 0);
+    ASSERT_EQUALS(data.num_pulses, 0);
+    pulse_data_free(&data);
+    ASSERT_EQUALS(pulse_data_copy(&data, &copy), 0);
+    ASSERT_EQUALS(pattern_ok(&data, 0, 5), 1);
+    pulse_data_free(&data);
+    pulse_data_free(&copy);
+
+    fprintf(stderr, "pulse_data:: test (%u passed, %u failed)\n", passed, failed);
+    return failed;
 }
+#endif /* _TEST */
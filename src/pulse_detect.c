@@ -71,6 +71,11 @@ void pulse_detect_free(pulse_detect_t *pulse_detect)
     free(pulse_detect);
 }
 
+int pulse_detect_idle(pulse_detect_t const *pulse_detect)
+{
+    return pulse_detect->ook_state == PD_OOK_STATE_IDLE;
+}
+
 void pulse_detect_reset(pulse_detect_t *pulse_detect)
 {
     pulse_detect->ook_state         = PD_OOK_STATE_IDLE;
@@ -195,6 +200,111 @@ static void print_att_hist(char const *s, int att_hist[])
     }
 }
 
+/// OOK detection threshold of the level estimates.
+static inline int16_t ook_threshold_level(int fixed_high_level, int low_estimate, int high_estimate)
+{
+    if (fixed_high_level != 0) {
+        return fixed_high_level; // Manual override
+    }
+    return (low_estimate + MIN(high_estimate, OOK_MAX_HIGH_LEVEL)) / 2;
+}
+
+/** Run the idle state up to the first rising edge after the lead in.
+
+    The noise estimate is updated with every sample like in the state machine,
+    the integer rounding of the update has no closed form that would give the same
+    estimates. The sample of the edge is left to the state machine.
+*/
+static void run_idle(pulse_detect_t *s, int16_t const *envelope_data, int len)
+{
+    int const min_high   = s->ook_min_high_level;
+    int const ratio      = s->ook_high_low_ratio;
+    int const fixed_high = s->ook_fixed_high_level;
+    int low_estimate     = s->ook_low_estimate;
+    int high_estimate    = s->ook_high_estimate;
+    int lead_in_counter  = s->lead_in_counter;
+    int n                = s->data_counter;
+    for (; n < len; ++n) {
+        int16_t const am_n    = envelope_data[n];
+        int16_t const ook_threshold  = ook_threshold_level(fixed_high, low_estimate, high_estimate);
+        int16_t const ook_hysteresis = ook_threshold / 8;
+        if (am_n > (ook_threshold + ook_hysteresis) && lead_in_counter > OOK_EST_LOW_RATIO) {
+            break;
+        }
+        int const ook_low_delta = am_n - low_estimate;
+        low_estimate += ook_low_delta / OOK_EST_LOW_RATIO;
+        low_estimate += ((ook_low_delta > 0) ? 1 : -1);
+        high_estimate = MAX(ratio * low_estimate, min_high);
+        if (lead_in_counter <= OOK_EST_LOW_RATIO) lead_in_counter += 1;
+    }
+    s->data_counter      = n;
+    s->ook_low_estimate  = low_estimate;
+    s->ook_high_estimate = high_estimate;
+    s->lead_in_counter   = lead_in_counter;
+}
+
+/** Skip the quiet samples of a gap, up to the next rising edge or the end of package.
+
+    The level estimates don't change during a gap, the threshold is constant and the
+    rising edge is found with a vectorized search. The sample of the edge or the end
+    of package is left to the state machine.
+*/
+static void skip_gap(pulse_detect_t *s, int16_t const *envelope_data, int len, int samples_per_ms)
+{
+    int16_t const ook_threshold  = ook_threshold_level(s->ook_fixed_high_level, s->ook_low_estimate, s->ook_high_estimate);
+    int16_t const ook_hysteresis = ook_threshold / 8;
+    int const above              = ook_threshold + ook_hysteresis;
+
+    // first gap length that ends the package
+    int const min_eop    = MAX(PD_MAX_GAP_RATIO * s->max_pulse, PD_MIN_GAP_MS * samples_per_ms);
+    int const eop_length = MIN(min_eop, PD_MAX_GAP_MS * samples_per_ms) + 1;
+    int const to_eop     = eop_length - s->pulse_length;
+    if (to_eop <= 1) {
+        return;
+    }
+    int const avail = len - s->data_counter;
+    int const count = MIN(avail, to_eop);
+    int skip        = count;
+    if (above < INT16_MAX) {
+        skip = (int)baseband_find_above(&envelope_data[s->data_counter], (uint32_t)count, (int16_t)above);
+    }
+    if (skip == to_eop) {
+        skip -= 1; // the end of package sample
+    }
+    s->pulse_length += skip;
+    s->data_counter += skip;
+}
+
+/** Run a pulse up to the falling edge.
+
+    Only the level and frequency estimates are tracked, the FSK demodulation of the
+    first pulse is up to the caller. The sample of the edge is left to the state machine.
+*/
+static void run_pulse(pulse_detect_t *s, int16_t const *envelope_data, int16_t const *fm_data, int len, pulse_data_t *pulses)
+{
+    int const min_high     = s->ook_min_high_level;
+    int const fixed_high   = s->ook_fixed_high_level;
+    int const low_estimate = s->ook_low_estimate;
+    int high_estimate      = s->ook_high_estimate;
+    int fsk_f1_est         = pulses->fsk_f1_est;
+    int n                  = s->data_counter;
+    for (; n < len; ++n) {
+        int16_t const am_n           = envelope_data[n];
+        int16_t const ook_threshold  = ook_threshold_level(fixed_high, low_estimate, high_estimate);
+        int16_t const ook_hysteresis = ook_threshold / 8;
+        if (am_n < (ook_threshold - ook_hysteresis)) {
+            break;
+        }
+        high_estimate += am_n / OOK_EST_HIGH_RATIO - high_estimate / OOK_EST_HIGH_RATIO;
+        high_estimate = MAX(high_estimate, min_high);
+        fsk_f1_est += fm_data[n] / OOK_EST_HIGH_RATIO - fsk_f1_est / OOK_EST_HIGH_RATIO;
+    }
+    s->pulse_length += n - s->data_counter;
+    s->data_counter      = n;
+    s->ook_high_estimate = high_estimate;
+    pulses->fsk_f1_est   = fsk_f1_est;
+}
+
 /// Demodulate On/Off Keying (OOK) and Frequency Shift Keying (FSK) from an envelope signal
 int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_data, int16_t const *fm_data, int len, uint32_t samp_rate, uint64_t sample_offset, pulse_data_t *pulses, pulse_data_t *fsk_pulses, unsigned fpdm)
 {
@@ -277,6 +387,12 @@ int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_d
         }
     }
 
+    // OOK packages end at PD_MAX_PULSES, FSK packages grow beyond as needed
+    if (pulse_data_reserve(pulses, PD_MAX_PULSES) || pulse_data_reserve(fsk_pulses, PD_MAX_PULSES)) {
+        s->data_counter = 0;
+        return 0; // skip the frame on alloc failure
+    }
+
     int att_hist[37] = {0};
     int const samples_per_ms = samp_rate / 1000;
 
@@ -288,6 +404,8 @@ int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_d
         fsk_pulses->start_ago += len;
     }
 
+    // the level histogram needs every sample
+    int const fast_paths = pulse_detect->verbosity < LOG_NOTICE;
     int eop_on_spurious = 0;
     // Process all new samples
     while (s->data_counter < len) {
@@ -473,6 +591,26 @@ int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_d
                 s->ook_state = PD_OOK_STATE_IDLE;
         } // switch
         s->data_counter += 1;
+
+        // Skip ahead on the spans where the state can't change
+        if (fast_paths && s->ook_state == PD_OOK_STATE_IDLE) {
+            run_idle(s, envelope_data, len);
+        }
+        else if (fast_paths && s->ook_state == PD_OOK_STATE_GAP && !eop_on_spurious) {
+            skip_gap(s, envelope_data, len, samples_per_ms);
+        }
+        else if (fast_paths && s->ook_state == PD_OOK_STATE_PULSE) {
+            int const pulse_start = s->data_counter;
+            run_pulse(s, envelope_data, fm_data, len, pulses);
+            // FSK Demodulation
+            if (pulses->num_pulses == 0) {    // Only during first pulse
+                if (fpdm == FSK_PULSE_DETECT_OLD) {
+                    pulse_detect_fsk_classic_block(&s->pulse_detect_fsk, &fm_data[pulse_start], s->data_counter - pulse_start, fsk_pulses);
+                } else {
+                    pulse_detect_fsk_minmax_block(&s->pulse_detect_fsk, &fm_data[pulse_start], s->data_counter - pulse_start, fsk_pulses);
+                }
+            }
+        }
     } // while
 
     s->data_counter = 0;
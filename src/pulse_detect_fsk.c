@@ -31,7 +31,7 @@ void pulse_detect_fsk_init(pulse_detect_fsk_t *s)
     s->skip_samples = 40;
 }
 
-void pulse_detect_fsk_classic(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *fsk_pulses)
+static inline void fsk_classic_sample(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *fsk_pulses)
 {
     int const fm_f1_delta = abs(fm_n - s->fm_f1_est); // Get delta from F1 frequency estimate
     int const fm_f2_delta = abs(fm_n - s->fm_f2_est); // Get delta from F2 frequency estimate
@@ -106,8 +106,10 @@ void pulse_detect_fsk_classic(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t
                     fsk_pulses->gap[fsk_pulses->num_pulses] = s->fsk_pulse_length;    // Store gap width
                     fsk_pulses->num_pulses += 1;    // Go to next pulse
                     s->fsk_pulse_length = 0;
-                    // When pulse buffer is full go to error state
-                    if (fsk_pulses->num_pulses >= PD_MAX_PULSES) {
+                    // When pulse buffer is full grow it, up to the hard limit
+                    if (fsk_pulses->num_pulses >= fsk_pulses->capacity
+                            && (fsk_pulses->num_pulses >= PD_HARD_MAX_PULSES
+                                    || pulse_data_reserve(fsk_pulses, MIN(2 * fsk_pulses->capacity, PD_HARD_MAX_PULSES)))) {
                         //fprintf(stderr, "pulse_detect_fsk_classic(): Maximum number of pulses reached!\n");
                         //s->fsk_state = PD_FSK_STATE_ERROR;
                         // TODO: workaround, specifically for the Inkbird-ITH20R: free some of the buffer
@@ -140,9 +142,24 @@ void pulse_detect_fsk_classic(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t
     } // switch(s->fsk_state)
 }
 
+void pulse_detect_fsk_classic(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *fsk_pulses)
+{
+    fsk_classic_sample(s, fm_n, fsk_pulses);
+}
+
+void pulse_detect_fsk_classic_block(pulse_detect_fsk_t *s, int16_t const *fm_data, int len, pulse_data_t *fsk_pulses)
+{
+    // a local copy of the state can be kept in registers
+    pulse_detect_fsk_t state = *s;
+    for (int n = 0; n < len; ++n) {
+        fsk_classic_sample(&state, fm_data[n], fsk_pulses);
+    }
+    *s = state;
+}
+
 void pulse_detect_fsk_wrap_up(pulse_detect_fsk_t *s, pulse_data_t *fsk_pulses)
 {
-    if (fsk_pulses->num_pulses < PD_MAX_PULSES) { // Avoid overflow
+    if (fsk_pulses->num_pulses < fsk_pulses->capacity) { // Avoid overflow
         s->fsk_pulse_length += 1;
         if (s->fsk_state == PD_FSK_STATE_FH) {
             fsk_pulses->pulse[fsk_pulses->num_pulses] = s->fsk_pulse_length; // Store last pulse
@@ -155,7 +172,7 @@ void pulse_detect_fsk_wrap_up(pulse_detect_fsk_t *s, pulse_data_t *fsk_pulses)
     }
 }
 
-void pulse_detect_fsk_minmax(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *fsk_pulses)
+static inline void fsk_minmax_sample(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *fsk_pulses)
 {
     int16_t mid = 0;
 
@@ -197,8 +214,10 @@ void pulse_detect_fsk_minmax(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *
                     fsk_pulses->gap[fsk_pulses->num_pulses] = s->fsk_pulse_length;
                     fsk_pulses->num_pulses += 1;
                     s->fsk_pulse_length = 0;
-                    // When pulse buffer is full go to error state
-                    if (fsk_pulses->num_pulses >= PD_MAX_PULSES) {
+                    // When pulse buffer is full grow it, up to the hard limit
+                    if (fsk_pulses->num_pulses >= fsk_pulses->capacity
+                            && (fsk_pulses->num_pulses >= PD_HARD_MAX_PULSES
+                                    || pulse_data_reserve(fsk_pulses, MIN(2 * fsk_pulses->capacity, PD_HARD_MAX_PULSES)))) {
                         //fprintf(stderr, "pulse_detect_fsk_minmax(): Maximum number of pulses reached!\n");
                         //s->fsk_state = PD_FSK_STATE_ERROR;
                         // TODO: workaround, specifically for the Inkbird-ITH20R: free some of the buffer
@@ -219,3 +238,18 @@ void pulse_detect_fsk_minmax(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *
         s->skip_samples -= 1;
     }
 }
+
+void pulse_detect_fsk_minmax(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *fsk_pulses)
+{
+    fsk_minmax_sample(s, fm_n, fsk_pulses);
+}
+
+void pulse_detect_fsk_minmax_block(pulse_detect_fsk_t *s, int16_t const *fm_data, int len, pulse_data_t *fsk_pulses)
+{
+    // a local copy of the state can be kept in registers
+    pulse_detect_fsk_t state = *s;
+    for (int n = 0; n < len; ++n) {
+        fsk_minmax_sample(&state, fm_data[n], fsk_pulses);
+    }
+    *s = state;
+}
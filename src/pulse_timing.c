@@ -0,0 +1,217 @@
+/** @file
+    Timing signature of a pulse package to skip decoders that can't match.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "pulse_timing.h"
+
+#include <limits.h>
+
+#include "pulse_data.h"
+#include "r_device.h"
+
+/// Quarter octave bin of a width, bins 0 to 3 are the widths 0 to 3.
+static unsigned width_bin(int width)
+{
+    if (width < 4) {
+        return width > 0 ? (unsigned)width : 0;
+    }
+    unsigned msb = 2;
+    while (msb < 30 && (width >> (msb + 1))) {
+        ++msb;
+    }
+    unsigned bin = 4 * (msb - 1) + ((width >> (msb - 2)) & 3);
+    return bin < PULSE_TIMING_BINS ? bin : PULSE_TIMING_BINS - 1;
+}
+
+/// Bins of all widths from @p lo to @p hi.
+static uint64_t range_bins(int lo, int hi)
+{
+    if (lo < 1) {
+        lo = 1;
+    }
+    if (hi < lo) {
+        return 0;
+    }
+    unsigned b0 = width_bin(lo);
+    unsigned b1 = width_bin(hi);
+    return (~(uint64_t)0 >> (PULSE_TIMING_BINS - 1 - b1)) & (~(uint64_t)0 << b0);
+}
+
+/// Bins of a symbol width within the tolerance, a default tolerance of half the width.
+static uint64_t symbol_bins(int width, int tolerance)
+{
+    if (width <= 0) {
+        return 0;
+    }
+    if (tolerance <= 0) {
+        tolerance = width / 2;
+    }
+    return range_bins(width - tolerance, width + tolerance);
+}
+
+void pulse_timing_analyze(pulse_timing_t *timing, pulse_data_t const *data)
+{
+    unsigned pulse_count[PULSE_TIMING_BINS] = {0};
+    unsigned gap_count[PULSE_TIMING_BINS]   = {0};
+
+    unsigned const n = data->num_pulses;
+    for (unsigned i = 0; i < n; ++i) {
+        pulse_count[width_bin(data->pulse[i])] += 1;
+    }
+    // the final gap only ends the package
+    for (unsigned i = 0; i + 1 < n; ++i) {
+        gap_count[width_bin(data->gap[i])] += 1;
+    }
+
+    // a width is dominant if it holds at least 1/64 of the package, any width of a short package
+    unsigned const min_count = 1 + n / 64;
+
+    timing->sample_rate = data->sample_rate;
+    timing->pulses      = 0;
+    timing->gaps        = 0;
+    for (unsigned b = 0; b < PULSE_TIMING_BINS; ++b) {
+        if (pulse_count[b] >= min_count) {
+            timing->pulses |= (uint64_t)1 << b;
+        }
+        if (gap_count[b] >= min_count) {
+            timing->gaps |= (uint64_t)1 << b;
+        }
+    }
+}
+
+int pulse_timing_compatible(pulse_timing_t const *timing, r_device const *r_dev)
+{
+    // the widths in samples are computed like the slicers do
+    float samples_per_us = timing->sample_rate / 1.0e6f;
+
+    int s_short     = r_dev->short_width * samples_per_us;
+    int s_long      = r_dev->long_width * samples_per_us;
+    int s_sync      = r_dev->sync_width * samples_per_us;
+    int s_tolerance = r_dev->tolerance * samples_per_us;
+
+    // let the slicer warn about rounding to zero
+    if ((r_dev->short_width > 0 && s_short <= 0)
+            || (r_dev->long_width > 0 && s_long <= 0)
+            || (r_dev->sync_width > 0 && s_sync <= 0)
+            || (r_dev->tolerance > 0 && s_tolerance <= 0)) {
+        return 1;
+    }
+
+    uint64_t const symbols = timing->pulses | timing->gaps;
+
+    switch (r_dev->modulation) {
+    case OOK_PULSE_PCM:
+    case FSK_PULSE_PCM:
+        if (s_short != s_long) {
+            // RZ: pulses of the short width, the slicer tolerance defaults to a quarter bit period
+            return (timing->pulses & symbol_bins(s_short, s_tolerance > 0 ? s_tolerance : s_long / 4)) != 0;
+        }
+        // NRZ: runs of at least half a bit
+        return (symbols & range_bins(s_short / 2, INT_MAX)) != 0;
+    case OOK_PULSE_PWM:
+    case FSK_PULSE_PWM:
+        return (timing->pulses & (symbol_bins(s_short, s_tolerance) | symbol_bins(s_long, s_tolerance) | symbol_bins(s_sync, s_tolerance))) != 0;
+    case OOK_PULSE_PPM:
+        return (timing->gaps & (symbol_bins(s_short, s_tolerance) | symbol_bins(s_long, s_tolerance) | symbol_bins(s_sync, s_tolerance))) != 0;
+    case OOK_PULSE_MANCHESTER_ZEROBIT:
+    case FSK_PULSE_MANCHESTER_ZEROBIT:
+        // half and full bit periods
+        if (s_tolerance <= 0) {
+            s_tolerance = s_short / 2;
+        }
+        return (symbols & range_bins(s_short - s_tolerance, 2 * s_short + s_tolerance)) != 0;
+    case OOK_PULSE_PIWM_RAW:
+        // multiples of the short width up to the long width
+        return (symbols & range_bins(s_short - (s_tolerance > 0 ? s_tolerance : s_short / 2), s_long)) != 0;
+    case OOK_PULSE_PIWM_DC:
+    case OOK_PULSE_DMC:
+        return (symbols & (symbol_bins(s_short, s_tolerance) | symbol_bins(s_long, s_tolerance))) != 0;
+    default:
+        // no timing check for the other slicers
+        return 1;
+    }
+}
+
+#ifdef _TEST
+#include <stdio.h>
+
+#define ASSERT_EQUALS(a, b) \
+    do { \
+        if ((a) == (b)) \
+            ++passed; \
+        else { \
+            ++failed; \
+            fprintf(stderr, "FAIL: %d <> %d\n", (int)(a), (int)(b)); \
+        } \
+    } while (0)
+
+int main(void)
+{
+    unsigned passed = 0;
+    unsigned failed = 0;
+
+    fprintf(stderr, "pulse_timing::width_bin(): monotonic and clamped\n");
+    unsigned last = 0;
+    int monotonic = 1;
+    for (int w = 0; w < 300000; ++w) {
+        unsigned bin = width_bin(w);
+        monotonic &= bin >= last && bin <= last + 1;
+        last = bin;
+    }
+    ASSERT_EQUALS(monotonic, 1);
+    ASSERT_EQUALS(width_bin(INT_MAX), PULSE_TIMING_BINS - 1);
+    ASSERT_EQUALS(range_bins(100, 100) != 0, 1);
+    ASSERT_EQUALS(range_bins(200, 100), 0);
+
+    // 24 PWM bits of 500 us / 1000 us at 250 kHz, one noise pulse, and a final gap
+    int pulse[26];
+    int gap[26];
+    pulse_data_t data = {.sample_rate = 250000, .capacity = 26, .pulse = pulse, .gap = gap};
+    for (int i = 0; i < 24; ++i) {
+        pulse[i] = i % 3 ? 125 : 250;
+        gap[i]   = i % 3 ? 250 : 125;
+    }
+    pulse[24]       = 3;
+    gap[24]         = 40;
+    pulse[25]       = 250;
+    gap[25]         = 10000;
+    data.num_pulses = 26;
+
+    pulse_timing_t timing;
+    pulse_timing_analyze(&timing, &data);
+
+    fprintf(stderr, "pulse_timing::pulse_timing_analyze(): signature\n");
+    ASSERT_EQUALS((timing.pulses >> width_bin(125)) & 1, 1);
+    ASSERT_EQUALS((timing.pulses >> width_bin(250)) & 1, 1);
+    ASSERT_EQUALS((timing.gaps >> width_bin(10000)) & 1, 0); // the final gap
+    ASSERT_EQUALS(timing.sample_rate, 250000);
+
+    fprintf(stderr, "pulse_timing::pulse_timing_compatible(): decoders\n");
+    r_device dev = {.modulation = OOK_PULSE_PWM, .short_width = 500, .long_width = 1000};
+    ASSERT_EQUALS(pulse_timing_compatible(&timing, &dev), 1);
+    dev = (r_device){.modulation = OOK_PULSE_PWM, .short_width = 2000, .long_width = 4000, .tolerance = 200};
+    ASSERT_EQUALS(pulse_timing_compatible(&timing, &dev), 0);
+    dev = (r_device){.modulation = OOK_PULSE_PPM, .short_width = 500, .long_width = 1000, .tolerance = 100};
+    ASSERT_EQUALS(pulse_timing_compatible(&timing, &dev), 1);
+    dev = (r_device){.modulation = OOK_PULSE_PPM, .short_width = 2000, .long_width = 4000, .tolerance = 200};
+    ASSERT_EQUALS(pulse_timing_compatible(&timing, &dev), 0);
+    dev = (r_device){.modulation = OOK_PULSE_MANCHESTER_ZEROBIT, .short_width = 500};
+    ASSERT_EQUALS(pulse_timing_compatible(&timing, &dev), 1);
+    dev = (r_device){.modulation = OOK_PULSE_PCM, .short_width = 5000, .long_width = 5000};
+    ASSERT_EQUALS(pulse_timing_compatible(&timing, &dev), 0);
+    dev = (r_device){.modulation = OOK_PULSE_PCM, .short_width = 200, .long_width = 200};
+    ASSERT_EQUALS(pulse_timing_compatible(&timing, &dev), 1);
+    dev = (r_device){.modulation = OOK_PULSE_PWM_OSV1, .short_width = 5000, .long_width = 9000};
+    ASSERT_EQUALS(pulse_timing_compatible(&timing, &dev), 1);
+    dev = (r_device){.modulation = OOK_PULSE_PWM, .short_width = 1, .long_width = 2};
+    ASSERT_EQUALS(pulse_timing_compatible(&timing, &dev), 1); // rounds to zero samples
+
+    fprintf(stderr, "pulse_timing:: test (%u passed, %u failed)\n", passed, failed);
+    return failed;
+}
+#endif /* _TEST */
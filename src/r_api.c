@@ -20,13 +20,18 @@
 #include "r_util.h"
 #include "rtl_433.h"
 #include "r_private.h"
+#include "r_flow.h"
 #include "rtl_433_devices.h"
 #include "r_device.h"
 #include "pulse_slicer.h"
+#include "pulse_timing.h"
 #include "pulse_detect_fsk.h"
 #include "sdr.h"
 #include "data.h"
 #include "data_tag.h"
+#include "dsp_thread.h"
+#include "decoder_pool.h"
+#include "compat_pthread.h"
 #include "list.h"
 #include "optparse.h"
 #include "output_file.h"
@@ -119,6 +124,7 @@ void set_gain_str(struct r_cfg *cfg, char const *gain_str)
 void r_init_cfg(r_cfg_t *cfg)
 {
     cfg->out_block_size  = DEFAULT_BUF_LENGTH;
+    cfg->sdr_index       = -1;
     cfg->samp_rate       = DEFAULT_SAMPLE_RATE;
     cfg->conversion_mode = CONVERT_NATIVE;
     cfg->fsk_pulse_detect_mode = FSK_PULSE_DETECT_AUTO;
@@ -158,8 +164,6 @@ void r_init_cfg(r_cfg_t *cfg)
 
     // note: this should be optional
     cfg->demod->pulse_detect = pulse_detect_create();
-    // initialize tables
-    baseband_init();
 
     time(&cfg->demod->running_since);
     time(&cfg->demod->frames_since);
@@ -176,6 +180,8 @@ r_cfg_t *r_create_cfg(void)
         FATAL_CALLOC("r_create_cfg()");
 
     r_init_cfg(cfg);
+    // select the kernels
+    baseband_init();
 
     return cfg;
 }
@@ -191,6 +197,9 @@ void r_free_cfg(r_cfg_t *cfg)
     free(cfg->gain_str);
     cfg->gain_str = NULL;
 
+    free(cfg->wisdom_file);
+    cfg->wisdom_file = NULL;
+
     for (void **iter = cfg->demod->dumper.elems; iter && *iter; ++iter) {
         file_info_t const *dumper = *iter;
         if (dumper->file && (dumper->file != stdout))
@@ -206,10 +215,26 @@ void r_free_cfg(r_cfg_t *cfg)
 
     pulse_detect_free(cfg->demod->pulse_detect);
     cfg->demod->pulse_detect = NULL;
+    pulse_data_free(&cfg->demod->pulse_data);
+    pulse_data_free(&cfg->demod->fsk_pulse_data);
+
+    decimator_free(cfg->demod->decimator);
+    cfg->demod->decimator = NULL;
+
+    decoder_pool_free(cfg->demod->decoder_pool);
+    cfg->demod->decoder_pool = NULL;
+
+    free_sdr_flow(cfg);
+
+    set_channels(cfg, 0);
 
     list_free_elems(&cfg->raw_handler, (list_elem_free_fn)raw_output_free);
 
-    r_logger_set_log_handler(NULL, NULL);
+    // other configs, e.g. of an embedding engine, leave the process-wide log handler alone
+    if (cfg->log_redirected) {
+        r_logger_set_log_handler(NULL, NULL);
+        cfg->log_redirected = 0;
+    }
 
     list_free_elems(&cfg->output_handler, (list_elem_free_fn)data_output_free);
 
@@ -217,6 +242,8 @@ void r_free_cfg(r_cfg_t *cfg)
 
     list_free_elems(&cfg->in_files, NULL);
 
+    list_free_elems(&cfg->dev_queries, NULL);
+
     free(cfg->demod);
     cfg->demod = NULL;
 
@@ -230,9 +257,140 @@ void r_free_cfg(r_cfg_t *cfg)
     //free(cfg);
 }
 
+r_cfg_t *r_create_job_cfg(r_cfg_t *cfg)
+{
+    r_cfg_t *job = malloc(sizeof(*job));
+    if (!job)
+        FATAL_MALLOC("r_create_job_cfg()");
+    *job = *cfg; // shares the settings, outputs, and data tags
+    job->dev         = NULL;
+    job->dsp         = NULL;
+    job->mgr         = NULL;
+    job->in_filename = NULL;
+
+    struct dm_state *demod = malloc(sizeof(*demod));
+    if (!demod)
+        FATAL_MALLOC("r_create_job_cfg()");
+    *demod     = *cfg->demod; // copies the detector settings
+    job->demod = demod;
+
+    demod->pulse_detect = pulse_detect_create();
+    if (!demod->pulse_detect) {
+        FATAL("Failed to create a job pulse detector");
+    }
+    pulse_detect_set_levels(demod->pulse_detect, demod->use_mag_est, demod->level_limit, demod->min_level, demod->min_snr, demod->detect_verbosity);
+    demod->decimator = cfg->demod->decimator ? decimator_create(cfg->demod->decimator->factor) : NULL;
+    // allocated by the detector on the first frame
+    demod->pulse_data     = (pulse_data_t){0};
+    demod->fsk_pulse_data = (pulse_data_t){0};
+
+    demod->channelizer = NULL;
+    demod->channels    = NULL;
+    demod->channel     = NULL;
+    if (cfg->demod->channelizer) {
+        set_channels(job, cfg->demod->channelizer->n_channels);
+        for (unsigned k = 0; k < demod->channelizer->n_channels; ++k) {
+            pulse_detect_set_levels(demod->channels[k].pulse_detect, 1, demod->level_limit, demod->min_level, demod->min_snr, demod->detect_verbosity);
+            demod->channels[k].demod_FM_state.fast_atan = demod->demod_FM_state.fast_atan;
+        }
+    }
+
+    demod->am_buf       = NULL; // allocated on the first frame
+    demod->buf.fm       = NULL;
+    demod->u8_buf       = NULL;
+    demod->f32_buf      = NULL;
+    demod->buf_samples  = 0;
+    demod->decoder_pool = NULL; // the jobs already run in parallel
+    demod->samp_grab    = NULL;
+    demod->am_analyze   = NULL;
+    file_info_clear(&demod->load_info);
+    memset(&demod->dumper, 0, sizeof(demod->dumper));
+    memset(&demod->r_devs, 0, sizeof(demod->r_devs));
+
+    demod->total_frames_count   = 0;
+    demod->total_frames_squelch = 0;
+    demod->total_frames_probed  = 0;
+    demod->total_frames_ook     = 0;
+    demod->total_frames_fsk     = 0;
+    demod->total_frames_events  = 0;
+    demod->frames_ook           = 0;
+    demod->frames_fsk           = 0;
+    demod->frames_events        = 0;
+    demod->demods_skipped       = 0;
+
+    // an independent instance of each registered decoder, in the same order
+    for (void **iter = cfg->demod->r_devs.elems; iter && *iter; ++iter) {
+        r_device const *r_dev = *iter;
+        r_device *p;
+        if (r_dev->create_fn) {
+            p = r_dev->create_fn(r_dev->create_args);
+            if (!p)
+                FATAL("Failed to create a job decoder");
+        }
+        else {
+            p  = malloc(sizeof(*p));
+            if (!p)
+                FATAL_MALLOC("r_create_job_cfg()");
+            *p = *r_dev; // copy
+            p->decode_events   = 0;
+            p->decode_ok       = 0;
+            p->decode_messages = 0;
+            p->decode_skipped  = 0;
+            memset(p->decode_fails, 0, sizeof(p->decode_fails));
+        }
+        p->verbose      = r_dev->verbose;
+        p->verbose_bits = r_dev->verbose_bits;
+        p->log_fn       = r_dev->log_fn;
+        p->output_fn    = r_dev->output_fn;
+        p->output_ctx   = job;
+
+        list_push(&demod->r_devs, p);
+    }
+
+    return job;
+}
+
+void r_free_job_cfg(r_cfg_t *job, r_cfg_t *cfg)
+{
+    struct dm_state *demod = job->demod;
+
+    // merge the statistics, the decoders are in the same order
+    for (size_t i = 0; i < demod->r_devs.len && i < cfg->demod->r_devs.len; ++i) {
+        r_device const *src = demod->r_devs.elems[i];
+        r_device *dst       = cfg->demod->r_devs.elems[i];
+        dst->decode_events   += src->decode_events;
+        dst->decode_ok       += src->decode_ok;
+        dst->decode_messages += src->decode_messages;
+        dst->decode_skipped  += src->decode_skipped;
+        for (size_t k = 0; k < sizeof(dst->decode_fails) / sizeof(*dst->decode_fails); ++k) {
+            dst->decode_fails[k] += src->decode_fails[k];
+        }
+    }
+    cfg->demod->total_frames_count   += demod->total_frames_count;
+    cfg->demod->total_frames_squelch += demod->total_frames_squelch;
+    cfg->demod->total_frames_probed  += demod->total_frames_probed;
+    cfg->demod->total_frames_ook     += demod->total_frames_ook;
+    cfg->demod->total_frames_fsk     += demod->total_frames_fsk;
+    cfg->demod->total_frames_events  += demod->total_frames_events;
+    cfg->demod->frames_ook           += demod->frames_ook;
+    cfg->demod->frames_fsk           += demod->frames_fsk;
+    cfg->demod->frames_events        += demod->frames_events;
+    cfg->demod->demods_skipped       += demod->demods_skipped;
+
+    list_free_elems(&demod->r_devs, (list_elem_free_fn)free_protocol);
+    pulse_detect_free(demod->pulse_detect);
+    pulse_data_free(&demod->pulse_data);
+    pulse_data_free(&demod->fsk_pulse_data);
+    decimator_free(demod->decimator);
+    set_channels(job, 0);
+    free_sdr_flow(job);
+    free(demod);
+    free(job);
+}
+
 /* device decoder protocols */
 
-void register_protocol(r_cfg_t *cfg, r_device const *r_dev, char *arg)
+int register_protocol(r_cfg_t *cfg, r_device const *r_dev, char *arg)
 {
     // use arg of 'v', 'vv', 'vvv' as device verbosity
     int dev_verbose = 0;
@@ -249,6 +407,14 @@ void register_protocol(r_cfg_t *cfg, r_device const *r_dev, char *arg)
     r_device *p;
     if (r_dev->create_fn) {
         p = r_dev->create_fn(arg);
+        if (!p) {
+            return -1; // bad arguments or alloc failure
+        }
+        if (arg) {
+            p->create_args = strdup(arg);
+            if (!p->create_args)
+                FATAL_STRDUP("register_protocol()");
+        }
     }
     else {
         if (arg && *arg) {
@@ -272,10 +438,12 @@ void register_protocol(r_cfg_t *cfg, r_device const *r_dev, char *arg)
     if (cfg->verbosity >= LOG_INFO) {
         fprintf(stderr, "Registering protocol [%u] \"%s\"\n", r_dev->protocol_num, r_dev->name);
     }
+    return 0;
 }
 
 void free_protocol(r_device *r_dev)
 {
+    free(r_dev->create_args);
     free(r_dev->decode_ctx);
     free(r_dev);
 }
@@ -301,16 +469,43 @@ void register_all_protocols(r_cfg_t *cfg, unsigned disabled)
     }
 }
 
+/// An output queued from the DSP thread to the event loop, or captured on a worker.
+typedef struct dsp_event {
+    r_cfg_t *cfg;
+    char const *in_filename; ///< The input file at the time of the output, for the data tags
+    data_t *data;
+    int level; ///< Minimum output log level, 0 for all outputs
+    int tags;  ///< Apply the data tags, which need the event loop, e.g. for gpsd
+} dsp_event_t;
+
+/// Outputs of a worker, held back to be printed in order.
+typedef struct output_capture {
+    r_cfg_t *cfg;            ///< The config of a file job worker, NULL for a decoder pool worker
+    dm_package_t const *pkg; ///< The package of the dispatching thread, if any
+    list_t events;           ///< Captured dsp_event_t
+} output_capture_t;
+
+/// The capture of the current worker, of a decoder pool or a file job.
+static THREAD_LOCAL output_capture_t *output_capture;
+
+/// The package decoded on the current thread, see dsp_thread_package().
+static dm_package_t const *current_package(void)
+{
+    return output_capture ? output_capture->pkg : dsp_thread_package();
+}
+
 /* output helper */
 
 char *time_pos_str(r_cfg_t *cfg, unsigned samples_ago, char *buf)
 {
+    // a package on the slicer thread carries the time of its frame
+    dm_package_t const *pkg = current_package();
     if (cfg->report_time == REPORT_TIME_SAMPLES) {
         double s_per_sample = 1.0f / cfg->samp_rate;
-        return sample_pos_str(cfg->demod->sample_file_pos - samples_ago * s_per_sample, buf);
+        return sample_pos_str((pkg ? pkg->sample_file_pos : cfg->demod->sample_file_pos) - samples_ago * s_per_sample, buf);
     }
     else {
-        struct timeval ago = cfg->demod->now;
+        struct timeval ago = pkg ? pkg->now : cfg->demod->now;
         double us_per_sample = 1e6 / cfg->samp_rate;
         unsigned usecs_ago   = samples_ago * us_per_sample;
         while (ago.tv_usec < (int)usecs_ago) {
@@ -373,6 +568,10 @@ char const **well_known_output_fields(r_cfg_t *cfg)
         list_push(&field_list, "snr");
         list_push(&field_list, "noise");
     }
+    if (cfg->demod->channelizer)
+        list_push(&field_list, "channel_freq");
+    if (cfg->sdr_index >= 0)
+        list_push(&field_list, "sdr");
 
     return (char const **)field_list.elems;
 }
@@ -435,14 +634,127 @@ char const **determine_csv_fields(r_cfg_t *cfg, char const *const *well_known, i
     return (char const **)field_list.elems;
 }
 
-int run_ook_demods(list_t *r_devs, pulse_data_t *pulse_data)
+static int run_ook_demod(r_device *r_dev, pulse_data_t *pulse_data)
+{
+    switch (r_dev->modulation) {
+    case OOK_PULSE_PCM:
+    // case OOK_PULSE_RZ:
+        return pulse_slicer_pcm(pulse_data, r_dev);
+    case OOK_PULSE_PPM:
+        return pulse_slicer_ppm(pulse_data, r_dev);
+    case OOK_PULSE_PWM:
+        return pulse_slicer_pwm(pulse_data, r_dev);
+    case OOK_PULSE_MANCHESTER_ZEROBIT:
+        return pulse_slicer_manchester_zerobit(pulse_data, r_dev);
+    case OOK_PULSE_PIWM_RAW:
+        return pulse_slicer_piwm_raw(pulse_data, r_dev);
+    case OOK_PULSE_PIWM_DC:
+        return pulse_slicer_piwm_dc(pulse_data, r_dev);
+    case OOK_PULSE_DMC:
+        return pulse_slicer_dmc(pulse_data, r_dev);
+    case OOK_PULSE_PWM_OSV1:
+        return pulse_slicer_osv1(pulse_data, r_dev);
+    case OOK_PULSE_NRZS:
+        return pulse_slicer_nrzs(pulse_data, r_dev);
+    case OOK_PULSE_RZI:
+        return pulse_slicer_rzi(pulse_data, r_dev);
+    // FSK decoders
+    case FSK_PULSE_PCM:
+    case FSK_PULSE_PWM:
+    case FSK_PULSE_MANCHESTER_ZEROBIT:
+        return 0;
+    default:
+        fprintf(stderr, "Unknown modulation %u in protocol!\n", r_dev->modulation);
+        return 0;
+    }
+}
+
+static int run_fsk_demod(r_device *r_dev, pulse_data_t *fsk_pulse_data)
+{
+    switch (r_dev->modulation) {
+    // OOK decoders
+    case OOK_PULSE_PCM:
+    // case OOK_PULSE_RZ:
+    case OOK_PULSE_PPM:
+    case OOK_PULSE_PWM:
+    case OOK_PULSE_MANCHESTER_ZEROBIT:
+    case OOK_PULSE_PIWM_RAW:
+    case OOK_PULSE_PIWM_DC:
+    case OOK_PULSE_DMC:
+    case OOK_PULSE_PWM_OSV1:
+    case OOK_PULSE_NRZS:
+    case OOK_PULSE_RZI:
+        return 0;
+    case FSK_PULSE_PCM:
+        return pulse_slicer_pcm(fsk_pulse_data, r_dev);
+    case FSK_PULSE_PWM:
+        return pulse_slicer_pwm(fsk_pulse_data, r_dev);
+    case FSK_PULSE_MANCHESTER_ZEROBIT:
+        return pulse_slicer_manchester_zerobit(fsk_pulse_data, r_dev);
+    default:
+        fprintf(stderr, "Unknown modulation %u in protocol!\n", r_dev->modulation);
+        return 0;
+    }
+}
+
+/// A decoder of a priority level and its results.
+typedef struct demod_task {
+    r_device *r_dev;
+    int events;
+    output_capture_t capture;
+} demod_task_t;
+
+/// The decoders of one priority level, run by a decoder pool.
+typedef struct demod_batch {
+    int (*demod_fn)(r_device *r_dev, pulse_data_t *pulse_data);
+    pulse_data_t *pulse_data;
+    demod_task_t *tasks;
+} demod_batch_t;
+
+static void run_batch_demod(void *ctx, unsigned i)
+{
+    demod_batch_t *batch = ctx;
+    demod_task_t *task   = &batch->tasks[i];
+
+    // the calling thread also runs tasks and might have an outer capture
+    output_capture_t *outer = output_capture;
+    output_capture          = &task->capture;
+    task->events            = batch->demod_fn(task->r_dev, batch->pulse_data);
+    output_capture          = outer;
+}
+
+static void output_event(dsp_event_t *ev);
+
+/// Print the captured outputs of a worker, or pass them on to an outer capture.
+static void flush_capture(output_capture_t *capture)
+{
+    for (void **iter = capture->events.elems; iter && *iter; ++iter) {
+        output_event(*iter);
+    }
+    list_free_elems(&capture->events, NULL);
+}
+
+/// Run the decoders, those with a symbol timing incompatible to @p timing are skipped and counted in @p skipped, if not NULL.
+static int run_demods_fn(decoder_pool_t *pool, list_t *r_devs, pulse_data_t *pulse_data, int (*demod_fn)(r_device *r_dev, pulse_data_t *pulse_data),
+        pulse_timing_t const *timing, unsigned *skipped)
 {
     int p_events = 0;
+    int const fsk = demod_fn == run_fsk_demod;
+
+    demod_batch_t batch = {.demod_fn = demod_fn, .pulse_data = pulse_data};
+    if (pool) {
+        batch.tasks = calloc(r_devs->len, sizeof(*batch.tasks));
+        if (!batch.tasks) {
+            WARN_CALLOC("run_demods()");
+            pool = NULL; // run serially
+        }
+    }
 
     unsigned next_priority = 0; // next smallest on each loop through decoders
     // run all decoders of each priority, stop if an event is produced
     for (unsigned priority = 0; !p_events && priority < UINT_MAX; priority = next_priority) {
         next_priority = UINT_MAX;
+        unsigned n = 0;
         for (void **iter = r_devs->elems; iter && *iter; ++iter) {
             r_device *r_dev = *iter;
 
@@ -452,108 +764,178 @@ int run_ook_demods(list_t *r_devs, pulse_data_t *pulse_data)
             // Run only current priority
             if (r_dev->priority != priority)
                 continue;
-
-            switch (r_dev->modulation) {
-            case OOK_PULSE_PCM:
-            // case OOK_PULSE_RZ:
-                p_events += pulse_slicer_pcm(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PPM:
-                p_events += pulse_slicer_ppm(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PWM:
-                p_events += pulse_slicer_pwm(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_MANCHESTER_ZEROBIT:
-                p_events += pulse_slicer_manchester_zerobit(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PIWM_RAW:
-                p_events += pulse_slicer_piwm_raw(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PIWM_DC:
-                p_events += pulse_slicer_piwm_dc(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_DMC:
-                p_events += pulse_slicer_dmc(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PWM_OSV1:
-                p_events += pulse_slicer_osv1(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_NRZS:
-                p_events += pulse_slicer_nrzs(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_RZI:
-                p_events += pulse_slicer_rzi(pulse_data, r_dev);
-                break;
-            // FSK decoders
-            case FSK_PULSE_PCM:
-            case FSK_PULSE_PWM:
-            case FSK_PULSE_MANCHESTER_ZEROBIT:
-                break;
-            default:
-                fprintf(stderr, "Unknown modulation %u in protocol!\n", r_dev->modulation);
+            // decoders of the other modulation return without slicing anyway
+            if (timing && (r_dev->modulation >= FSK_DEMOD_MIN_VAL) == fsk && !pulse_timing_compatible(timing, r_dev)) {
+                r_dev->decode_skipped += 1;
+                *skipped += 1;
+                continue;
             }
+
+            if (pool)
+                batch.tasks[n++].r_dev = r_dev;
+            else
+                p_events += demod_fn(r_dev, pulse_data);
+        }
+        if (!n) {
+            continue;
+        }
+
+        // decode in parallel, then print the outputs in protocol order as if decoded serially
+        for (unsigned i = 0; i < n; ++i) {
+            batch.tasks[i].capture.cfg = output_capture ? output_capture->cfg : NULL;
+            batch.tasks[i].capture.pkg = current_package();
+        }
+        decoder_pool_run(pool, n, run_batch_demod, &batch);
+        for (unsigned i = 0; i < n; ++i) {
+            p_events += batch.tasks[i].events;
+            flush_capture(&batch.tasks[i].capture);
         }
     }
 
+    free(batch.tasks);
+
     return p_events;
 }
 
-int run_fsk_demods(list_t *r_devs, pulse_data_t *fsk_pulse_data)
+int run_ook_demods(list_t *r_devs, pulse_data_t *pulse_data)
 {
-    int p_events = 0;
+    return run_demods_fn(NULL, r_devs, pulse_data, run_ook_demod, NULL, NULL);
+}
 
-    unsigned next_priority = 0; // next smallest on each loop through decoders
-    // run all decoders of each priority, stop if an event is produced
-    for (unsigned priority = 0; !p_events && priority < UINT_MAX; priority = next_priority) {
-        next_priority = UINT_MAX;
-        for (void **iter = r_devs->elems; iter && *iter; ++iter) {
-            r_device *r_dev = *iter;
+int run_fsk_demods(list_t *r_devs, pulse_data_t *fsk_pulse_data)
+{
+    return run_demods_fn(NULL, r_devs, fsk_pulse_data, run_fsk_demod, NULL, NULL);
+}
 
-            // Find next smallest priority
-            if (r_dev->priority > priority && r_dev->priority < next_priority)
-                next_priority = r_dev->priority;
-            // Run only current priority
-            if (r_dev->priority != priority)
-                continue;
+int run_demods(struct dm_state *demod, pulse_data_t *pulse_data, int package_type)
+{
+    int (*demod_fn)(r_device *r_dev, pulse_data_t *pulse_data) = package_type == PULSE_DATA_FSK ? run_fsk_demod : run_ook_demod;
 
-            switch (r_dev->modulation) {
-            // OOK decoders
-            case OOK_PULSE_PCM:
-            // case OOK_PULSE_RZ:
-            case OOK_PULSE_PPM:
-            case OOK_PULSE_PWM:
-            case OOK_PULSE_MANCHESTER_ZEROBIT:
-            case OOK_PULSE_PIWM_RAW:
-            case OOK_PULSE_PIWM_DC:
-            case OOK_PULSE_DMC:
-            case OOK_PULSE_PWM_OSV1:
-            case OOK_PULSE_NRZS:
-            case OOK_PULSE_RZI:
-                break;
-            case FSK_PULSE_PCM:
-                p_events += pulse_slicer_pcm(fsk_pulse_data, r_dev);
-                break;
-            case FSK_PULSE_PWM:
-                p_events += pulse_slicer_pwm(fsk_pulse_data, r_dev);
-                break;
-            case FSK_PULSE_MANCHESTER_ZEROBIT:
-                p_events += pulse_slicer_manchester_zerobit(fsk_pulse_data, r_dev);
-                break;
-            default:
-                fprintf(stderr, "Unknown modulation %u in protocol!\n", r_dev->modulation);
-            }
-        }
+    if (!demod->timing_filter) {
+        return run_demods_fn(demod->decoder_pool, &demod->r_devs, pulse_data, demod_fn, NULL, NULL);
     }
 
+    pulse_timing_t timing;
+    pulse_timing_analyze(&timing, pulse_data);
+    unsigned skipped = 0;
+    int p_events     = run_demods_fn(demod->decoder_pool, &demod->r_devs, pulse_data, demod_fn, &timing, &skipped);
+
+    demod->demods_skipped += skipped;
+    if (demod->verbosity >= LOG_DEBUG) {
+        print_logf(LOG_DEBUG, "Timing", "Skipped %u of %u decoders on %u pulses", skipped, (unsigned)demod->r_devs.len, pulse_data->num_pulses);
+    }
     return p_events;
 }
 
 /* handlers */
 
+/** Pass the event data to all output handlers with at least the log level. Frees the data afterwards. */
+static void print_outputs(dsp_event_t *ev)
+{
+    r_cfg_t *cfg = ev->cfg;
+    data_t *data = ev->data;
+
+    // apply all tags
+    for (void **iter = cfg->data_tags.elems; ev->tags && iter && *iter; ++iter) {
+        data_tag_t *tag = *iter;
+        data            = data_tag_apply(tag, data, ev->in_filename);
+    }
+
+    for (size_t i = 0; i < cfg->output_handler.len; ++i) { // list might contain NULLs
+        data_output_t *output = cfg->output_handler.elems[i];
+        if (output && (ev->level <= 0 || output->log_level >= ev->level)) {
+            data_output_print(output, data);
+        }
+    }
+    data_free(data);
+}
+
+/** Capture an allocated event on a worker, queue it for the event loop on the DSP thread, or print it. Frees the event afterwards. */
+static void output_event(dsp_event_t *ev)
+{
+    if (output_capture) {
+        list_push(&output_capture->events, ev); // printed after the worker is done
+    }
+    else if (dsp_thread_current()) {
+        // the event loop of this thread's input, logs always carry the first input's config
+        if (dsp_thread_push_event(ev)) {
+            data_free(ev->data); // dropped, the pipeline stopped
+            free(ev);
+        }
+    }
+    else {
+        print_outputs(ev);
+        free(ev);
+    }
+}
+
+/** Print the data structure, or queue it for the event loop if called on the DSP thread. Frees data afterwards. */
+static void output_data(r_cfg_t *cfg, data_t *data, int level, int tags)
+{
+    dsp_event_t tmp = {.cfg = cfg, .in_filename = cfg->in_filename, .data = data, .level = level, .tags = tags};
+    if (!output_capture && !dsp_thread_current()) {
+        print_outputs(&tmp);
+        return;
+    }
+
+    dsp_event_t *ev = malloc(sizeof(*ev));
+    if (!ev) {
+        WARN_MALLOC("output_data()");
+        data_free(data);
+        return;
+    }
+    *ev = tmp;
+    output_event(ev);
+}
+
+void pop_dsp_events(r_cfg_t *cfg)
+{
+    dsp_event_t *ev;
+    while (cfg->dsp && (ev = dsp_thread_pop_event(cfg->dsp))) {
+        print_outputs(ev);
+        free(ev);
+    }
+}
+
+output_capture_t *start_output_capture(r_cfg_t *cfg)
+{
+    output_capture_t *capture = calloc(1, sizeof(*capture));
+    if (!capture) {
+        FATAL_CALLOC("start_output_capture()");
+    }
+    capture->cfg   = cfg;
+    output_capture = capture;
+    return capture;
+}
+
+void stop_output_capture(void)
+{
+    output_capture = NULL;
+}
+
+void print_output_capture(output_capture_t *capture)
+{
+    flush_capture(capture);
+    free(capture);
+}
+
+void discard_output_capture(output_capture_t *capture)
+{
+    for (void **iter = capture->events.elems; iter && *iter; ++iter) {
+        dsp_event_t *ev = *iter;
+        data_free(ev->data);
+    }
+    list_free_elems(&capture->events, free);
+    free(capture);
+}
+
 static void log_handler(log_level_t level, char const *src, char const *msg, void *userdata)
 {
     r_cfg_t *cfg = userdata;
+    // a file job worker logs with the time of its own input
+    if (output_capture && output_capture->cfg) {
+        cfg = output_capture->cfg;
+    }
 
     if (cfg->verbosity < (int)level) {
         return;
@@ -574,23 +956,23 @@ static void log_handler(log_level_t level, char const *src, char const *msg, voi
                 data_str(NULL, "time", "", NULL, time_str));
     }
 
-    for (size_t i = 0; i < cfg->output_handler.len; ++i) { // list might contain NULLs
-        data_output_t *output = cfg->output_handler.elems[i];
-        if (output && output->log_level >= (int)level) {
-            data_output_print(output, data);
-        }
-    }
-    data_free(data);
+    output_data(cfg, data, (int)level, 0);
 }
 
 void r_redirect_logging(r_cfg_t *cfg)
 {
     r_logger_set_log_handler(log_handler, cfg);
+    cfg->log_redirected = 1;
 }
 
 /** Pass the data structure to all output handlers. Frees data afterwards. */
 void event_occurred_handler(r_cfg_t *cfg, data_t *data)
 {
+    // append the SDR input number if there are several
+    if (cfg->sdr_index >= 0) {
+        data = data_int(data, "sdr", "SDR", NULL, cfg->sdr_index);
+    }
+
     // prepend "time" if requested
     if (cfg->report_time != REPORT_TIME_OFF) {
         char time_str[LOCAL_TIME_BUFLEN];
@@ -599,39 +981,45 @@ void event_occurred_handler(r_cfg_t *cfg, data_t *data)
                 data_str(NULL, "time", "", NULL, time_str));
     }
 
-    for (size_t i = 0; i < cfg->output_handler.len; ++i) { // list might contain NULLs
-        data_output_t *output = cfg->output_handler.elems[i];
-        data_output_print(output, data);
+    output_data(cfg, data, 0, 0);
+}
+
+/// The pulse data currently decoded, of the slicer thread package, a channel of the channelizer, or the wideband input.
+static pulse_data_t const *current_pulse_data(r_cfg_t *cfg, int fsk)
+{
+    dm_package_t const *pkg = current_package();
+    if (pkg) {
+        return &pkg->pulse_data;
     }
-    data_free(data);
+    if (cfg->demod->channel) {
+        return fsk ? &cfg->demod->channel->fsk_pulse_data : &cfg->demod->channel->pulse_data;
+    }
+    return fsk ? &cfg->demod->fsk_pulse_data : &cfg->demod->pulse_data;
 }
 
 /** Pass the data structure to all output handlers. Frees data afterwards. */
 void log_device_handler(r_device *r_dev, int level, data_t *data)
 {
     r_cfg_t *cfg = r_dev->output_ctx;
+    pulse_data_t const *pulse_data = current_pulse_data(cfg, 0);
 
     // prepend "time" if requested
     if (cfg->report_time != REPORT_TIME_OFF) {
         char time_str[LOCAL_TIME_BUFLEN];
-        time_pos_str(cfg, cfg->demod->pulse_data.start_ago, time_str);
+        time_pos_str(cfg, pulse_data->start_ago, time_str);
         data = data_prepend(data,
                 data_str(NULL, "time", "", NULL, time_str));
     }
 
-    for (size_t i = 0; i < cfg->output_handler.len; ++i) { // list might contain NULLs
-        data_output_t *output = cfg->output_handler.elems[i];
-        if (output && output->log_level >= level) {
-            data_output_print(output, data);
-        }
-    }
-    data_free(data);
+    output_data(cfg, data, level, 0);
 }
 
 /** Pass the data structure to all output handlers. Frees data afterwards. */
 void data_acquired_handler(r_device *r_dev, data_t *data)
 {
     r_cfg_t *cfg = r_dev->output_ctx;
+    pulse_data_t const *pulse_data     = current_pulse_data(cfg, 0);
+    pulse_data_t const *fsk_pulse_data = current_pulse_data(cfg, 1);
 
 #ifndef NDEBUG
     // check for undeclared csv fields
@@ -802,41 +1190,41 @@ void data_acquired_handler(r_device *r_dev, data_t *data)
                 data_int(NULL, "protocol", "Protocol", NULL, r_dev->protocol_num));
     }
 
-    if (cfg->report_meta && cfg->demod->fsk_pulse_data.fsk_f2_est) {
+    if (cfg->report_meta && fsk_pulse_data->fsk_f2_est) {
         data = data_str(data, "mod",   "Modulation",  NULL,         "FSK");
-        data = data_dbl(data, "freq1", "Freq1",       "%.1f MHz",   cfg->demod->fsk_pulse_data.freq1_hz / 1000000.0);
-        data = data_dbl(data, "freq2", "Freq2",       "%.1f MHz",   cfg->demod->fsk_pulse_data.freq2_hz / 1000000.0);
-        data = data_dbl(data, "rssi",  "RSSI",        "%.1f dB",    cfg->demod->fsk_pulse_data.rssi_db);
-        data = data_dbl(data, "snr",   "SNR",         "%.1f dB",    cfg->demod->fsk_pulse_data.snr_db);
-        data = data_dbl(data, "noise", "Noise",       "%.1f dB",    cfg->demod->fsk_pulse_data.noise_db);
+        data = data_dbl(data, "freq1", "Freq1",       "%.1f MHz",   fsk_pulse_data->freq1_hz / 1000000.0);
+        data = data_dbl(data, "freq2", "Freq2",       "%.1f MHz",   fsk_pulse_data->freq2_hz / 1000000.0);
+        data = data_dbl(data, "rssi",  "RSSI",        "%.1f dB",    fsk_pulse_data->rssi_db);
+        data = data_dbl(data, "snr",   "SNR",         "%.1f dB",    fsk_pulse_data->snr_db);
+        data = data_dbl(data, "noise", "Noise",       "%.1f dB",    fsk_pulse_data->noise_db);
     }
     else if (cfg->report_meta) {
         data = data_str(data, "mod",   "Modulation",  NULL,         "ASK");
-        data = data_dbl(data, "freq",  "Freq",        "%.1f MHz",   cfg->demod->pulse_data.freq1_hz / 1000000.0);
-        data = data_dbl(data, "rssi",  "RSSI",        "%.1f dB",    cfg->demod->pulse_data.rssi_db);
-        data = data_dbl(data, "snr",   "SNR",         "%.1f dB",    cfg->demod->pulse_data.snr_db);
-        data = data_dbl(data, "noise", "Noise",       "%.1f dB",    cfg->demod->pulse_data.noise_db);
+        data = data_dbl(data, "freq",  "Freq",        "%.1f MHz",   pulse_data->freq1_hz / 1000000.0);
+        data = data_dbl(data, "rssi",  "RSSI",        "%.1f dB",    pulse_data->rssi_db);
+        data = data_dbl(data, "snr",   "SNR",         "%.1f dB",    pulse_data->snr_db);
+        data = data_dbl(data, "noise", "Noise",       "%.1f dB",    pulse_data->noise_db);
+    }
+
+    // append the channel frequency if decoding a channel of the channelizer
+    if (cfg->demod->channel) {
+        data = data_dbl(data, "channel_freq", "Channel Freq", "%.3f MHz", (cfg->demod->center_frequency + cfg->demod->channel->freq_offset) / 1000000.0);
+    }
+
+    // append the SDR input number if there are several
+    if (cfg->sdr_index >= 0) {
+        data = data_int(data, "sdr", "SDR", NULL, cfg->sdr_index);
     }
 
     // prepend "time" if requested
     if (cfg->report_time != REPORT_TIME_OFF) {
         char time_str[LOCAL_TIME_BUFLEN];
-        time_pos_str(cfg, cfg->demod->pulse_data.start_ago, time_str);
+        time_pos_str(cfg, pulse_data->start_ago, time_str);
         data = data_prepend(data,
                 data_str(NULL, "time", "", NULL, time_str));
     }
 
-    // apply all tags
-    for (void **iter = cfg->data_tags.elems; iter && *iter; ++iter) {
-        data_tag_t *tag = *iter;
-        data            = data_tag_apply(tag, data, cfg->in_filename);
-    }
-
-    for (size_t i = 0; i < cfg->output_handler.len; ++i) { // list might contain NULLs
-        data_output_t *output = cfg->output_handler.elems[i];
-        data_output_print(output, data);
-    }
-    data_free(data);
+    output_data(cfg, data, 0, 1);
 }
 
 // level 0: do not report (don't call this), 1: report successful devices, 2: report active devices, 3: report all
@@ -874,6 +1262,8 @@ data_t *create_report_data(r_cfg_t *cfg, int level)
             data = data_int(data, "fail_mic",     "", NULL, r_dev->decode_fails[-DECODE_FAIL_MIC]);
         if (r_dev->decode_fails[-DECODE_FAIL_SANITY])
             data = data_int(data, "fail_sanity",  "", NULL, r_dev->decode_fails[-DECODE_FAIL_SANITY]);
+        if (r_dev->decode_skipped)
+            data = data_int(data, "skipped",      "", NULL, r_dev->decode_skipped);
 
         list_push(&dev_data_list, data);
     }
@@ -883,6 +1273,8 @@ data_t *create_report_data(r_cfg_t *cfg, int level)
             "fsk",              "", DATA_INT, cfg->demod->frames_fsk,
             "events",           "", DATA_INT, cfg->demod->frames_events,
             NULL);
+    if (cfg->demod->timing_filter)
+        data = data_int(data, "skipped", "", NULL, cfg->demod->demods_skipped);
 
     char since_str[LOCAL_TIME_BUFLEN];
     format_time_str(since_str, "%Y-%m-%dT%H:%M:%S", cfg->report_time_tz, cfg->demod->frames_since);
@@ -895,6 +1287,44 @@ data_t *create_report_data(r_cfg_t *cfg, int level)
             NULL);
 
     list_free_elems(&dev_data_list, NULL);
+
+    dsp_stats_t stats;
+    dsp_thread_stats(cfg->dsp, &stats);
+
+    if (cfg->dev) {
+        // frames are dropped by the SDR if all frames are in use, or by the DSP thread if its ring is full
+        sdr_stats_t input;
+        sdr_get_stats(cfg->dev, &input);
+        data_t *input_data = data_make(
+                "produced",             "", DATA_INT, input.frames_produced,
+                "consumed",             "", DATA_INT, cfg->demod->total_frames_count,
+                "dropped",              "", DATA_INT, input.frames_dropped + stats.frames_dropped,
+                "overflows",            "", DATA_INT, input.overflows,
+                "lag_max",              "", DATA_INT, input.lag_max,
+                "lag_max_ms",           "", DATA_INT, input.lag_max_ms,
+                NULL);
+        data = data_dat(data, "input", "", NULL, input_data);
+    }
+
+    if (cfg->dsp) {
+        data_t *dsp_data = data_make(
+                "frames_depth",         "", DATA_INT, stats.frames_depth,
+                "frames_high_water",    "", DATA_INT, stats.frames_high_water,
+                "frames_size",          "", DATA_INT, stats.frames_size,
+                "frames_dropped",       "", DATA_INT, stats.frames_dropped,
+                "packages_depth",       "", DATA_INT, stats.packages_depth,
+                "packages_high_water",  "", DATA_INT, stats.packages_high_water,
+                "packages_size",        "", DATA_INT, stats.packages_size,
+                "packages_stalled",     "", DATA_INT, stats.packages_stalled,
+                "events_depth",         "", DATA_INT, stats.events_depth,
+                "events_high_water",    "", DATA_INT, stats.events_high_water,
+                "events_size",          "", DATA_INT, stats.events_size,
+                "events_stalled",       "", DATA_INT, stats.events_stalled,
+                "events_dropped",       "", DATA_INT, stats.events_dropped,
+                NULL);
+        data = data_dat(data, "dsp", "", NULL, dsp_data);
+    }
+
     return data;
 }
 
@@ -906,6 +1336,7 @@ void flush_report_data(r_cfg_t *cfg)
     cfg->demod->frames_ook = 0;
     cfg->demod->frames_fsk = 0;
     cfg->demod->frames_events = 0;
+    cfg->demod->demods_skipped = 0;
 
     for (void **iter = r_devs->elems; iter && *iter; ++iter) {
         r_device *r_dev = *iter;
@@ -918,6 +1349,7 @@ void flush_report_data(r_cfg_t *cfg)
         r_dev->decode_fails[2] = 0;
         r_dev->decode_fails[3] = 0;
         r_dev->decode_fails[4] = 0;
+        r_dev->decode_skipped = 0;
     }
 }
 
@@ -1248,6 +1680,45 @@ void add_dumper(r_cfg_t *cfg, char const *spec, int overwrite)
     }
 }
 
+void set_channels(r_cfg_t *cfg, unsigned n_channels)
+{
+    struct dm_state *demod = cfg->demod;
+
+    if (demod->channelizer) {
+        for (unsigned k = 0; k < demod->channelizer->n_channels; ++k) {
+            pulse_detect_free(demod->channels[k].pulse_detect);
+            pulse_data_free(&demod->channels[k].pulse_data);
+            pulse_data_free(&demod->channels[k].fsk_pulse_data);
+        }
+        free(demod->channels);
+        demod->channels = NULL;
+        channelizer_free(demod->channelizer);
+        demod->channelizer = NULL;
+    }
+
+    if (n_channels < CHANNELIZER_MIN_CHANNELS) {
+        return; // no channelizer
+    }
+
+    demod->channelizer = channelizer_create(n_channels);
+    if (!demod->channelizer) {
+        FATAL("Failed to create the channelizer");
+    }
+    demod->channels = calloc(n_channels, sizeof(*demod->channels));
+    if (!demod->channels) {
+        FATAL_CALLOC("set_channels()");
+    }
+    for (unsigned k = 0; k < n_channels; ++k) {
+        dm_channel_t *ch = &demod->channels[k];
+        ch->pulse_detect = pulse_detect_create();
+        if (!ch->pulse_detect) {
+            FATAL("Failed to create a channel pulse detector");
+        }
+        baseband_low_pass_filter_reset(&ch->lowpass_filter_state);
+        baseband_demod_FM_reset(&ch->demod_FM_state);
+    }
+}
+
 void add_infile(r_cfg_t *cfg, char *in_file)
 {
     list_push(&cfg->in_files, in_file);
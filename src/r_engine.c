@@ -0,0 +1,237 @@
+/** @file
+    Reentrant decoding engine to embed the decoders in other programs.
+
+    An engine wraps a config of its own, events reach the callback through an
+    output in the output list of that config, like any other output.
+    Nothing is set up that would touch process state: no event loop,
+    no DSP thread, no decoder pool, and no log redirection.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "r_engine.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "r_api.h"
+#include "r_flow.h"
+#include "r_private.h"
+#include "r_device.h"
+#include "optparse.h"
+#include "rtl_433.h"
+#include "rtl_433_devices.h"
+#include "pulse_detect.h"
+#include "pulse_data.h"
+#include "baseband.h"
+#include "data.h"
+#include "fatal.h"
+
+struct r_engine {
+    r_cfg_t cfg;
+    r_engine_event_fn event_fn;
+    void *event_ctx;
+    double input_secs; ///< Input time of the IQ data pushed so far
+};
+
+/* Event callback output */
+
+typedef struct {
+    struct data_output output;
+    r_engine_t *engine;
+} data_output_engine_t;
+
+static void R_API_CALLCONV data_output_engine_print(data_output_t *output, data_t *data)
+{
+    r_engine_t *engine = ((data_output_engine_t *)output)->engine;
+
+    if (engine->event_fn) {
+        engine->event_fn(engine->event_ctx, data);
+    }
+}
+
+static void R_API_CALLCONV data_output_engine_free(data_output_t *output)
+{
+    free(output);
+}
+
+/* engine */
+
+r_engine_t *r_engine_create(void)
+{
+    r_engine_t *engine = calloc(1, sizeof(*engine));
+    if (!engine) {
+        WARN_CALLOC("r_engine_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    data_output_engine_t *output = calloc(1, sizeof(*output));
+    if (!output) {
+        WARN_CALLOC("r_engine_create()");
+        free(engine);
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+
+    r_cfg_t *cfg = &engine->cfg;
+    r_init_cfg(cfg);
+    baseband_init(); // kernels chosen by the host are kept
+    cfg->report_time        = REPORT_TIME_SAMPLES;
+    cfg->no_default_devices = 1;
+    cfg->demod->raw_handler = &cfg->raw_handler;
+
+    // log messages have a level above 0, the callback only gets the events
+    output->output.output_print = data_output_engine_print;
+    output->output.output_free  = data_output_engine_free;
+    output->engine              = engine;
+    list_push(&cfg->output_handler, output);
+
+    return engine;
+}
+
+void r_engine_free(r_engine_t *engine)
+{
+    if (!engine) {
+        return;
+    }
+    r_free_cfg(&engine->cfg);
+    free(engine);
+}
+
+r_cfg_t *r_engine_cfg(r_engine_t *engine)
+{
+    return &engine->cfg;
+}
+
+void r_engine_set_event_handler(r_engine_t *engine, r_engine_event_fn fn, void *ctx)
+{
+    engine->event_fn  = fn;
+    engine->event_ctx = ctx;
+}
+
+/// The FM demodulator is only needed if an FSK decoder is registered.
+static void update_fm_demod(r_engine_t *engine)
+{
+    struct dm_state *demod = engine->cfg.demod;
+
+    demod->enable_FM_demod = demod->dumper.len > 0;
+    for (void **iter = demod->r_devs.elems; iter && *iter; ++iter) {
+        r_device *r_dev = *iter;
+        if (r_dev->modulation >= FSK_DEMOD_MIN_VAL) {
+            demod->enable_FM_demod = 1;
+            break;
+        }
+    }
+}
+
+void r_engine_register_defaults(r_engine_t *engine)
+{
+    register_all_protocols(&engine->cfg, 0);
+    update_fm_demod(engine);
+}
+
+int r_engine_register_protocol(r_engine_t *engine, unsigned protocol_num, char *arg)
+{
+    r_cfg_t *cfg = &engine->cfg;
+
+    // disabled above 2 are removed protocols, see the -R option
+    if (protocol_num < 1 || protocol_num > cfg->num_r_devices || cfg->devices[protocol_num - 1].disabled > 2) {
+        return -1;
+    }
+    if (register_protocol(cfg, &cfg->devices[protocol_num - 1], arg)) {
+        return -1;
+    }
+    update_fm_demod(engine);
+    return 0;
+}
+
+int r_engine_register_flex(r_engine_t *engine, char *spec)
+{
+    // the help spec prints the flex usage and exits
+    if (!spec || !*spec || *spec == '?' || !strncasecmp(spec, "help", strlen(spec))) {
+        return -1;
+    }
+    if (register_protocol(&engine->cfg, &flex_decoder, spec)) {
+        return -1;
+    }
+    update_fm_demod(engine);
+    return 0;
+}
+
+int r_engine_set_input(r_engine_t *engine, uint32_t sample_rate, uint32_t center_frequency, int sample_size)
+{
+    r_cfg_t *cfg           = &engine->cfg;
+    struct dm_state *demod = cfg->demod;
+
+    if (sample_size != 2 && sample_size != 4) {
+        return -1;
+    }
+    if (demod->sample_size) {
+        flush_sdr_flow(cfg);
+    }
+
+    cfg->samp_rate          = sample_rate;
+    cfg->center_frequency   = center_frequency;
+    demod->samp_rate        = sample_rate;
+    demod->center_frequency = center_frequency;
+    demod->sample_size      = sample_size;
+
+    // select the discriminator like for an SDR input
+    demod->fsk_pulse_detect_mode = cfg->fsk_pulse_detect_mode;
+    if (cfg->fsk_pulse_detect_mode == FSK_PULSE_DETECT_AUTO) {
+        demod->fsk_pulse_detect_mode = center_frequency > FSK_PULSE_DETECTOR_LIMIT ? FSK_PULSE_DETECT_NEW : FSK_PULSE_DETECT_OLD;
+    }
+    demod->verbosity    = cfg->verbosity;
+    demod->report_noise = cfg->report_noise;
+    demod->raw_mode     = cfg->raw_mode;
+    demod->grab_mode    = cfg->grab_mode;
+
+    pulse_detect_set_levels(demod->pulse_detect, demod->use_mag_est, demod->level_limit, demod->min_level, demod->min_snr, demod->detect_verbosity);
+
+    return 0;
+}
+
+int r_engine_push_iq(r_engine_t *engine, unsigned char const *iq_buf, uint32_t len)
+{
+    r_cfg_t *cfg           = &engine->cfg;
+    struct dm_state *demod = cfg->demod;
+
+    if (!demod->sample_size) {
+        return -1;
+    }
+    if (!len) {
+        return 0; // push_sdr_flow() must not be called with len=0
+    }
+
+    // events are timed at the end of the block, like for file inputs
+    engine->input_secs += (double)len / demod->sample_size / cfg->samp_rate;
+    demod->sample_file_pos = (float)engine->input_secs;
+
+    return push_sdr_flow(cfg, (unsigned char *)iq_buf, len); // the flow only reads its input
+}
+
+int r_engine_flush(r_engine_t *engine)
+{
+    r_cfg_t *cfg = &engine->cfg;
+
+    if (!cfg->demod->sample_size) {
+        return 0;
+    }
+    int events = flush_sdr_flow(cfg);
+    reset_sdr_flow(cfg);
+    return events;
+}
+
+int r_engine_push_pulses(r_engine_t *engine, pulse_data_t const *pulse_data)
+{
+    struct dm_state *demod = engine->cfg.demod;
+
+    // the decoders report the meta data of the current pulse data
+    if (pulse_data->fsk_f2_est) {
+        pulse_data_copy(&demod->fsk_pulse_data, pulse_data);
+        return run_demods(demod, &demod->fsk_pulse_data, PULSE_DATA_FSK);
+    }
+    pulse_data_copy(&demod->pulse_data, pulse_data);
+    return run_demods(demod, &demod->pulse_data, PULSE_DATA_OOK);
+}
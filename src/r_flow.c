@@ -29,10 +29,14 @@
 #include "raw_output.h"
 #include "r_util.h"
 #include "am_analyze.h"
+#include "dsp_thread.h"
 #include "logger.h"
 #include "fatal.h"
 
-static void calc_rssi_snr(struct dm_state const *demod, pulse_data_t *pulse_data)
+#define SQUELCH_PROBE_STRIDE 8     ///< Probe every 8th sample of a frame for the squelch
+#define SQUELCH_PROBE_MARGIN 1.5f  ///< Probed level must be this many dB below the squelch level
+
+static void calc_rssi_snr(struct dm_state const *demod, pulse_data_t *pulse_data, uint32_t center_frequency, int sample_size)
 {
     float ook_high_estimate      = pulse_data->ook_high_estimate > 0 ? pulse_data->ook_high_estimate : 1;
     float ook_low_estimate       = pulse_data->ook_low_estimate > 0 ? pulse_data->ook_low_estimate : 1;
@@ -41,12 +45,12 @@ static void calc_rssi_snr(struct dm_state const *demod, pulse_data_t *pulse_data
     float asnr                   = ook_max_estimate / ook_low_estimate;
     float foffs1                 = (float)pulse_data->fsk_f1_est / INT16_MAX * demod->samp_rate / 2.0f;
     float foffs2                 = (float)pulse_data->fsk_f2_est / INT16_MAX * demod->samp_rate / 2.0f;
-    pulse_data->freq1_hz         = (foffs1 + demod->center_frequency);
-    pulse_data->freq2_hz         = (foffs2 + demod->center_frequency);
-    pulse_data->centerfreq_hz    = demod->center_frequency;
-    pulse_data->depth_bits       = demod->sample_size * 4;
+    pulse_data->freq1_hz         = (foffs1 + center_frequency);
+    pulse_data->freq2_hz         = (foffs2 + center_frequency);
+    pulse_data->centerfreq_hz    = center_frequency;
+    pulse_data->depth_bits       = sample_size * 4;
     // NOTE: for (CU8) amplitude is 10x (because it's squares)
-    if (demod->sample_size == 2 && !demod->use_mag_est) {                    // amplitude (CU8)
+    if (sample_size == 2 && !demod->use_mag_est) {                    // amplitude (CU8)
         pulse_data->range_db = 42.1442f;                                     // 10*log10f(16384.0f) == 20*log10f(128.0f)
         pulse_data->rssi_db  = 10.0f * log10f(ook_high_estimate) - 42.1442f; // 10*log10f(16384.0f)
         pulse_data->noise_db = 10.0f * log10f(ook_low_estimate) - 42.1442f;  // 10*log10f(16384.0f)
@@ -73,6 +77,24 @@ int flush_sdr_flow(r_cfg_t *cfg)
     return push_sdr_flow(cfg, NULL, 0);
 }
 
+/**
+Free the demodulator buffers, they are allocated again on the next frame.
+*/
+void free_sdr_flow(r_cfg_t *cfg)
+{
+    struct dm_state *demod = cfg->demod;
+
+    free(demod->am_buf);
+    demod->am_buf = NULL;
+    free(demod->buf.fm);
+    demod->buf.fm = NULL;
+    free(demod->u8_buf);
+    demod->u8_buf = NULL;
+    free(demod->f32_buf);
+    demod->f32_buf = NULL;
+    demod->buf_samples = 0;
+}
+
 /**
 Reset the SDR IQ data frame processing, e.g. on a new input file.
 */
@@ -89,13 +111,290 @@ void reset_sdr_flow(r_cfg_t *cfg)
 
     demod->min_level_auto = 0.0f;
     demod->noise_level    = 0.0f;
+    demod->squelch_probe  = 0;
 
     baseband_low_pass_filter_reset(&demod->lowpass_filter_state);
     baseband_demod_FM_reset(&demod->demod_FM_state);
 
+    if (demod->decimator) {
+        decimator_reset(demod->decimator);
+    }
+
+    if (demod->channelizer) {
+        channelizer_reset(demod->channelizer);
+        for (unsigned k = 0; k < demod->channelizer->n_channels; ++k) {
+            baseband_low_pass_filter_reset(&demod->channels[k].lowpass_filter_state);
+            baseband_demod_FM_reset(&demod->channels[k].demod_FM_state);
+            pulse_detect_reset(demod->channels[k].pulse_detect);
+        }
+    }
+
     pulse_detect_reset(demod->pulse_detect);
 }
 
+/**
+Check if no package is in progress in the pulse detectors, e.g. before a flush would cut one off.
+*/
+int idle_sdr_flow(r_cfg_t *cfg)
+{
+    struct dm_state *demod = cfg->demod;
+
+    if (demod->channelizer) {
+        for (unsigned k = 0; k < demod->channelizer->n_channels; ++k) {
+            if (!pulse_detect_idle(demod->channels[k].pulse_detect)) {
+                return 0;
+            }
+        }
+    }
+
+    return pulse_detect_idle(demod->pulse_detect);
+}
+
+/**
+Copy a detected package to the slicer thread, waits if the slicer thread is busy.
+*/
+static void queue_package(r_cfg_t *cfg, int package_type, pulse_data_t const *pulse_data)
+{
+    struct dm_state *demod = cfg->demod;
+
+    dm_package_t *pkg = dsp_thread_get_package(cfg->dsp);
+    if (!pkg) {
+        return; // the pipeline is stopping
+    }
+    pkg->package_type    = package_type;
+    pkg->now             = demod->now;
+    pkg->sample_file_pos = demod->sample_file_pos;
+    pulse_data_copy(&pkg->pulse_data, pulse_data); // the package keeps its allocation
+    dsp_thread_push_package(cfg->dsp, pkg);
+}
+
+/**
+Free the pulse data of a package of the package pool, the pool is zeroed on creation.
+*/
+void free_sdr_package(void *package)
+{
+    dm_package_t *pkg = package;
+
+    pulse_data_free(&pkg->pulse_data);
+}
+
+/**
+Run the decoders on a package queued by push_sdr_flow(), called on the slicer thread.
+
+@return Count of successful decoding events
+*/
+int slice_sdr_package(r_cfg_t *cfg, dm_package_t *pkg)
+{
+    struct dm_state *demod = cfg->demod;
+
+    int p_events = 0; // Sensor events successfully detected per package
+    if (pkg->package_type == PULSE_DATA_OOK) {
+        p_events += run_demods(demod, &pkg->pulse_data, PULSE_DATA_OOK);
+        demod->total_frames_ook += 1;
+        demod->frames_ook += 1;
+    }
+    else {
+        p_events += run_demods(demod, &pkg->pulse_data, PULSE_DATA_FSK);
+        demod->total_frames_fsk += 1;
+        demod->frames_fsk += 1;
+    }
+    demod->total_frames_events += p_events > 0;
+    demod->frames_events += p_events > 0;
+
+    if (demod->verbosity >= LOG_TRACE) {
+        pulse_data_print(&pkg->pulse_data);
+    }
+    if (demod->raw_mode == 1 || (demod->raw_mode == 2 && p_events == 0) || (demod->raw_mode == 3 && p_events > 0)) {
+        data_t *data = pulse_data_print_data(&pkg->pulse_data);
+        event_occurred_handler(cfg, data);
+    }
+
+    return p_events;
+}
+
+/**
+Check if a package starts in the input samples owned by a file chunk job, always true outside of chunk jobs.
+
+The package offset is in samples of the input rate divided by @p scale.
+
+Chunks overlap, a package in the overlap is detected by both chunks but decoded only by the owner.
+*/
+static int package_in_chunk(struct dm_state const *demod, pulse_data_t const *pulse_data, unsigned scale)
+{
+    uint64_t pos = pulse_data->offset * scale;
+    return !demod->chunk_until || (pos >= demod->chunk_from && pos < demod->chunk_until);
+}
+
+/**
+Split an IQ data frame into channels and run the demodulators and decoders on each channel.
+
+Channels are always processed, there is no squelch, sample grabbing, or dumping.
+
+@return Count of successful decoding events
+*/
+static int push_channel_flow(r_cfg_t *cfg, unsigned char *iq_buf, unsigned long n_samples)
+{
+    struct dm_state *demod = cfg->demod;
+    channelizer_t *chz     = demod->channelizer;
+    unsigned n_channels    = chz->n_channels;
+    uint32_t ch_rate       = demod->samp_rate / n_channels;
+    char time_str[LOCAL_TIME_BUFLEN];
+
+    // the channel rate and the pulse rescaling need an exact split
+    if (n_samples && demod->samp_rate % n_channels) {
+        print_logf(LOG_ERROR, "Channelizer", "Sample rate %u Hz can't be split into %u channels, use a multiple of %u",
+                demod->samp_rate, n_channels, n_channels);
+        return -1;
+    }
+
+    unsigned long ch_samples = 0;
+    if (n_samples) {
+        // Feed data to all raw outputs (e.g. rtl_tcp)
+        for (void **iter = demod->raw_handler->elems; iter && *iter; ++iter) {
+            raw_output_t *output = *iter;
+            raw_output_frame(output, iq_buf, n_samples * demod->sample_size, demod->iq_frame);
+        }
+
+        get_time_now(&demod->now);
+        demod->total_frames_count += 1;
+
+        ch_samples = channelizer_push(chz, iq_buf, n_samples, demod->sample_size);
+    }
+
+    // Use manual FM low pass value otherwise 0.2 for minmax or 0.1 for classic
+    float fm_low_pass = demod->fm_low_pass != 0.0f ? demod->fm_low_pass : demod->fsk_pulse_detect_mode ? 0.2f : 0.1f;
+
+    int d_events = 0; // Sensor events successfully detected
+    for (unsigned k = 0; k < n_channels; ++k) {
+        dm_channel_t *ch = &demod->channels[k];
+        ch->freq_offset  = channelizer_offset(chz, k, demod->samp_rate);
+        uint32_t ch_freq = demod->center_frequency + ch->freq_offset;
+
+        if (ch_samples) {
+            baseband_demod_AM_FM_cs16(&ch->lowpass_filter_state, &ch->demod_FM_state,
+                    channelizer_output(chz, k), demod->am_buf, demod->buf.fm, ch_samples, ch_rate, fm_low_pass);
+        }
+
+        // the handlers pick up the pulse data and frequency of the current channel
+        demod->channel = ch;
+        int package_type = PULSE_DATA_OOK;  // Just to get us started
+        while (package_type) {
+            int p_events = 0; // Sensor events successfully detected per package
+            package_type = pulse_detect_package(ch->pulse_detect, demod->am_buf, demod->buf.fm, ch_samples,
+                    ch_rate, demod->input_pos / n_channels, &ch->pulse_data, &ch->fsk_pulse_data, demod->fsk_pulse_detect_mode);
+            if (package_type && !package_in_chunk(demod, package_type == PULSE_DATA_FSK ? &ch->fsk_pulse_data : &ch->pulse_data, n_channels)) {
+                continue; // in the overlap of a file chunk, decoded by the neighbouring chunk
+            }
+            if (package_type == PULSE_DATA_OOK) {
+                // scale pulse timings back to the input rate
+                pulse_data_rescale(&ch->pulse_data, n_channels);
+                calc_rssi_snr(demod, &ch->pulse_data, ch_freq, 4);
+                if (demod->analyze_pulses) {
+                    fprintf(stderr, "Detected OOK package\t%s\tchannel %.3f MHz\n", time_pos_str(cfg, ch->pulse_data.start_ago, time_str), ch_freq / 1e6);
+                }
+
+                p_events += run_demods(demod, &ch->pulse_data, PULSE_DATA_OOK);
+                demod->total_frames_ook += 1;
+                demod->total_frames_events += p_events > 0;
+                demod->frames_ook += 1;
+                demod->frames_events += p_events > 0;
+
+                if (demod->verbosity >= LOG_TRACE) {
+                    pulse_data_print(&ch->pulse_data);
+                }
+                if (demod->raw_mode == 1 || (demod->raw_mode == 2 && p_events == 0) || (demod->raw_mode == 3 && p_events > 0)) {
+                    data_t *data = pulse_data_print_data(&ch->pulse_data);
+                    event_occurred_handler(cfg, data);
+                }
+                if (demod->analyze_pulses && (demod->grab_mode <= 1 || (demod->grab_mode == 2 && p_events == 0) || (demod->grab_mode == 3 && p_events > 0))) {
+                    r_device device = {.log_fn = log_device_handler, .output_ctx = cfg};
+                    pulse_analyzer(&ch->pulse_data, package_type, &device);
+                }
+            }
+            else if (package_type == PULSE_DATA_FSK) {
+                // scale pulse timings back to the input rate
+                pulse_data_rescale(&ch->fsk_pulse_data, n_channels);
+                calc_rssi_snr(demod, &ch->fsk_pulse_data, ch_freq, 4);
+                if (demod->analyze_pulses) {
+                    fprintf(stderr, "Detected FSK package\t%s\tchannel %.3f MHz\n", time_pos_str(cfg, ch->fsk_pulse_data.start_ago, time_str), ch_freq / 1e6);
+                }
+
+                p_events += run_demods(demod, &ch->fsk_pulse_data, PULSE_DATA_FSK);
+                demod->total_frames_fsk += 1;
+                demod->total_frames_events += p_events > 0;
+                demod->frames_fsk += 1;
+                demod->frames_events += p_events > 0;
+
+                if (demod->verbosity >= LOG_TRACE) {
+                    pulse_data_print(&ch->fsk_pulse_data);
+                }
+                if (demod->raw_mode == 1 || (demod->raw_mode == 2 && p_events == 0) || (demod->raw_mode == 3 && p_events > 0)) {
+                    data_t *data = pulse_data_print_data(&ch->fsk_pulse_data);
+                    event_occurred_handler(cfg, data);
+                }
+                if (demod->analyze_pulses && (demod->grab_mode <= 1 || (demod->grab_mode == 2 && p_events == 0) || (demod->grab_mode == 3 && p_events > 0))) {
+                    r_device device = {.log_fn = log_device_handler, .output_ctx = cfg};
+                    pulse_analyzer(&ch->fsk_pulse_data, package_type, &device);
+                }
+            }
+            d_events += p_events;
+        }
+        demod->channel = NULL;
+    }
+
+    demod->input_pos += n_samples;
+
+    return d_events;
+}
+
+/// Grow a buffer to @p n elements, the old contents are kept.
+static void *grow_buffer(void *buf, unsigned long n, size_t elem_size)
+{
+    buf = realloc(buf, n * elem_size);
+    if (!buf) {
+        FATAL_REALLOC("grow_buffer()");
+    }
+    return buf;
+}
+
+/**
+Size the demodulator buffers for a frame of @p n_samples.
+
+The buffers only grow, usually once to the block size of the input.
+The logic and conversion buffers are only allocated if a dumper needs them.
+*/
+static void ensure_buffers(struct dm_state *demod, unsigned long n_samples)
+{
+    int need_u8  = 0;
+    int need_f32 = 0;
+    for (void **iter = demod->dumper.elems; iter && *iter; ++iter) {
+        file_info_t const *dumper = *iter;
+        need_u8 |= dumper->format == U8_LOGIC;
+        need_f32 |= dumper->format == CU8_IQ || dumper->format == CS16_IQ
+                || dumper->format == CS8_IQ || dumper->format == CF32_IQ
+                || dumper->format == F32_AM || dumper->format == F32_FM
+                || dumper->format == F32_I || dumper->format == F32_Q;
+    }
+
+    if (n_samples > demod->buf_samples) {
+        demod->buf_samples = n_samples;
+        demod->am_buf      = grow_buffer(demod->am_buf, n_samples, sizeof(*demod->am_buf));
+        demod->buf.fm      = grow_buffer(demod->buf.fm, n_samples, sizeof(*demod->buf.fm));
+        if (demod->u8_buf) {
+            demod->u8_buf = grow_buffer(demod->u8_buf, n_samples, sizeof(*demod->u8_buf));
+        }
+        if (demod->f32_buf) {
+            demod->f32_buf = grow_buffer(demod->f32_buf, n_samples * 2, sizeof(*demod->f32_buf));
+        }
+    }
+    if (need_u8 && !demod->u8_buf) {
+        demod->u8_buf = grow_buffer(NULL, demod->buf_samples, sizeof(*demod->u8_buf));
+    }
+    if (need_f32 && !demod->f32_buf) {
+        demod->f32_buf = grow_buffer(NULL, demod->buf_samples * 2, sizeof(*demod->f32_buf));
+    }
+}
+
 /**
 Push an IQ data frame to the SDR IQ data frame processing.
 
@@ -117,8 +416,25 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
         print_log(LOG_WARNING, __func__, "Sample buffer length not aligned to sample size!");
     }
 
+    ensure_buffers(demod, n_samples);
+
+    // A channelizer replaces the wideband demodulators
+    if (demod->channelizer && demod->load_info.format != S16_AM && demod->load_info.format != S16_FM) {
+        return push_channel_flow(cfg, iq_buf, n_samples);
+    }
+
     int process_frame = 1;
 
+    // The demodulators and pulse detection might run on decimated IQ data,
+    // raw outputs, the sample grabber, and IQ dumpers always see the input rate.
+    unsigned decimation = 1;
+    if (demod->decimator && demod->load_info.format != S16_AM && demod->load_info.format != S16_FM) {
+        decimation = demod->decimator->factor;
+    }
+    unsigned char *bb_buf    = iq_buf;
+    unsigned long bb_samples = n_samples;
+    uint32_t bb_rate         = demod->samp_rate / decimation;
+
     // Process new frame data if available
     if (len) {
 
@@ -126,7 +442,7 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
     // do this here and not in sdr_handler so realtime replay can use rtl_tcp output
     for (void **iter = demod->raw_handler->elems; iter && *iter; ++iter) {
         raw_output_t *output = *iter;
-        raw_output_frame(output, iq_buf, len);
+        raw_output_frame(output, iq_buf, len, demod->iq_frame);
     }
 
     // save last frame time to see if a new second started
@@ -146,32 +462,67 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
         samp_grab_push(demod->samp_grab, iq_buf, len);
     }
 
-    // AM demodulation
+    if (decimation > 1) {
+        bb_buf = decimator_push(demod->decimator, iq_buf, n_samples, demod->sample_size, &bb_samples);
+    }
+
+    // always process frames if loader, dumper, or analyzers are in use, otherwise skip silent frames
+    int force_process = demod->squelch_offset <= 0 || demod->load_info.format || demod->analyze_pulses || demod->dumper.len || demod->samp_grab;
+    // Use manual FM low pass value otherwise 0.2 for minmax or 0.1 for classic
+    float fm_low_pass = demod->fm_low_pass != 0.0f ? demod->fm_low_pass : demod->fsk_pulse_detect_mode ? 0.2f : 0.1f;
+    // Run AM, AM filters, and FM in a single pass if the frame will be processed anyway
+    int fused = demod->enable_FM_demod && force_process;
+
+    // Squelch levels
+    if (demod->min_level_auto == 0.0f) {
+        demod->min_level_auto = demod->min_level;
+    }
+    if (demod->noise_level == 0.0f) {
+        demod->noise_level = demod->min_level_auto - 3.0f;
+    }
+    float squelch_db = demod->noise_level + 3.0f; // or demod->min_level_auto?
+
+    // Probe a strided subset of the frame first, skip the full AM/FM pass if that is clearly noise.
+    // Only after a squelched frame and with a quiet frame end, packages spanning a frame boundary always get the full pass.
     float avg_db;
-    if (demod->sample_size == 2) { // CU8
+    float tail_db = squelch_db;
+    int probe_noise = 0;
+    if (!force_process) {
+        avg_db = baseband_probe_level(bb_buf, demod->sample_size, demod->use_mag_est, bb_samples, SQUELCH_PROBE_STRIDE, &tail_db);
+        probe_noise = demod->squelch_probe
+                && avg_db < squelch_db - SQUELCH_PROBE_MARGIN
+                && tail_db < squelch_db - SQUELCH_PROBE_MARGIN;
+    }
+
+    // AM demodulation
+    if (probe_noise) {
+        demod->total_frames_probed += 1;
+    } else if (fused) {
+        if (demod->sample_size == 2) { // CU8
+            avg_db = baseband_demod_AM_FM(&demod->lowpass_filter_state, &demod->demod_FM_state, demod->use_mag_est,
+                    bb_buf, demod->am_buf, demod->buf.fm, bb_samples, bb_rate, fm_low_pass);
+        } else { // CS16
+            avg_db = baseband_demod_AM_FM_cs16(&demod->lowpass_filter_state, &demod->demod_FM_state,
+                    (int16_t *)bb_buf, demod->am_buf, demod->buf.fm, bb_samples, bb_rate, fm_low_pass);
+        }
+    } else if (demod->sample_size == 2) { // CU8
         if (demod->use_mag_est) {
-            //magnitude_true_cu8(iq_buf, demod->buf.temp, n_samples);
-            avg_db = magnitude_est_cu8(iq_buf, demod->buf.temp, n_samples);
+            //magnitude_true_cu8(bb_buf, demod->buf.temp, bb_samples);
+            avg_db = magnitude_est_cu8(bb_buf, demod->buf.temp, bb_samples);
         }
         else { // amp est
-            avg_db = envelope_detect(iq_buf, demod->buf.temp, n_samples);
+            avg_db = envelope_detect(bb_buf, demod->buf.temp, bb_samples);
         }
     } else { // CS16
-        //magnitude_true_cs16((int16_t *)iq_buf, demod->buf.temp, n_samples);
-        avg_db = magnitude_est_cs16((int16_t *)iq_buf, demod->buf.temp, n_samples);
+        //magnitude_true_cs16((int16_t *)bb_buf, demod->buf.temp, bb_samples);
+        avg_db = magnitude_est_cs16((int16_t *)bb_buf, demod->buf.temp, bb_samples);
     }
 
-    // Squelch silent frames
+    // Squelch silent frames, but process if a package might start at the end of the frame
     //fprintf(stderr, "noise level: %.1f dB current: %.1f dB min level: %.1f dB\n", demod->noise_level, avg_db, demod->min_level_auto);
-    if (demod->min_level_auto == 0.0f) {
-        demod->min_level_auto = demod->min_level;
-    }
-    if (demod->noise_level == 0.0f) {
-        demod->noise_level = demod->min_level_auto - 3.0f;
-    }
-    int noise_only = avg_db < demod->noise_level + 3.0f; // or demod->min_level_auto?
-    // always process frames if loader, dumper, or analyzers are in use, otherwise skip silent frames
-    process_frame = demod->squelch_offset <= 0 || !noise_only || demod->load_info.format || demod->analyze_pulses || demod->dumper.len || demod->samp_grab;
+    int noise_only = probe_noise || avg_db < squelch_db;
+    process_frame = force_process || !noise_only || tail_db >= squelch_db;
+    demod->squelch_probe = !process_frame;
     demod->total_frames_count += 1;
     if (noise_only) {
         demod->total_frames_squelch += 1;
@@ -194,30 +545,28 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
     }
 
     // Run AM filters
-    if (process_frame) {
-        baseband_low_pass_filter(&demod->lowpass_filter_state, demod->buf.temp, demod->am_buf, n_samples);
+    if (process_frame && !fused) {
+        baseband_low_pass_filter(&demod->lowpass_filter_state, demod->buf.temp, demod->am_buf, bb_samples);
     }
 
     // FM demodulation
-    if (demod->enable_FM_demod && process_frame) {
-        // Use manual FM low pass value otherwise 0.2 for minmax or 0.1 for classic
-        float fm_low_pass = demod->fm_low_pass != 0.0f ? demod->fm_low_pass : demod->fsk_pulse_detect_mode ? 0.2f : 0.1f;
+    if (demod->enable_FM_demod && process_frame && !fused) {
         if (demod->sample_size == 2) { // CU8
-            baseband_demod_FM(&demod->demod_FM_state, iq_buf, demod->buf.fm, n_samples, demod->samp_rate, fm_low_pass);
+            baseband_demod_FM(&demod->demod_FM_state, bb_buf, demod->buf.fm, bb_samples, bb_rate, fm_low_pass);
         } else { // CS16
-            baseband_demod_FM_cs16(&demod->demod_FM_state, (int16_t *)iq_buf, demod->buf.fm, n_samples, demod->samp_rate, fm_low_pass);
+            baseband_demod_FM_cs16(&demod->demod_FM_state, (int16_t *)bb_buf, demod->buf.fm, bb_samples, bb_rate, fm_low_pass);
         }
     }
 
     // Handle special input formats
     if (demod->load_info.format == S16_AM) { // The IQ buffer is really AM demodulated data
-        if (len > sizeof(demod->am_buf)) {
+        if (len > demod->buf_samples * sizeof(*demod->am_buf)) {
             FATAL("Buffer too small");
         }
         memcpy(demod->am_buf, iq_buf, len);
     } else if (demod->load_info.format == S16_FM) { // The IQ buffer is really FM demodulated data
         // we would need AM for the envelope too
-        if (len > sizeof(demod->buf.fm)) {
+        if (len > demod->buf_samples * sizeof(*demod->buf.fm)) {
             FATAL("Buffer too small");
         }
         memcpy(demod->buf.fm, iq_buf, len);
@@ -228,6 +577,8 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
     // Run a pulse discriminator and pass packages to all configured slicers
     int d_events = 0; // Sensor events successfully detected
     if (demod->r_devs.len || demod->analyze_pulses || demod->dumper.len || demod->samp_grab) {
+        // Hand packages to the slicer thread, unless the analyzer or grabber need the decoding results right away
+        int sliced = dsp_thread_sliced(cfg->dsp) && !demod->analyze_pulses && !demod->samp_grab;
         // Detect a package and loop through demodulators with pulse data
         int package_type = PULSE_DATA_OOK;  // Just to get us started
         // Initialize all U8 logic buffers
@@ -240,8 +591,18 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
         }
         while (package_type && process_frame) {
             int p_events = 0; // Sensor events successfully detected per package
-            package_type = pulse_detect_package(demod->pulse_detect, demod->am_buf, demod->buf.fm, n_samples,
-                    demod->samp_rate, demod->input_pos, &demod->pulse_data, &demod->fsk_pulse_data, demod->fsk_pulse_detect_mode);
+            package_type = pulse_detect_package(demod->pulse_detect, demod->am_buf, demod->buf.fm, bb_samples,
+                    bb_rate, demod->input_pos / decimation, &demod->pulse_data, &demod->fsk_pulse_data, demod->fsk_pulse_detect_mode);
+            // scale pulse timings back to the input rate
+            if (package_type == PULSE_DATA_OOK && decimation > 1) {
+                pulse_data_rescale(&demod->pulse_data, decimation);
+            }
+            else if (package_type == PULSE_DATA_FSK && decimation > 1) {
+                pulse_data_rescale(&demod->fsk_pulse_data, decimation);
+            }
+            if (package_type && !package_in_chunk(demod, package_type == PULSE_DATA_FSK ? &demod->fsk_pulse_data : &demod->pulse_data, 1)) {
+                continue; // in the overlap of a file chunk, decoded by the neighbouring chunk
+            }
             if (package_type) {
                 // new package: set a first frame start if we are not tracking one already
                 if (!demod->frame_start_ago) {
@@ -251,16 +612,21 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
                 demod->frame_end_ago = demod->pulse_data.end_ago;
             }
             if (package_type == PULSE_DATA_OOK) {
-                calc_rssi_snr(demod, &demod->pulse_data);
+                calc_rssi_snr(demod, &demod->pulse_data, demod->center_frequency, demod->sample_size);
                 if (demod->analyze_pulses) {
                     fprintf(stderr, "Detected OOK package\t%s\n", time_pos_str(cfg, demod->pulse_data.start_ago, time_str));
                 }
 
-                p_events += run_ook_demods(&demod->r_devs, &demod->pulse_data);
-                demod->total_frames_ook += 1;
-                demod->total_frames_events += p_events > 0;
-                demod->frames_ook += 1;
-                demod->frames_events += p_events > 0;
+                if (sliced) {
+                    queue_package(cfg, package_type, &demod->pulse_data);
+                }
+                else {
+                    p_events += run_demods(demod, &demod->pulse_data, PULSE_DATA_OOK);
+                    demod->total_frames_ook += 1;
+                    demod->total_frames_events += p_events > 0;
+                    demod->frames_ook += 1;
+                    demod->frames_events += p_events > 0;
+                }
 
                 // Dump pulse data for this complete package
                 for (void **iter = demod->dumper.elems; iter && *iter; ++iter) {
@@ -276,10 +642,10 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
                     }
                 }
 
-                if (demod->verbosity >= LOG_TRACE) {
+                if (demod->verbosity >= LOG_TRACE && !sliced) {
                     pulse_data_print(&demod->pulse_data);
                 }
-                if (demod->raw_mode == 1 || (demod->raw_mode == 2 && p_events == 0) || (demod->raw_mode == 3 && p_events > 0)) {
+                if (!sliced && (demod->raw_mode == 1 || (demod->raw_mode == 2 && p_events == 0) || (demod->raw_mode == 3 && p_events > 0))) {
                     data_t *data = pulse_data_print_data(&demod->pulse_data);
                     event_occurred_handler(cfg, data);
                 }
@@ -287,23 +653,28 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
                     r_device device = {.log_fn = log_device_handler, .output_ctx = cfg};
                     pulse_analyzer(&demod->pulse_data, package_type, &device);
                 }
-                if (demod->grab_mode == 4 && p_events == 0) {
+                if (demod->grab_mode == 4 && p_events == 0 && !sliced) {
                     r_device device = {.log_fn = log_device_handler, .output_ctx = cfg};
                     int p_quality   = pulse_analyzer_check(&demod->pulse_data, package_type, &device);
                     demod->frame_quality = p_quality > demod->frame_quality ? p_quality : demod->frame_quality;
                 }
             }
             else if (package_type == PULSE_DATA_FSK) {
-                calc_rssi_snr(demod, &demod->fsk_pulse_data);
+                calc_rssi_snr(demod, &demod->fsk_pulse_data, demod->center_frequency, demod->sample_size);
                 if (demod->analyze_pulses) {
                     fprintf(stderr, "Detected FSK package\t%s\n", time_pos_str(cfg, demod->fsk_pulse_data.start_ago, time_str));
                 }
 
-                p_events += run_fsk_demods(&demod->r_devs, &demod->fsk_pulse_data);
-                demod->total_frames_fsk += 1;
-                demod->total_frames_events += p_events > 0;
-                demod->frames_fsk += 1;
-                demod->frames_events += p_events > 0;
+                if (sliced) {
+                    queue_package(cfg, package_type, &demod->fsk_pulse_data);
+                }
+                else {
+                    p_events += run_demods(demod, &demod->fsk_pulse_data, PULSE_DATA_FSK);
+                    demod->total_frames_fsk += 1;
+                    demod->total_frames_events += p_events > 0;
+                    demod->frames_fsk += 1;
+                    demod->frames_events += p_events > 0;
+                }
 
                 // Dump pulse data for this complete package
                 for (void **iter = demod->dumper.elems; iter && *iter; ++iter) {
@@ -319,10 +690,10 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
                     }
                 }
 
-                if (demod->verbosity >= LOG_TRACE) {
+                if (demod->verbosity >= LOG_TRACE && !sliced) {
                     pulse_data_print(&demod->fsk_pulse_data);
                 }
-                if (demod->raw_mode == 1 || (demod->raw_mode == 2 && p_events == 0) || (demod->raw_mode == 3 && p_events > 0)) {
+                if (!sliced && (demod->raw_mode == 1 || (demod->raw_mode == 2 && p_events == 0) || (demod->raw_mode == 3 && p_events > 0))) {
                     data_t *data = pulse_data_print_data(&demod->fsk_pulse_data);
                     event_occurred_handler(cfg, data);
                 }
@@ -330,7 +701,7 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
                     r_device device = {.log_fn = log_device_handler, .output_ctx = cfg};
                     pulse_analyzer(&demod->fsk_pulse_data, package_type, &device);
                 }
-                if (demod->grab_mode == 4 && p_events == 0) {
+                if (demod->grab_mode == 4 && p_events == 0 && !sliced) {
                     r_device device = {.log_fn = log_device_handler, .output_ctx = cfg};
                     int p_quality   = pulse_analyzer_check(&demod->fsk_pulse_data, package_type, &device);
                     demod->frame_quality = p_quality > demod->frame_quality ? p_quality : demod->frame_quality;
@@ -361,8 +732,8 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
             demod->frame_quality     = 0;
         }
 
-        // Dump partial pulse data, might overlap with the last complete package
-        for (void **iter = demod->dumper.elems; iter && *iter; ++iter) {
+        // Dump partial pulse data, might overlap with the last complete package, not rescaled if decimating
+        for (void **iter = demod->dumper.elems; iter && *iter && decimation == 1; ++iter) {
             file_info_t const *dumper = *iter;
             if (dumper->format == U8_LOGIC) {
                 pulse_data_dump_raw(demod->u8_buf, n_samples, demod->input_pos, &demod->pulse_data, 0x02);
@@ -379,7 +750,7 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
 
     // Run the AM analyzer (deprecated)
     if (demod->am_analyze) {
-        am_analyze(demod->am_analyze, demod->am_buf, n_samples, demod->verbosity >= LOG_INFO, NULL);
+        am_analyze(demod->am_analyze, demod->am_buf, bb_samples, demod->verbosity >= LOG_INFO, NULL);
     }
 
     // Save data to all dumpers (expect logic dumpers)
@@ -396,62 +767,62 @@ int push_sdr_flow(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
         if (dumper->format == CU8_IQ) {
             if (demod->sample_size == 4) {
                 for (unsigned long n = 0; n < n_samples * 2; ++n)
-                    ((uint8_t *)demod->buf.temp)[n] = (((int16_t *)iq_buf)[n] / 256) + 128; // scale Q0.15 to Q0.7
-                out_buf = (uint8_t *)demod->buf.temp;
+                    ((uint8_t *)demod->f32_buf)[n] = (((int16_t *)iq_buf)[n] / 256) + 128; // scale Q0.15 to Q0.7
+                out_buf = (uint8_t *)demod->f32_buf;
                 out_len = n_samples * 2 * sizeof(uint8_t);
             }
         }
         else if (dumper->format == CS16_IQ) {
             if (demod->sample_size == 2) {
                 for (unsigned long n = 0; n < n_samples * 2; ++n)
-                    ((int16_t *)demod->buf.temp)[n] = (iq_buf[n] * 256) - 32768; // scale Q0.7 to Q0.15
-                out_buf = (uint8_t *)demod->buf.temp; // this buffer is too small if out_block_size is large
+                    ((int16_t *)demod->f32_buf)[n] = (iq_buf[n] * 256) - 32768; // scale Q0.7 to Q0.15
+                out_buf = (uint8_t *)demod->f32_buf;
                 out_len = n_samples * 2 * sizeof(int16_t);
             }
         }
         else if (dumper->format == CS8_IQ) {
             if (demod->sample_size == 2) {
                 for (unsigned long n = 0; n < n_samples * 2; ++n)
-                    ((int8_t *)demod->buf.temp)[n] = (iq_buf[n] - 128);
+                    ((int8_t *)demod->f32_buf)[n] = (iq_buf[n] - 128);
             }
             else if (demod->sample_size == 4) {
                 for (unsigned long n = 0; n < n_samples * 2; ++n)
-                    ((int8_t *)demod->buf.temp)[n] = ((int16_t *)iq_buf)[n] >> 8;
+                    ((int8_t *)demod->f32_buf)[n] = ((int16_t *)iq_buf)[n] >> 8;
             }
-            out_buf = (uint8_t *)demod->buf.temp;
+            out_buf = (uint8_t *)demod->f32_buf;
             out_len = n_samples * 2 * sizeof(int8_t);
         }
         else if (dumper->format == CF32_IQ) {
             if (demod->sample_size == 2) {
                 for (unsigned long n = 0; n < n_samples * 2; ++n)
-                    ((float *)demod->buf.temp)[n] = (iq_buf[n] - 128) / 128.0f;
+                    demod->f32_buf[n] = (iq_buf[n] - 128) / 128.0f;
             }
             else if (demod->sample_size == 4) {
                 for (unsigned long n = 0; n < n_samples * 2; ++n)
-                    ((float *)demod->buf.temp)[n] = ((int16_t *)iq_buf)[n] / 32768.0f;
+                    demod->f32_buf[n] = ((int16_t *)iq_buf)[n] / 32768.0f;
             }
-            out_buf = (uint8_t *)demod->buf.temp; // this buffer is too small if out_block_size is large
+            out_buf = (uint8_t *)demod->f32_buf;
             out_len = n_samples * 2 * sizeof(float);
         }
         else if (dumper->format == S16_AM) {
             out_buf = (uint8_t *)demod->am_buf;
-            out_len = n_samples * sizeof(int16_t);
+            out_len = bb_samples * sizeof(int16_t);
         }
         else if (dumper->format == S16_FM) {
             out_buf = (uint8_t *)demod->buf.fm;
-            out_len = n_samples * sizeof(int16_t);
+            out_len = bb_samples * sizeof(int16_t);
         }
         else if (dumper->format == F32_AM) {
-            for (unsigned long n = 0; n < n_samples; ++n)
+            for (unsigned long n = 0; n < bb_samples; ++n)
                 demod->f32_buf[n] = demod->am_buf[n] * (1.0f / 0x8000); // scale from Q0.15
             out_buf = (uint8_t *)demod->f32_buf;
-            out_len = n_samples * sizeof(float);
+            out_len = bb_samples * sizeof(float);
         }
         else if (dumper->format == F32_FM) {
-            for (unsigned long n = 0; n < n_samples; ++n)
+            for (unsigned long n = 0; n < bb_samples; ++n)
                 demod->f32_buf[n] = demod->buf.fm[n] * (1.0f / 0x8000); // scale from Q0.15
             out_buf = (uint8_t *)demod->f32_buf;
-            out_len = n_samples * sizeof(float);
+            out_len = bb_samples * sizeof(float);
         }
         else if (dumper->format == F32_I) {
             if (demod->sample_size == 2) {
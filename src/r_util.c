@@ -11,6 +11,7 @@
 
 #include "r_util.h"
 #include "fatal.h"
+#include "compat_pthread.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -289,7 +290,7 @@ char *str_replace(char const *orig, char const *rep, char const *with)
 // Make a more readable string for a frequency.
 char const *nice_freq(double freq)
 {
-    static char buf[30];
+    static THREAD_LOCAL char buf[30]; // per thread, jobs and inputs may run concurrently
 
     if (freq >= 1E9) {
         snprintf (buf, sizeof(buf), "%.3fGHz", freq/1E9);
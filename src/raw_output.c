@@ -15,12 +15,12 @@
 
 /* generic raw_output */
 
-void raw_output_frame(struct raw_output *output, uint8_t const *data, uint32_t len)
+void raw_output_frame(struct raw_output *output, uint8_t const *data, uint32_t len, struct iq_frame *frame)
 {
     if (!output) {
         return;
     }
-    output->output_frame(output, data, len);
+    output->output_frame(output, data, len, frame);
 }
 
 void raw_output_free(struct raw_output *output)
@@ -186,6 +186,8 @@ bool rfraw_parse(pulse_data_t *data, char const *p)
 
     // don't reset pulse data
     // pulse_data_clear(data);
+    if (pulse_data_reserve(data, PD_MAX_PULSES))
+        return false;
 
     while (*p) {
         // skip whitespace and separators
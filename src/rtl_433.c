@@ -27,6 +27,7 @@
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <sys/stat.h>
 
 #include "rtl_433.h"
 #include "r_private.h"
@@ -49,15 +50,21 @@
 #include "fileformat.h"
 #include "samp_grab.h"
 #include "am_analyze.h"
+#include "autotune.h"
 #include "confparse.h"
 #include "term_ctl.h"
 #include "compat_paths.h"
+#include "compat_mmap.h"
 #include "logger.h"
 #include "fatal.h"
 #include "write_sigrok.h"
 #include "sigmf.h"
 #include "mongoose.h"
 #include "delay_timer.h"
+#include "dsp_thread.h"
+#include "decoder_pool.h"
+#include "iq_pool.h"
+#include "compat_pthread.h"
 #include "rtl_433_devices.h"
 
 #ifdef _WIN32
@@ -102,7 +109,8 @@ static void print_version(void)
 _Noreturn
 static void usage(int exit_code)
 {
-    term_help_fprintf(exit_code ? stderr : stdout,
+    FILE *fp = exit_code ? stderr : stdout;
+    term_help_fprintf(fp,
             "Generic RF data receiver and decoder for ISM band devices using RTL-SDR and SoapySDR.\n"
             "Full documentation is available at https://triq.org/\n"
             "\nUsage:\n"
@@ -121,6 +129,7 @@ static void usage(int exit_code)
             "  [-c <path>] Read config options from a file\n"
             "\t\t= Tuner options =\n"
             "  [-d <RTL-SDR USB device index> | :<RTL-SDR USB device serial> | <SoapySDR device query> | rtl_tcp | help]\n"
+            "       Use -d several times to read several devices at once, events are tagged with the \"sdr\" number.\n"
             "  [-g <gain> | help] (default: auto)\n"
             "  [-t <settings>] apply a list of keyword=value settings to the SDR device\n"
             "       e.g. for SoapySDR -t \"antenna=A,bandwidth=4.5M,rfnotch_ctrl=false\"\n"
@@ -142,6 +151,15 @@ static void usage(int exit_code)
             "  [-Y squelch] Skip frames below estimated noise level to reduce cpu load.\n"
             "  [-Y ampest | magest] Choose amplitude or magnitude level estimator.\n"
             "  [-Y filter=<value>] Manual FM low-pass filter cutoff to separate simultaneous transmissions: us (1-9999, e.g. 20), Hz (10000+), or ratio of sample rate (0.0-1.0).\n"
+            "  [-Y fastfm] Faster, approximate atan in FM demodulator.\n"
+            "  [-Y decimate=<n>] Decimate IQ by n (2-16) before demodulation.\n"
+            "  [-Y channels=<n>] Split the sample rate, a multiple of n, into n (2-32) channels, each demodulated and decoded.\n"
+            "  [-Y decoders=<n>] Run the decoders of each priority on n (1-64) threads.\n"
+            "  [-Y timingfilter] Skip decoders whose symbol timing doesn't match the pulse widths of a package to reduce cpu load.\n"
+            "  [-Y autotune[=<file>]] Time the baseband kernels on this CPU and use the fastest, cached in a wisdom file (default: \"rtl_433.wisdom\").\n",
+            DEFAULT_FREQUENCY, DEFAULT_HOP_TIME, DEFAULT_SAMPLE_RATE);
+    // split to stay below the string length limit of ISO C99
+    term_help_fprintf(fp,
             "\t\t= Analyze/Debug options =\n"
             "  [-A] Pulse Analyzer. Enable pulse analysis and decode attempt.\n"
             "       Disable all decoders with -R 0 if you want analyzer output only.\n"
@@ -150,6 +168,10 @@ static void usage(int exit_code)
             "  [-S none | all | unknown | known] Signal auto save. Creates one file per signal.\n"
             "       Note: Saves raw I/Q samples (uint8 pcm, 2 channel). Preferred mode for generating test files.\n"
             "  [-r <filename> | help] Read data from input file instead of a receiver\n"
+            "  [-b <size>] Block size of IQ data frames from receivers and input files (512 to 4194304, default: 262144)\n"
+            "       Input files in CU8, CS16, AM, or FM format are memory-mapped, larger blocks speed up offline decoding\n"
+            "  [-j <n>[:split]] Read n (1-64) input files in parallel, the outputs stay in input file order\n"
+            "       Use \":split\" to also split large IQ files into overlapped chunks read in parallel\n"
             "  [-w <filename> | help] Save data stream to output file (a '-' dumps samples to stdout)\n"
             "  [-W <filename> | help] Save data stream to output file, overwrite existing file\n"
             "\t\t= Data output options =\n"
@@ -163,8 +185,7 @@ static void usage(int exit_code)
             "  [-T <seconds>] Specify number of seconds to run, also 12:34 or 1h23m45s\n"
             "  [-E hop | quit] Hop/Quit after outputting successful event(s)\n"
             "  [-h] Output this usage help and exit\n"
-            "       Use -d, -g, -R, -X, -F, -M, -r, -w, or -W without argument for more help\n\n",
-            DEFAULT_FREQUENCY, DEFAULT_HOP_TIME, DEFAULT_SAMPLE_RATE);
+            "       Use -d, -g, -R, -X, -F, -M, -r, -w, or -W without argument for more help\n\n");
     exit(exit_code);
 }
 
@@ -222,7 +243,10 @@ static void help_device_selection(void)
             "  [-d driver=rtlsdr] Open e.g. specific SoapySDR device\n"
             "\tTo set gain for SoapySDR use -g ELEM=val,ELEM=val,... e.g. -g LNA=20,TIA=8,PGA=2 (for LimeSDR).\n"
             "  [-d rtl_tcp[:[//]host[:port]] (default: localhost:1234)\n"
-            "\tSpecify host/port to connect to with e.g. -d rtl_tcp:127.0.0.1:1234\n");
+            "\tSpecify host/port to connect to with e.g. -d rtl_tcp:127.0.0.1:1234\n"
+            "\tUse -d several times to read several devices at once, e.g. -d 0 -d 1 -f 433.92M -f 868M\n"
+            "\tEither all devices are tuned to a single -f frequency or each to one -f frequency in order.\n"
+            "\tThe events are tagged with the \"sdr\" number of the device, starting at 0.\n");
     exit(0);
 }
 
@@ -396,7 +420,7 @@ static int hasopt(int test, int argc, char *argv[], char const *optstring)
 
 static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg);
 
-#define OPTSTRING "hVvqD:c:x:z:p:a:AI:S:m:M:r:w:W:l:d:t:f:H:g:s:b:n:R:X:F:K:C:T:UGy:E:Y:"
+#define OPTSTRING "hVvqD:c:x:z:p:a:AI:S:m:M:r:j:w:W:l:d:t:f:H:g:s:b:n:R:X:F:K:C:T:UGy:E:Y:"
 
 // these should match the short options exactly
 static struct conf_keywords const conf_keywords[] = {
@@ -423,6 +447,7 @@ static struct conf_keywords const conf_keywords[] = {
         {"analyze_pulses", 'A'},
         {"include_only", 'I'},
         {"read_file", 'r'},
+        {"jobs", 'j'},
         {"write_file", 'w'},
         {"overwrite_file", 'W'},
         {"signal_grabber", 'S'},
@@ -520,7 +545,11 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
             help_device_selection();
         }
 
-        cfg->dev_query = arg;
+        // several devices are served by an SDR input each
+        if (!cfg->dev_queries.len) {
+            cfg->dev_query = arg;
+        }
+        list_push(&cfg->dev_queries, arg);
         break;
     case 'D':
         if (!arg) {
@@ -633,6 +662,19 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
         add_infile(cfg, arg);
         // TODO: file_info_check_read()
         break;
+    case 'j':
+        cfg->jobs = atoiv(arg, 0);
+        if (cfg->jobs < 1 || cfg->jobs > MAX_JOBS) {
+            fprintf(stderr, "Invalid number of jobs: %s\n", arg);
+            usage(1);
+        }
+        char const *opt_split = arg_param(arg);
+        cfg->jobs_split = opt_split && !strcmp(opt_split, "split");
+        if (opt_split && !cfg->jobs_split) {
+            fprintf(stderr, "Invalid jobs option: %s\n", opt_split);
+            usage(1);
+        }
+        break;
     case 'w':
         if (!arg) {
             help_write();
@@ -847,7 +889,9 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
         }
         break;
     case 'X':
-        register_protocol(cfg, &flex_decoder, arg);
+        if (register_protocol(cfg, &flex_decoder, arg)) {
+            exit(1);
+        }
         break;
     case 'q':
         fprintf(stderr, "quiet option (-q) is default and deprecated. See -v to increase verbosity\n");
@@ -977,6 +1021,49 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
             else if (kwargs_match(p, "filter", &val)) {
                 cfg->demod->fm_low_pass = arg_float(val, "-Y filter: ");
             }
+            else if (kwargs_match(p, "timingfilter", &val)) {
+                cfg->demod->timing_filter = atoiv(val, 1);
+            }
+            else if (kwargs_match(p, "fastfm", &val)) {
+                cfg->demod->demod_FM_state.fast_atan = atoiv(val, 1);
+            }
+            else if (kwargs_match(p, "decimate", &val)) {
+                int factor = atoiv(val, 1);
+                if (factor != 1 && (factor < 2 || factor > DECIMATOR_MAX_FACTOR)) {
+                    fprintf(stderr, "Invalid decimation factor: %s\n", val);
+                    usage(1);
+                }
+                decimator_free(cfg->demod->decimator);
+                cfg->demod->decimator = factor > 1 ? decimator_create(factor) : NULL;
+            }
+            else if (kwargs_match(p, "channels", &val)) {
+                int n_channels = atoiv(val, 0);
+                if (n_channels > 1 && (n_channels < CHANNELIZER_MIN_CHANNELS || n_channels > CHANNELIZER_MAX_CHANNELS)) {
+                    fprintf(stderr, "Invalid number of channels: %s\n", val);
+                    usage(1);
+                }
+                set_channels(cfg, n_channels);
+            }
+            else if (kwargs_match(p, "decoders", &val)) {
+                int n_workers = atoiv(val, 0);
+                if (n_workers < 1 || n_workers > DECODER_POOL_MAX_WORKERS) {
+                    fprintf(stderr, "Invalid number of decoder threads: %s\n", val);
+                    usage(1);
+                }
+                decoder_pool_free(cfg->demod->decoder_pool);
+                cfg->demod->decoder_pool = decoder_pool_create(n_workers);
+            }
+            else if (kwargs_match(p, "autotune", &val)) {
+                char const *path = val && *val && *val != ',' ? val : AUTOTUNE_DEFAULT_FILE;
+                size_t len       = strcspn(path, ",");
+                free(cfg->wisdom_file);
+                cfg->wisdom_file = malloc(len + 1);
+                if (!cfg->wisdom_file) {
+                    FATAL_MALLOC("parse_conf_option()");
+                }
+                memcpy(cfg->wisdom_file, path, len);
+                cfg->wisdom_file[len] = '\0';
+            }
             else {
                 fprintf(stderr, "Unknown pulse detector setting: %s\n", p);
                 usage(1);
@@ -1004,6 +1091,12 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
 static r_cfg_t g_cfg;
 static volatile sig_atomic_t sig_hup;
 
+/// Check if the input should stop, the exit flag of the main config also stops the file jobs.
+static int exit_requested(r_cfg_t const *cfg)
+{
+    return cfg->exit_async || g_cfg.exit_async;
+}
+
 // TODO: SIGINFO is not in POSIX...
 #ifndef SIGINFO
 #define SIGINFO 29
@@ -1070,18 +1163,33 @@ static void sighandler(int signum)
 #endif
 
 /**
-Process an IQ data frame with push_sdr_flow() and run side effects.
+Quit or hop after successful decode events if requested.
+*/
+static void after_events(r_cfg_t *cfg, int events)
+{
+    if (cfg->after_successful_events_flag && (events > 0)) {
+        if (cfg->after_successful_events_flag == 1) {
+            cfg->exit_async = 1;
+        }
+        else {
+            cfg->hop_now = 1;
+        }
+    }
+}
+
+/**
+Process an IQ data frame with push_sdr_flow().
+
+Called on the DSP thread if there is one.
+The leased @p frame of @p iq_buf is passed on to the raw outputs, NULL if not leased.
 
 Side effects are:
 - quit on errors.
-- frequency hopping
 - bytes to read
-- run duration
-- stats printing
 - hop on events.
 - quit on events.
 */
-static void process_sdr_frame(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
+static void demod_sdr_frame(r_cfg_t *cfg, iq_frame_t *frame, unsigned char *iq_buf, uint32_t len)
 {
     // Clip frame length and exit if requested
     if ((cfg->bytes_to_read > 0) && (cfg->bytes_to_read <= len)) {
@@ -1120,7 +1228,9 @@ static void process_sdr_frame(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
     cfg->demod->samp_rate        = cfg->samp_rate;
 
     // Send frame data to processing
+    cfg->demod->iq_frame = frame;
     events += push_sdr_flow(cfg, iq_buf, len);
+    cfg->demod->iq_frame = NULL;
 
     // Exit on errors
     if (events < 0) {
@@ -1132,16 +1242,19 @@ static void process_sdr_frame(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
         cfg->bytes_to_read -= len;
     }
 
-    // Action after a successful decode event
-    if (cfg->after_successful_events_flag && (events > 0)) {
-        if (cfg->after_successful_events_flag == 1) {
-            cfg->exit_async = 1;
-        }
-        else {
-            cfg->hop_now = 1;
-        }
-    }
+    after_events(cfg, events);
+}
+
+/**
+Run the side effects of processed frames on the event loop.
 
+Side effects are:
+- frequency hopping
+- run duration
+- stats printing
+*/
+static void run_frame_actions(r_cfg_t *cfg)
+{
     // Check for timer actions
     time_t rawtime;
     time(&rawtime);
@@ -1153,8 +1266,11 @@ static void process_sdr_frame(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
     }
     // Check for interval stats printing
     if (cfg->stats_now || (cfg->report_stats && cfg->stats_interval && rawtime >= cfg->stats_time)) {
-        event_occurred_handler(cfg, create_report_data(cfg, cfg->stats_now ? 3 : cfg->report_stats));
+        dsp_thread_lock(cfg->dsp); // the counters are updated by the DSP thread
+        data_t *data = create_report_data(cfg, cfg->stats_now ? 3 : cfg->report_stats);
         flush_report_data(cfg);
+        dsp_thread_unlock(cfg->dsp);
+        event_occurred_handler(cfg, data);
         if (rawtime >= cfg->stats_time) {
             cfg->stats_time += cfg->stats_interval;
         }
@@ -1177,12 +1293,27 @@ static void process_sdr_frame(r_cfg_t *cfg, unsigned char *iq_buf, uint32_t len)
     }
 }
 
+/**
+Process an IQ data frame with push_sdr_flow() and run side effects.
+*/
+static void process_sdr_frame(r_cfg_t *cfg, iq_frame_t *frame, unsigned char *iq_buf, uint32_t len)
+{
+    demod_sdr_frame(cfg, frame, iq_buf, len);
+    run_frame_actions(cfg);
+}
+
 static void timer_handler(struct mg_connection *nc, int ev, void *ev_data);
 
+/// An SDR event broadcast to the event loop, for the SDR input it was received on.
+typedef struct input_event {
+    r_cfg_t *cfg;
+    sdr_event_t ev;
+} input_event_t;
+
 /**
 Process SDR events.
 
-Called by mg_mgr_poll() for each connection. Processed only for one fixed connection.
+Called by mg_mgr_poll() for each connection. Processed only for the fixed connection of the SDR input.
 
 Print event data and process frames with push_sdr_flow().
 
@@ -1197,13 +1328,14 @@ static void sdr_handler(struct mg_connection *nc, int ev_type, void *ev_data)
     if (nc->sock != INVALID_SOCKET || ev_type != MG_EV_POLL) {
         return;
     }
-    // only process a broadcast on one fixed nc, our defined timer nc (could be any fixed nc)
-    if (nc->handler != timer_handler) {
+    // only process a broadcast on one fixed nc, the timer nc of the SDR input (could be any fixed nc)
+    input_event_t *input_ev = ev_data;
+    if (nc->handler != timer_handler || nc->user_data != input_ev->cfg) {
         return;
     }
 
     r_cfg_t *cfg     = nc->user_data;
-    sdr_event_t *ev = ev_data;
+    sdr_event_t *ev = &input_ev->ev;
     //fprintf(stderr, "sdr_handler...\n");
 
     data_t *data = NULL;
@@ -1239,8 +1371,9 @@ static void sdr_handler(struct mg_connection *nc, int ev_type, void *ev_data)
         }
 
         // Send frame data to processing and run side effets
-        process_sdr_frame(cfg, (unsigned char *)ev->buf, ev->len);
+        process_sdr_frame(cfg, ev->frame, (unsigned char *)ev->buf, ev->len);
     }
+    iq_frame_release(ev->frame); // retained by acquire_callback()
 
     if (cfg->exit_async) {
         if (cfg->verbosity >= 2) {
@@ -1252,7 +1385,79 @@ static void sdr_handler(struct mg_connection *nc, int ev_type, void *ev_data)
 }
 
 /**
-Receive events from the SDR thread then broadcast on our event loop to sdr_handler().
+Print the events of the DSP thread and run the frame side effects.
+
+Called by mg_mgr_poll() for each connection. Processed only for the fixed connection of the SDR input.
+
+Stop the SDR if exit_async is set.
+*/
+static void dsp_handler(struct mg_connection *nc, int ev_type, void *ev_data)
+{
+    // only process polls on a dummy nc
+    if (nc->sock != INVALID_SOCKET || ev_type != MG_EV_POLL) {
+        return;
+    }
+    // only process a broadcast on one fixed nc, the timer nc of the SDR input (could be any fixed nc)
+    if (nc->handler != timer_handler || nc->user_data != *(r_cfg_t **)ev_data) {
+        return;
+    }
+
+    r_cfg_t *cfg = nc->user_data;
+
+    pop_dsp_events(cfg);
+    run_frame_actions(cfg);
+
+    if (cfg->exit_async) {
+        if (cfg->verbosity >= 2) {
+            print_log(LOG_INFO, "Input", "dsp_handler exit");
+        }
+        sdr_stop(cfg->dev);
+        cfg->exit_async++;
+    }
+}
+
+/**
+Process an IQ data frame on the DSP thread.
+*/
+static void dsp_frame(void *ctx, iq_frame_t *iq, uint32_t len, uint32_t sample_rate, uint32_t center_frequency)
+{
+    r_cfg_t *cfg = ctx;
+
+    cfg->samp_rate        = sample_rate;
+    cfg->center_frequency = center_frequency;
+
+    if (len > 0) {
+        cfg->watchdog++; // reset the frame acquire watchdog
+    }
+
+    demod_sdr_frame(cfg, iq, iq->buf, len);
+}
+
+/**
+Decode a package on the slicer thread.
+*/
+static void dsp_package(void *ctx, void *package)
+{
+    r_cfg_t *cfg = ctx;
+
+    after_events(cfg, slice_sdr_package(cfg, package));
+}
+
+/**
+Wake the event loop from the DSP or slicer thread to run dsp_handler().
+*/
+static void dsp_wake(void *ctx)
+{
+    r_cfg_t *cfg = ctx;
+    mg_broadcast(cfg->mgr, dsp_handler, &cfg, sizeof(cfg));
+}
+
+/**
+Receive events from the SDR thread.
+
+IQ frames are queued for the DSP thread if there is one,
+other events are broadcast on our event loop to sdr_handler().
+The leased frame is retained until processed, the SDR never overwrites it meanwhile.
 
 Note that this function is called in a different thread.
 */
@@ -1262,14 +1467,23 @@ static void acquire_callback(sdr_event_t *ev, void *ctx)
     //get_time_now(&now);
     //fprintf(stderr, "%ld.%06ld acquire_callback...\n", (long)now.tv_sec, (long)now.tv_usec);
 
-    struct mg_mgr *mgr = ctx;
+    r_cfg_t *cfg = ctx;
 
-    // TODO: We should run the demod here to unblock the event loop
+    // lock-free hand over, a full ring drops the frame
+    if (cfg->dsp && ev->ev == SDR_EV_DATA) {
+        dsp_thread_push_frame(cfg->dsp, ev->frame, (uint32_t)ev->len, ev->sample_rate, ev->center_frequency);
+        return;
+    }
+
+    if (ev->frame) {
+        iq_frame_retain(ev->frame); // released by sdr_handler()
+    }
 
     // thread-safe dispatch, ev_data is the iq buffer pointer and length
     // mg_mgr_poll() calls specified callback for each connection.
     //fprintf(stderr, "acquire_callback bc send...\n");
-    mg_broadcast(mgr, sdr_handler, (void *)ev, sizeof(*ev));
+    input_event_t input_ev = {.cfg = cfg, .ev = *ev};
+    mg_broadcast(cfg->mgr, sdr_handler, &input_ev, sizeof(input_ev));
     //fprintf(stderr, "acquire_callback bc done...\n");
 }
 
@@ -1328,7 +1542,7 @@ static int start_sdr(r_cfg_t *cfg)
 
     sdr_set_center_freq(cfg->dev, cfg->center_frequency, 1); // always verbose
 
-    r = sdr_start(cfg->dev, acquire_callback, (void *)get_mgr(cfg),
+    r = sdr_start(cfg->dev, acquire_callback, (void *)cfg,
             DEFAULT_ASYNC_BUF_NUMBER, cfg->out_block_size);
     if (r < 0) {
         print_logf(LOG_ERROR, "Input", "async start failed (%d).", r);
@@ -1353,9 +1567,12 @@ static void timer_handler(struct mg_connection *nc, int ev, void *ev_data)
 {
     //fprintf(stderr, "%s: %d, %d, %p, %p\n", __func__, nc->sock, ev, nc->user_data, ev_data);
     r_cfg_t *cfg = (r_cfg_t *)nc->user_data;
-    if (sig_hup) {
+    // the first SDR input has the dumpers
+    if (sig_hup && cfg->sdr_index <= 0) {
         reopen_outputs(cfg);
+        dsp_thread_lock(cfg->dsp); // the dumpers are written by the DSP thread
         reopen_dumpers(cfg);
+        dsp_thread_unlock(cfg->dsp);
         sig_hup = 0;
     }
     switch (ev) {
@@ -1424,6 +1641,550 @@ static void timer_handler(struct mg_connection *nc, int ev, void *ev_data)
     }
 }
 
+/// CF32 is read as blocks of CS16 but needs twice the space before the conversion
+#define FILE_BUF_SIZE(block_len) ((block_len) / sizeof(int16_t) * sizeof(float))
+
+/// A range of blocks of an IQ input file for a job, read with some blocks before and after to complete the packages at the edges.
+typedef struct file_chunk {
+    unsigned index;    ///< Chunk number, 0 for the first
+    unsigned n_chunks; ///< Number of chunks the file is split into
+    int first_block;   ///< First block owned by the chunk
+    int end_block;     ///< End of the blocks owned by the chunk
+    int lead_in;       ///< Blocks read before the owned blocks
+    int overlap;       ///< Blocks read at least after the owned blocks, more until no package is in progress
+} file_chunk_t;
+
+/// Time to settle the pulse detector level estimators before a chunk, in milliseconds.
+#define FILE_CHUNK_SETTLE_MS 1000
+
+/**
+Read and process one input file or a chunk of an input file, @p buf needs FILE_BUF_SIZE(out_block_size) bytes.
+
+Formats that need no conversion are processed from a read-only mapping of the file without copying,
+other formats and stdin are read into @p buf.
+Only packages starting in the blocks owned by a @p chunk are decoded.
+
+@return 0 on success, -1 if the file can't be read
+*/
+static int process_file(r_cfg_t *cfg, char const *filename, uint32_t sample_rate_0, unsigned char *buf, file_chunk_t const *chunk)
+{
+    struct dm_state *demod = cfg->demod;
+
+    cfg->in_filename = filename;
+
+    file_info_clear(&demod->load_info); // reset all info
+    file_info_parse_filename(&demod->load_info, cfg->in_filename);
+    // apply file info or default
+    cfg->samp_rate        = demod->load_info.sample_rate ? demod->load_info.sample_rate : sample_rate_0;
+    cfg->center_frequency = demod->load_info.center_frequency ? demod->load_info.center_frequency : cfg->frequency[0];
+
+    FILE *in_file;
+    if (demod->load_info.container == FILEFMT_SIGMF) { // unpack tar
+        sigmf_t sigmf = {0};
+        int rc = sigmf_reader_open(&sigmf, cfg->in_filename);
+        // handle errors
+        print_logf(LOG_INFO, "Input", "Opening returned \"%d\"", rc);
+        // copy meta
+        demod->load_info.format = CU8_IQ;
+        cfg->samp_rate          = sigmf.sample_rate;
+        cfg->center_frequency   = sigmf.first_frequency;
+        in_file                 = sigmf.mtar.stream;
+    }
+    else if (strcmp(demod->load_info.path, "-") == 0) { // read samples from stdin
+        in_file = stdin;
+        cfg->in_filename = "<stdin>";
+    } else {
+        in_file = fopen(demod->load_info.path, "rb");
+        if (!in_file) {
+            print_logf(LOG_ERROR, "Input", "Opening file \"%s\" failed!", cfg->in_filename);
+            return -1;
+        }
+    }
+    // a split file is announced by the first chunk only
+    int first_chunk = !chunk || chunk->index == 0;
+    int last_chunk  = !chunk || chunk->index + 1 == chunk->n_chunks;
+    if (first_chunk) {
+        print_logf(LOG_CRITICAL, "Input", "Test mode active. Reading samples from file: %s", cfg->in_filename); // Essential information (not quiet)
+    }
+    if (demod->load_info.format == CU8_IQ
+            || demod->load_info.format == CS8_IQ
+            || demod->load_info.format == S16_AM
+            || demod->load_info.format == S16_FM) {
+        demod->sample_size = sizeof(uint8_t) * 2; // CU8, AM, FM
+    } else if (demod->load_info.format == CS16_IQ
+            || demod->load_info.format == CF32_IQ) {
+        demod->sample_size = sizeof(int16_t) * 2; // CS16, CF32 (after conversion)
+    } else if (demod->load_info.format == PULSE_OOK) {
+        // ignore
+    } else {
+        print_logf(LOG_ERROR, "Input", "Input format invalid \"%s\"", file_info_string(&demod->load_info));
+        return -1;
+    }
+    if (cfg->verbosity >= LOG_NOTICE && first_chunk) {
+        print_logf(LOG_NOTICE, "Input", "Input format \"%s\"", file_info_string(&demod->load_info));
+    }
+    demod->sample_file_pos = 0.0;
+
+    // special case for pulse data file-inputs
+    if (demod->load_info.format == PULSE_OOK) {
+        while (!exit_requested(cfg)) {
+            pulse_data_load(in_file, &demod->now, &demod->pulse_data, cfg->samp_rate);
+            if (!demod->pulse_data.num_pulses) {
+                break;
+            }
+
+            for (void **iter = demod->dumper.elems; iter && *iter; ++iter) {
+                file_info_t const *dumper = *iter;
+                if (dumper->format == VCD_LOGIC) {
+                    pulse_data_print_vcd(dumper->file, &demod->pulse_data, '\'');
+                } else if (dumper->format == PULSE_OOK) {
+                    pulse_data_dump(dumper->file, &demod->pulse_data);
+                } else {
+                    print_logf(LOG_ERROR, "Input", "Dumper (%s) not supported on OOK input", dumper->spec);
+                    exit(1);
+                }
+            }
+
+            if (demod->pulse_data.fsk_f2_est) {
+                run_fsk_demods(&demod->r_devs, &demod->pulse_data);
+            }
+            else {
+                int p_events = run_ook_demods(&demod->r_devs, &demod->pulse_data);
+                if (cfg->verbosity >= LOG_DEBUG) {
+                    pulse_data_print(&demod->pulse_data);
+                }
+                if (demod->analyze_pulses && (cfg->grab_mode <= 1 || (cfg->grab_mode == 2 && p_events == 0) || (cfg->grab_mode == 3 && p_events > 0))) {
+                    r_device device = {.log_fn = log_device_handler, .output_ctx = cfg};
+                    pulse_analyzer(&demod->pulse_data, PULSE_DATA_OOK, &device);
+                }
+            }
+        }
+
+        if (in_file != stdin) {
+            fclose(in_file);
+        }
+
+        return 0;
+    }
+
+    // default case for file-inputs
+    uint32_t block_len = cfg->out_block_size;
+    int block_bytes    = demod->load_info.format == CF32_IQ ? block_len * 2 : block_len;
+    int n_blocks       = 0;
+    int end_blocks     = 0; // read to the end of the file
+
+    // formats that need no conversion are mapped and passed on without copying, if possible
+    mmap_view_t view = {0};
+    size_t view_pos  = 0;
+    int mapped       = 0;
+    if ((demod->load_info.format == CU8_IQ
+                || demod->load_info.format == CS16_IQ
+                || demod->load_info.format == S16_AM
+                || demod->load_info.format == S16_FM)
+            && in_file != stdin && demod->load_info.container != FILEFMT_SIGMF) {
+        mapped = mmap_view_open(&view, in_file) == 0;
+    }
+
+    if (chunk) {
+        // start in the lead-in before the chunk, offsets count input samples from the start of the file
+        int block_samples = block_len / demod->sample_size;
+        n_blocks          = chunk->first_block > chunk->lead_in ? chunk->first_block - chunk->lead_in : 0;
+        end_blocks        = last_chunk ? 0 : chunk->end_block + chunk->overlap;
+        view_pos          = (size_t)n_blocks * block_bytes;
+        if (!mapped && fseeko(in_file, (int64_t)n_blocks * block_bytes, SEEK_SET)) {
+            print_logf(LOG_ERROR, "Input", "Seeking in file \"%s\" failed!", cfg->in_filename);
+            fclose(in_file);
+            return -1;
+        }
+        demod->input_pos   = (uint64_t)n_blocks * block_samples;
+        demod->chunk_from  = (uint64_t)chunk->first_block * block_samples;
+        demod->chunk_until = last_chunk ? UINT64_MAX : (uint64_t)chunk->end_block * block_samples;
+    }
+    unsigned long n_read;
+    delay_timer_t delay_timer;
+    delay_timer_init(&delay_timer);
+    // a chunk reads on past its overlap until a package in progress is complete
+    do {
+        // Replay in realtime if requested
+        if (cfg->in_replay) {
+            // per block delay
+            unsigned delay_us = (unsigned)(1000000llu * block_len / cfg->samp_rate / demod->sample_size / cfg->in_replay);
+            if (demod->load_info.format == CF32_IQ) {
+                delay_us /= 2; // adjust for float only reading half as many samples
+            }
+            delay_timer_wait(&delay_timer, delay_us);
+        }
+        unsigned char *iq_buf = buf;
+        if (mapped) {
+            // the flow only reads the input, the view is passed on directly
+            n_read = view_pos < view.size ? view.size - view_pos : 0;
+            n_read = n_read < block_len ? n_read : block_len;
+            if (n_read) {
+                iq_buf = (unsigned char *)&view.data[view_pos];
+                view_pos += n_read;
+            }
+        }
+        // Convert CF32 file to CS16 in place
+        else if (demod->load_info.format == CF32_IQ) {
+            n_read = fread(buf, sizeof(float), block_len / 2, in_file);
+            // clamp float to [-1,1] and scale to Q0.15
+            baseband_convert_cf32_cs16((float *)buf, (int16_t *)buf, n_read);
+            n_read *= 2; // convert to byte count
+        } else {
+            n_read = fread(buf, 1, block_len, in_file);
+
+            // Convert CS8 file to CU8 in place
+            if (demod->load_info.format == CS8_IQ) {
+                baseband_convert_cs8_cu8(buf, n_read);
+            }
+        }
+        if (n_read == 0) {
+            break;  // push_sdr_flow() must not be called with len=0
+        }
+        demod->sample_file_pos = ((float)n_blocks * block_len + n_read) / cfg->samp_rate / demod->sample_size;
+        n_blocks++; // this assumes n_read == block_len
+        process_sdr_frame(cfg, NULL, iq_buf, n_read);
+    } while (n_read != 0 && !exit_requested(cfg) && (!end_blocks || n_blocks < end_blocks || !idle_sdr_flow(cfg)));
+
+    // Flush to ensure EOP detection
+    flush_sdr_flow(cfg);
+    demod->chunk_from  = 0;
+    demod->chunk_until = 0;
+
+    //Always classify a signal at the end of the file
+    if (demod->am_analyze) {
+        am_analyze_classify(demod->am_analyze);
+    }
+    if (cfg->verbosity >= LOG_NOTICE && last_chunk) {
+        print_logf(LOG_NOTICE, "Input", "Test mode file issued %d packets", n_blocks);
+    }
+    reset_sdr_flow(cfg);
+
+    mmap_view_close(&view);
+    if (in_file != stdin) {
+        fclose(in_file);
+    }
+
+    return 0;
+}
+
+#ifdef THREADS
+/// A file or a chunk of a file for a job, the outputs are held back to be printed in input order.
+typedef struct file_task {
+    char const *filename;
+    file_chunk_t chunk; ///< The chunk of the file if n_chunks is set, otherwise the whole file
+    struct output_capture *capture;
+    int done;
+    int rc;
+} file_task_t;
+
+/// Input files processed in parallel.
+typedef struct file_jobs {
+    r_cfg_t *cfg;
+    uint32_t sample_rate_0;
+    pthread_mutex_t lock;
+    pthread_cond_t done_cond; ///< signaled when a task is done
+    unsigned n_tasks;
+    unsigned next; ///< next task to take
+    int failed;    ///< a task failed or the printing stopped, take no more tasks
+    file_task_t *tasks;
+} file_jobs_t;
+
+typedef struct file_job_worker {
+    file_jobs_t *jobs;
+    r_cfg_t *job;
+    unsigned char *buf;
+    pthread_t thread;
+} file_job_worker_t;
+
+static THREAD_RETURN THREAD_CALL file_job_run(void *arg)
+{
+    file_job_worker_t *worker = arg;
+    file_jobs_t *jobs         = worker->jobs;
+
+    pthread_mutex_lock(&jobs->lock);
+    while (!jobs->failed && jobs->next < jobs->n_tasks) {
+        file_task_t *task = &jobs->tasks[jobs->next++];
+        pthread_mutex_unlock(&jobs->lock);
+
+        struct output_capture *capture = start_output_capture(worker->job);
+        int rc = process_file(worker->job, task->filename, jobs->sample_rate_0, worker->buf, task->chunk.n_chunks ? &task->chunk : NULL);
+        stop_output_capture();
+
+        pthread_mutex_lock(&jobs->lock);
+        task->capture = capture;
+        task->rc      = rc;
+        task->done    = 1;
+        if (rc < 0 || exit_requested(worker->job)) {
+            jobs->failed = 1;
+            task->rc     = -1; // the task might be cut short, print nothing after it
+        }
+        pthread_cond_broadcast(&jobs->done_cond);
+    }
+    pthread_mutex_unlock(&jobs->lock);
+
+    return (THREAD_RETURN)0;
+}
+
+/**
+Add the tasks for an input file, a task per chunk if the file is a large IQ file and splitting is enabled.
+
+The chunks overlap by at least the longest gap to end a package plus the longest reset limit of all decoders,
+a chunk then reads on until the pulse detector is idle, a package of any length is complete.
+A chunk also starts early to settle the level estimators of the pulse detector.
+There are a few chunks per job to balance the load, each much longer than the overlap.
+*/
+static void add_file_tasks(file_jobs_t *jobs, char const *filename)
+{
+    r_cfg_t *cfg      = jobs->cfg;
+    file_task_t *task = &jobs->tasks[jobs->n_tasks];
+    task->filename    = filename;
+    jobs->n_tasks++;
+
+    file_info_t info = {0};
+    file_info_parse_filename(&info, filename);
+    int sample_size;
+    if (info.format == CU8_IQ || info.format == CS8_IQ || info.format == S16_AM || info.format == S16_FM) {
+        sample_size = sizeof(uint8_t) * 2;
+    }
+    else if (info.format == CS16_IQ || info.format == CF32_IQ) {
+        sample_size = sizeof(int16_t) * 2;
+    }
+    else {
+        return; // not an IQ file, it's read whole
+    }
+    struct stat st;
+    if (!cfg->jobs_split || info.container == FILEFMT_SIGMF || !info.path || stat(info.path, &st) != 0) {
+        return;
+    }
+
+    int block_bytes   = info.format == CF32_IQ ? cfg->out_block_size * 2 : cfg->out_block_size;
+    int block_samples = cfg->out_block_size / sample_size;
+    int n_blocks      = (int)((st.st_size + block_bytes - 1) / block_bytes);
+    uint32_t samp_rate = info.sample_rate ? info.sample_rate : jobs->sample_rate_0;
+
+    float reset_limit = 0.0f;
+    for (void **iter = cfg->demod->r_devs.elems; iter && *iter; ++iter) {
+        r_device const *r_dev = *iter;
+        reset_limit = r_dev->reset_limit > reset_limit ? r_dev->reset_limit : reset_limit;
+    }
+    double overlap_samples = (PD_MAX_GAP_MS / 1000.0 + reset_limit / 1000000.0) * samp_rate;
+    int overlap            = (int)(overlap_samples / block_samples) + 1;
+    int lead_in            = overlap + (int)((double)FILE_CHUNK_SETTLE_MS / 1000.0 * samp_rate / block_samples) + 1;
+
+    int chunk_blocks = (n_blocks + cfg->jobs * 4 - 1) / (cfg->jobs * 4);
+    if (chunk_blocks < lead_in * 4) {
+        chunk_blocks = lead_in * 4;
+    }
+    unsigned n_chunks = (unsigned)((n_blocks + chunk_blocks - 1) / chunk_blocks);
+    if (n_chunks < 2) {
+        return;
+    }
+
+    for (unsigned i = 0; i < n_chunks; ++i) {
+        task                    = &jobs->tasks[jobs->n_tasks - 1 + i];
+        task->filename          = filename;
+        task->chunk.index       = i;
+        task->chunk.n_chunks    = n_chunks;
+        task->chunk.first_block = (int)i * chunk_blocks;
+        task->chunk.end_block   = (int)(i + 1) * chunk_blocks < n_blocks ? (int)(i + 1) * chunk_blocks : n_blocks;
+        task->chunk.lead_in     = lead_in;
+        task->chunk.overlap     = overlap;
+    }
+    jobs->n_tasks += n_chunks - 1;
+}
+
+/**
+Process the input files on worker threads, each with its own demodulator and decoders.
+
+The outputs are printed in input file order, identical to processing the files in turn.
+
+@return 0 on success, -1 if no worker could be started
+*/
+static int process_file_jobs(r_cfg_t *cfg, uint32_t sample_rate_0)
+{
+    file_jobs_t jobs   = {0};
+    jobs.cfg           = cfg;
+    jobs.sample_rate_0 = sample_rate_0;
+
+    // a split file has at most 4 chunks per job
+    unsigned max_tasks = (unsigned)cfg->in_files.len * (cfg->jobs_split ? (unsigned)cfg->jobs * 4 : 1);
+    jobs.tasks = calloc(max_tasks, sizeof(*jobs.tasks));
+    if (!jobs.tasks) {
+        WARN_CALLOC("process_file_jobs()");
+        return -1;
+    }
+    for (void **iter = cfg->in_files.elems; iter && *iter; ++iter) {
+        add_file_tasks(&jobs, *iter);
+    }
+
+    unsigned n_workers = (unsigned)cfg->jobs < jobs.n_tasks ? (unsigned)cfg->jobs : jobs.n_tasks;
+    file_job_worker_t *workers = calloc(n_workers, sizeof(*workers));
+    if (!workers) {
+        WARN_CALLOC("process_file_jobs()");
+        free(jobs.tasks);
+        return -1;
+    }
+    pthread_mutex_init(&jobs.lock, NULL);
+    pthread_cond_init(&jobs.done_cond, NULL);
+
+    unsigned n_started = 0;
+    for (; n_started < n_workers; ++n_started) {
+        file_job_worker_t *worker = &workers[n_started];
+        worker->jobs = &jobs;
+        worker->job  = r_create_job_cfg(cfg);
+        worker->buf  = malloc(FILE_BUF_SIZE(cfg->out_block_size));
+        if (!worker->buf) {
+            FATAL_MALLOC("process_file_jobs()");
+        }
+        int r = pthread_create(&worker->thread, NULL, file_job_run, worker);
+        if (r) {
+            print_logf(LOG_ERROR, "Input", "Error in pthread_create, rc: %d", r);
+            free(worker->buf);
+            r_free_job_cfg(worker->job, cfg);
+            break;
+        }
+    }
+
+    // print the outputs in input order, stop at the first task that failed
+    for (unsigned i = 0; n_started && i < jobs.n_tasks; ++i) {
+        pthread_mutex_lock(&jobs.lock);
+        // after a failure or exit the tasks not yet taken are never done
+        while (!jobs.tasks[i].done && !(jobs.failed && i >= jobs.next)) {
+            pthread_cond_wait(&jobs.done_cond, &jobs.lock);
+        }
+        int done = jobs.tasks[i].done;
+        pthread_mutex_unlock(&jobs.lock);
+        if (!done) {
+            break;
+        }
+
+        print_output_capture(jobs.tasks[i].capture);
+        jobs.tasks[i].capture = NULL;
+        if (jobs.tasks[i].rc < 0) {
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&jobs.lock);
+    jobs.failed = 1;
+    pthread_mutex_unlock(&jobs.lock);
+    for (unsigned i = 0; i < n_started; ++i) {
+        pthread_join(workers[i].thread, NULL);
+        free(workers[i].buf);
+        r_free_job_cfg(workers[i].job, cfg);
+    }
+
+    // tasks after a failed task are not printed, as if processed in turn
+    for (unsigned i = 0; i < jobs.n_tasks; ++i) {
+        if (jobs.tasks[i].capture) {
+            discard_output_capture(jobs.tasks[i].capture);
+        }
+    }
+
+    pthread_mutex_destroy(&jobs.lock);
+    pthread_cond_destroy(&jobs.done_cond);
+    free(jobs.tasks);
+    free(workers);
+
+    return n_started ? 0 : -1;
+}
+#endif
+
+/**
+Create and start an SDR input for each further -d device.
+
+Each input has its own device, demodulator, decoder instances, and DSP thread,
+the outputs and the decoder definitions are shared with the first input.
+Either all devices use the same frequency or each device gets one of the frequencies in order.
+The raw outputs, dumpers, signal grabber, and analyzers stay with the first input.
+
+@return 0 on success, -1 if a device failed to start, the inputs started so far need stop_sdr_inputs()
+*/
+static int start_sdr_inputs(r_cfg_t *cfg)
+{
+    for (size_t i = 1; i < cfg->dev_queries.len; ++i) {
+        r_cfg_t *input = r_create_job_cfg(cfg);
+        list_push(&cfg->sdr_inputs, input);
+
+        input->mgr              = get_mgr(cfg);
+        input->dev_query        = cfg->dev_queries.elems[i];
+        input->sdr_index        = (int)i;
+        input->frequency[0]     = cfg->frequency[cfg->frequencies > 1 ? i : 0];
+        input->frequencies      = 1;
+        input->frequency_index  = 0;
+        input->center_frequency = input->frequency[0];
+        memset(&input->raw_handler, 0, sizeof(input->raw_handler));
+
+        input->dsp = dsp_thread_start(DSP_FRAME_NUMBER, dsp_frame,
+                DSP_PACKAGE_NUMBER, sizeof(dm_package_t), dsp_package,
+                DSP_EVENT_NUMBER, dsp_wake, input);
+#ifdef THREADS
+        if (!input->dsp) {
+            print_logf(LOG_ERROR, "Input", "Starting the DSP thread for SDR input %zu failed", i);
+            return -1;
+        }
+#endif
+
+        if (cfg->dev_mode != DEVICE_MODE_MANUAL && start_sdr(input) < 0) {
+            print_logf(LOG_ERROR, "Input", "Starting SDR input %zu failed", i);
+            return -1;
+        }
+
+        struct mg_add_sock_opts opts = {.user_data = input};
+        struct mg_connection *nc = mg_add_sock_opt(input->mgr, INVALID_SOCKET, timer_handler, opts);
+        mg_set_timer(nc, mg_time() + 2.5);
+    }
+    // the first input keeps the first frequency
+    cfg->frequencies     = 1;
+    cfg->frequency_index = 0;
+
+    return 0;
+}
+
+/// Check if an SDR input requests exiting, its exit code is used.
+static int sdr_inputs_exit(r_cfg_t *cfg)
+{
+    for (void **iter = cfg->sdr_inputs.elems; iter && *iter; ++iter) {
+        r_cfg_t *input = *iter;
+        if (input->exit_async) {
+            cfg->exit_code = input->exit_code;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/// Stop the SDR inputs, print the remaining events and the final stats, then free the inputs.
+static void stop_sdr_inputs(r_cfg_t *cfg)
+{
+    for (void **iter = cfg->sdr_inputs.elems; iter && *iter; ++iter) {
+        r_cfg_t *input = *iter;
+        sdr_stop(input->dev);
+    }
+    for (void **iter = cfg->sdr_inputs.elems; iter && *iter; ++iter) {
+        r_cfg_t *input = *iter;
+        dsp_thread_stop(input->dsp);
+        pop_dsp_events(input);
+
+        if (input->report_stats > 0) {
+            event_occurred_handler(input, create_report_data(input, input->report_stats));
+            flush_report_data(input);
+        }
+
+        dsp_thread_foreach_package(input->dsp, free_sdr_package);
+        dsp_thread_free(input->dsp);
+        input->dsp = NULL;
+        if (input->dev) {
+            sdr_deactivate(input->dev);
+            sdr_close(input->dev);
+            input->dev = NULL;
+        }
+        r_free_job_cfg(input, cfg);
+    }
+    list_free_elems(&cfg->sdr_inputs, NULL);
+}
+
 int main(int argc, char **argv) {
     int r = 0;
     struct dm_state *demod;
@@ -1462,8 +2223,35 @@ int main(int argc, char **argv) {
         add_infile(cfg, argv[optind++]);
     }
 
+    // several live devices are served by an SDR input each, without hopping
+    if (cfg->dev_queries.len > 1 && !cfg->in_files.len && !cfg->test_data) {
+        if (cfg->frequencies > 1 && (size_t)cfg->frequencies != cfg->dev_queries.len) {
+            print_logf(LOG_ERROR, "Input", "Give a single frequency or one for each of the %zu devices, hopping is not available with several devices.",
+                    cfg->dev_queries.len);
+            exit(1);
+        }
+        cfg->sdr_index = 0;
+    }
+
     pulse_detect_set_levels(demod->pulse_detect, demod->use_mag_est, demod->level_limit, demod->min_level, demod->min_snr, demod->detect_verbosity);
 
+    if (demod->channelizer) {
+        // channels are CS16 and always use the magnitude estimator
+        for (unsigned k = 0; k < demod->channelizer->n_channels; ++k) {
+            pulse_detect_set_levels(demod->channels[k].pulse_detect, 1, demod->level_limit, demod->min_level, demod->min_snr, demod->detect_verbosity);
+            demod->channels[k].demod_FM_state.fast_atan = demod->demod_FM_state.fast_atan;
+        }
+        if (demod->decimator || demod->samp_grab || demod->am_analyze || demod->dumper.len) {
+            print_log(LOG_WARNING, "Input", "Decimation, signal grabbing, the AM analyzer, and dumpers are not available with channels.");
+        }
+        // file inputs are checked per file, their rates might differ
+        if (!cfg->in_files.len && cfg->samp_rate % demod->channelizer->n_channels) {
+            print_logf(LOG_ERROR, "Input", "Sample rate %u Hz can't be split into %u channels, use a multiple of %u.",
+                    cfg->samp_rate, demod->channelizer->n_channels, demod->channelizer->n_channels);
+            exit(1);
+        }
+    }
+
     if (demod->am_analyze) {
         demod->am_analyze->level_limit = DB_TO_AMP(demod->level_limit);
         demod->am_analyze->frequency   = &cfg->center_frequency;
@@ -1571,6 +2359,17 @@ int main(int argc, char **argv) {
                 "Maximal length: %d", MAXIMAL_BUF_LENGTH);
         cfg->out_block_size = DEFAULT_BUF_LENGTH;
     }
+    // whole samples of any format, up to CS16 IQ read as half the block of CF32 IQ
+    if (cfg->out_block_size % 8) {
+        cfg->out_block_size -= cfg->out_block_size % 8;
+        print_logf(LOG_WARNING, "Block Size", "Output block size rounded down to %u", cfg->out_block_size);
+    }
+
+    if (cfg->wisdom_file) {
+        autotune_kernels(cfg->wisdom_file, cfg->out_block_size);
+    }
+    // the kernels are fixed from here on
+    baseband_init();
 
     // Special case for streaming test data
     if (cfg->test_data && (!strcasecmp(cfg->test_data, "-") || *cfg->test_data == '@')) {
@@ -1629,6 +2428,7 @@ int main(int argc, char **argv) {
                     else {
                         r += run_fsk_demods(&single_dev, &pulse_data);
                     }
+                    pulse_data_free(&pulse_data);
                     list_free_elems(&single_dev, NULL);
                 } else
                 r += pulse_slicer_string(e, r_dev);
@@ -1643,6 +2443,7 @@ int main(int argc, char **argv) {
                 }
                 else
                     r += run_fsk_demods(&demod->r_devs, &pulse_data);
+                pulse_data_free(&pulse_data);
             } else
             for (void **iter = demod->r_devs.elems; iter && *iter; ++iter) {
                 r_device *r_dev = *iter;
@@ -1672,6 +2473,7 @@ int main(int argc, char **argv) {
             else {
                 r += run_fsk_demods(&demod->r_devs, &pulse_data);
             }
+            pulse_data_free(&pulse_data);
         } else
         for (void **iter = demod->r_devs.elems; iter && *iter; ++iter) {
             r_device *r_dev = *iter;
@@ -1686,181 +2488,56 @@ int main(int argc, char **argv) {
 
     // Special case for in files
     if (cfg->in_files.len) {
-        unsigned char *test_mode_buf = malloc(DEFAULT_BUF_LENGTH * sizeof(unsigned char));
+        unsigned char *test_mode_buf = malloc(FILE_BUF_SIZE(cfg->out_block_size));
         if (!test_mode_buf) {
             FATAL_MALLOC("test_mode_buf");
         }
-        float *test_mode_float_buf = malloc(DEFAULT_BUF_LENGTH / sizeof(int16_t) * sizeof(float));
-        if (!test_mode_float_buf) {
-            FATAL_MALLOC("test_mode_float_buf");
-        }
 
         if (cfg->duration > 0) {
             time(&cfg->stop_time);
             cfg->stop_time += cfg->duration;
         }
 
-        for (void **iter = cfg->in_files.elems; iter && *iter; ++iter) {
-            cfg->in_filename = *iter;
-
-            file_info_clear(&demod->load_info); // reset all info
-            file_info_parse_filename(&demod->load_info, cfg->in_filename);
-            // apply file info or default
-            cfg->samp_rate        = demod->load_info.sample_rate ? demod->load_info.sample_rate : sample_rate_0;
-            cfg->center_frequency = demod->load_info.center_frequency ? demod->load_info.center_frequency : cfg->frequency[0];
-
-            FILE *in_file;
-            if (demod->load_info.container == FILEFMT_SIGMF) { // unpack tar
-                sigmf_t sigmf = {0};
-                int rc = sigmf_reader_open(&sigmf, cfg->in_filename);
-                // handle errors
-                print_logf(LOG_INFO, "Input", "Opening returned \"%d\"", rc);
-                // copy meta
-                demod->load_info.format = CU8_IQ;
-                cfg->samp_rate          = sigmf.sample_rate;
-                cfg->center_frequency   = sigmf.first_frequency;
-                in_file                 = sigmf.mtar.stream;
-            }
-            else if (strcmp(demod->load_info.path, "-") == 0) { // read samples from stdin
-                in_file = stdin;
-                cfg->in_filename = "<stdin>";
-            } else {
-                in_file = fopen(demod->load_info.path, "rb");
-                if (!in_file) {
-                    print_logf(LOG_ERROR, "Input", "Opening file \"%s\" failed!", cfg->in_filename);
-                    break;
-                }
-            }
-            print_logf(LOG_CRITICAL, "Input", "Test mode active. Reading samples from file: %s", cfg->in_filename); // Essential information (not quiet)
-            if (demod->load_info.format == CU8_IQ
-                    || demod->load_info.format == CS8_IQ
-                    || demod->load_info.format == S16_AM
-                    || demod->load_info.format == S16_FM) {
-                demod->sample_size = sizeof(uint8_t) * 2; // CU8, AM, FM
-            } else if (demod->load_info.format == CS16_IQ
-                    || demod->load_info.format == CF32_IQ) {
-                demod->sample_size = sizeof(int16_t) * 2; // CS16, CF32 (after conversion)
-            } else if (demod->load_info.format == PULSE_OOK) {
-                // ignore
-            } else {
-                print_logf(LOG_ERROR, "Input", "Input format invalid \"%s\"", file_info_string(&demod->load_info));
-                break;
+        // jobs need independent files and outputs that can be held back
+        int use_jobs = cfg->jobs > 1 && (cfg->in_files.len > 1 || cfg->jobs_split);
+        for (void **iter = cfg->in_files.elems; use_jobs && iter && *iter; ++iter) {
+            file_info_t info = {0};
+            file_info_parse_filename(&info, *iter);
+            if (info.path && !strcmp(info.path, "-")) {
+                print_log(LOG_WARNING, "Input", "Jobs are not available with stdin input, reading the files in turn.");
+                use_jobs = 0;
             }
-            if (cfg->verbosity >= LOG_NOTICE) {
-                print_logf(LOG_NOTICE, "Input", "Input format \"%s\"", file_info_string(&demod->load_info));
-            }
-            demod->sample_file_pos = 0.0;
-
-            // special case for pulse data file-inputs
-            if (demod->load_info.format == PULSE_OOK) {
-                while (!cfg->exit_async) {
-                    pulse_data_load(in_file, &demod->now, &demod->pulse_data, cfg->samp_rate);
-                    if (!demod->pulse_data.num_pulses) {
-                        break;
-                    }
-
-                    for (void **iter2 = demod->dumper.elems; iter2 && *iter2; ++iter2) {
-                        file_info_t const *dumper = *iter2;
-                        if (dumper->format == VCD_LOGIC) {
-                            pulse_data_print_vcd(dumper->file, &demod->pulse_data, '\'');
-                        } else if (dumper->format == PULSE_OOK) {
-                            pulse_data_dump(dumper->file, &demod->pulse_data);
-                        } else {
-                            print_logf(LOG_ERROR, "Input", "Dumper (%s) not supported on OOK input", dumper->spec);
-                            exit(1);
-                        }
-                    }
-
-                    if (demod->pulse_data.fsk_f2_est) {
-                        run_fsk_demods(&demod->r_devs, &demod->pulse_data);
-                    }
-                    else {
-                        int p_events = run_ook_demods(&demod->r_devs, &demod->pulse_data);
-                        if (cfg->verbosity >= LOG_DEBUG) {
-                            pulse_data_print(&demod->pulse_data);
-                        }
-                        if (demod->analyze_pulses && (cfg->grab_mode <= 1 || (cfg->grab_mode == 2 && p_events == 0) || (cfg->grab_mode == 3 && p_events > 0))) {
-                            r_device device = {.log_fn = log_device_handler, .output_ctx = cfg};
-                            pulse_analyzer(&demod->pulse_data, PULSE_DATA_OOK, &device);
-                        }
-                    }
-                }
-
-                if (in_file != stdin) {
-                    fclose(in_file);
-                }
-
-                continue;
-            }
-
-            // default case for file-inputs
-            int n_blocks = 0;
-            unsigned long n_read;
-            delay_timer_t delay_timer;
-            delay_timer_init(&delay_timer);
-            do {
-                // Replay in realtime if requested
-                if (cfg->in_replay) {
-                    // per block delay
-                    unsigned delay_us = (unsigned)(1000000llu * DEFAULT_BUF_LENGTH / cfg->samp_rate / demod->sample_size / cfg->in_replay);
-                    if (demod->load_info.format == CF32_IQ) {
-                        delay_us /= 2; // adjust for float only reading half as many samples
-                    }
-                    delay_timer_wait(&delay_timer, delay_us);
-                }
-                // Convert CF32 file to CS16 buffer
-                if (demod->load_info.format == CF32_IQ) {
-                    n_read = fread(test_mode_float_buf, sizeof(float), DEFAULT_BUF_LENGTH / 2, in_file);
-                    // clamp float to [-1,1] and scale to Q0.15
-                    for (unsigned long n = 0; n < n_read; n++) {
-                        int s_tmp = test_mode_float_buf[n] * INT16_MAX;
-                        if (s_tmp < -INT16_MAX) {
-                            s_tmp = -INT16_MAX;
-                        }
-                        else if (s_tmp > INT16_MAX) {
-                            s_tmp = INT16_MAX;
-                        }
-                        ((int16_t *)test_mode_buf)[n] = s_tmp;
-                    }
-                    n_read *= 2; // convert to byte count
-                } else {
-                    n_read = fread(test_mode_buf, 1, DEFAULT_BUF_LENGTH, in_file);
-
-                    // Convert CS8 file to CU8 buffer
-                    if (demod->load_info.format == CS8_IQ) {
-                        for (unsigned long n = 0; n < n_read; n++) {
-                            test_mode_buf[n] = ((int8_t)test_mode_buf[n]) + 128;
-                        }
-                    }
-                }
-                if (n_read == 0) {
-                    break;  // push_sdr_flow() must not be called with len=0
-                }
-                demod->sample_file_pos = ((float)n_blocks * DEFAULT_BUF_LENGTH + n_read) / cfg->samp_rate / demod->sample_size;
-                n_blocks++; // this assumes n_read == DEFAULT_BUF_LENGTH
-                process_sdr_frame(cfg, test_mode_buf, n_read);
-            } while (n_read != 0 && !cfg->exit_async);
-
-            // Flush to ensure EOP detection
-            flush_sdr_flow(cfg);
-
-            //Always classify a signal at the end of the file
-            if (demod->am_analyze) {
-                am_analyze_classify(demod->am_analyze);
-            }
-            if (cfg->verbosity >= LOG_NOTICE) {
-                print_logf(LOG_NOTICE, "Input", "Test mode file issued %d packets", n_blocks);
-            }
-            reset_sdr_flow(cfg);
+        }
+        if (use_jobs && (demod->dumper.len || demod->samp_grab || demod->am_analyze || demod->analyze_pulses
+                || cfg->raw_handler.len || cfg->in_replay || cfg->duration > 0 || cfg->bytes_to_read > 0
+                || cfg->after_successful_events_flag || cfg->stats_interval || cfg->verbosity >= LOG_DEBUG)) {
+            print_log(LOG_WARNING, "Input", "Jobs are not available with dumpers, signal grabbing, the analyzers, raw outputs, replay, limits, or debug output, reading the files in turn.");
+            use_jobs = 0;
+        }
+        if (use_jobs && cfg->jobs_split && (demod->auto_level || cfg->report_noise)) {
+            print_log(LOG_WARNING, "Input", "Splitting files is not available with autolevel or noise reports, reading whole files.");
+            cfg->jobs_split = 0;
+        }
+#ifdef THREADS
+        if (use_jobs && process_file_jobs(cfg, sample_rate_0) == 0) {
+            free(test_mode_buf);
+            r_free_cfg(cfg);
+            exit(0);
+        }
+#else
+        if (use_jobs) {
+            print_log(LOG_WARNING, "Input", "Jobs are not available without threads, reading the files in turn.");
+        }
+#endif
 
-            if (in_file != stdin) {
-                fclose(in_file);
+        for (void **iter = cfg->in_files.elems; iter && *iter; ++iter) {
+            if (process_file(cfg, *iter, sample_rate_0, test_mode_buf, NULL) < 0) {
+                break;
             }
         }
 
         close_dumpers(cfg);
         free(test_mode_buf);
-        free(test_mode_float_buf);
         r_free_cfg(cfg);
         exit(0);
     }
@@ -1890,6 +2567,11 @@ int main(int argc, char **argv) {
     // TODO: remove this before next release
     print_log(LOG_NOTICE, "Input", "The internals of input handling changed, read about and report problems on PR #1978");
 
+    // demodulate and decode on separate threads to unblock the event loop, if threads are available
+    cfg->dsp = dsp_thread_start(DSP_FRAME_NUMBER, dsp_frame,
+            DSP_PACKAGE_NUMBER, sizeof(dm_package_t), dsp_package,
+            DSP_EVENT_NUMBER, dsp_wake, cfg);
+
     if (cfg->dev_mode != DEVICE_MODE_MANUAL) {
         r = start_sdr(cfg);
         if (r < 0) {
@@ -1910,7 +2592,13 @@ int main(int argc, char **argv) {
     // Send us MG_EV_TIMER event after 2.5 seconds
     mg_set_timer(nc, mg_time() + 2.5);
 
-    while (!cfg->exit_async) {
+    if (start_sdr_inputs(cfg) < 0) {
+        // shut down the first device and the inputs already running
+        cfg->exit_code  = 2;
+        cfg->exit_async = 1;
+    }
+
+    while (!cfg->exit_async && !sdr_inputs_exit(cfg)) {
         mg_mgr_poll(cfg->mgr, 500);
     }
     if (cfg->verbosity >= LOG_INFO) {
@@ -1923,11 +2611,21 @@ int main(int argc, char **argv) {
     sdr_stop(cfg->dev);
     //print_log(LOG_INFO, "rtl_433", "stopped.");
 
+    // finish the frame in progress and print the remaining events
+    dsp_thread_stop(cfg->dsp);
+    pop_dsp_events(cfg);
+
     if (cfg->report_stats > 0) {
         event_occurred_handler(cfg, create_report_data(cfg, cfg->report_stats));
         flush_report_data(cfg);
     }
 
+    dsp_thread_foreach_package(cfg->dsp, free_sdr_package);
+    dsp_thread_free(cfg->dsp);
+    cfg->dsp = NULL;
+
+    stop_sdr_inputs(cfg);
+
     if (!cfg->exit_async) {
         print_logf(LOG_ERROR, "rtl_433", "Library error %d, exiting...", r);
         cfg->exit_code = r;
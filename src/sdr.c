@@ -18,11 +18,13 @@
 #include <string.h>
 #include <signal.h>
 #include "sdr.h"
+#include "iq_pool.h"
 #include "r_util.h"
 #include "optparse.h"
 #include "logger.h"
 #include "fatal.h"
 #include "compat_pthread.h"
+#include "compat_atomic.h"
 #ifdef RTLSDR
 #include <rtl-sdr.h>
 #if defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
@@ -97,9 +99,11 @@ struct sdr_dev {
     char *dev_info;
 
     int running;
-    uint8_t *buffer; ///< sdr data buffer current and past frames
-    size_t buffer_size; ///< sdr data buffer overall size (num * len)
-    size_t buffer_pos; ///< sdr data buffer next write position
+    iq_pool_t *pool; ///< sdr data frames leased to the consumers
+    uint8_t *drop_buf; ///< read buffer for data dropped while all frames are in use
+    unsigned frames_produced; ///< written by the acquire thread
+    unsigned frames_dropped; ///< written by the acquire thread
+    unsigned overflows; ///< written by the acquire thread
 
     int sample_size;
     int sample_signed;
@@ -120,6 +124,35 @@ struct sdr_dev {
 #endif
 };
 
+/// Create the frame pool, keep it if the buffer sizes did not change.
+static int prepare_pool(sdr_dev_t *dev, uint32_t buf_num, uint32_t buf_len, int with_drop_buf)
+{
+    if (!dev->pool || dev->pool->n_frames != buf_num || dev->pool->frame_size != buf_len) {
+        iq_pool_t *pool = iq_pool_create(buf_num, buf_len);
+        if (!pool) {
+            return -1;
+        }
+#ifdef THREADS
+        pthread_mutex_lock(&dev->lock); // sdr_get_stats() might read the pool
+#endif
+        iq_pool_free(dev->pool); // frames still in use keep the old pool until released
+        dev->pool = pool;
+#ifdef THREADS
+        pthread_mutex_unlock(&dev->lock);
+#endif
+        free(dev->drop_buf);
+        dev->drop_buf = NULL;
+    }
+    if (with_drop_buf && !dev->drop_buf) {
+        dev->drop_buf = malloc(buf_len);
+        if (!dev->drop_buf) {
+            WARN_MALLOC("prepare_pool()");
+            return -1; // NOTE: returns error on alloc failure.
+        }
+    }
+    return 0;
+}
+
 /* rtl_tcp helpers */
 
 #pragma pack(push, 1)
@@ -251,24 +284,15 @@ static int rtltcp_close(SOCKET sock)
 
 static int rtltcp_read_loop(sdr_dev_t *dev, sdr_event_cb_t cb, void *ctx, uint32_t buf_num, uint32_t buf_len)
 {
-    size_t buffer_size = (size_t)buf_num * buf_len;
-    if (dev->buffer_size != buffer_size) {
-        free(dev->buffer);
-        dev->buffer = malloc(buffer_size);
-        if (!dev->buffer) {
-            WARN_MALLOC("rtltcp_read_loop()");
-            return -1; // NOTE: returns error on alloc failure.
-        }
-        dev->buffer_size = buffer_size;
-        dev->buffer_pos = 0;
+    if (prepare_pool(dev, buf_num, buf_len, 1) < 0) {
+        return -1;
     }
 
     dev->running = 1;
     do {
-        if (dev->buffer_pos + buf_len > buffer_size)
-            dev->buffer_pos = 0;
-        uint8_t *buffer = &dev->buffer[dev->buffer_pos];
-        dev->buffer_pos += buf_len;
+        // receive directly into a leased frame, drop the data if all frames are in use
+        iq_frame_t *frame = iq_pool_lease(dev->pool);
+        uint8_t *buffer   = frame ? frame->buf : dev->drop_buf;
 
         unsigned n_read = 0;
         int r;
@@ -304,17 +328,25 @@ static int rtltcp_read_loop(sdr_dev_t *dev, sdr_event_cb_t cb, void *ctx, uint32
                 .center_frequency = center_frequency,
                 .buf              = buffer,
                 .len              = n_read,
+                .frame            = frame,
         };
 #ifdef THREADS
         pthread_mutex_lock(&dev->lock);
         int exit_acquire = dev->exit_acquire;
         pthread_mutex_unlock(&dev->lock);
         if (exit_acquire) {
+            iq_frame_release(frame);
             break; // do not deliver any more events
         }
 #endif
-        if (n_read > 0) // prevent a crash in callback
+        if (n_read > 0 && !frame) {
+            ATOMIC_FETCH_ADD(&dev->frames_dropped, 1);
+        }
+        if (n_read > 0 && frame) { // prevent a crash in callback
+            ATOMIC_FETCH_ADD(&dev->frames_produced, 1);
             cb(&ev, ctx);
+        }
+        iq_frame_release(frame);
 
     } while (dev->running);
 
@@ -498,13 +530,14 @@ static void rtlsdr_read_cb(unsigned char *iq_buf, uint32_t len, void *ctx)
     }
 #endif
 
-    if (dev->buffer_pos + len > dev->buffer_size)
-        dev->buffer_pos = 0;
-    uint8_t *buffer = &dev->buffer[dev->buffer_pos];
-    dev->buffer_pos += len;
-
-    // NOTE: we need to copy the buffer, it might go away on cancel_async
-    memcpy(buffer, iq_buf, len);
+    // NOTE: we need to copy the buffer, librtlsdr resubmits the transfer when we return
+    // and it might go away on cancel_async, drop the data if all frames are in use
+    iq_frame_t *frame = len <= dev->pool->frame_size ? iq_pool_lease(dev->pool) : NULL;
+    if (!frame) {
+        ATOMIC_FETCH_ADD(&dev->frames_dropped, 1);
+        return;
+    }
+    memcpy(frame->buf, iq_buf, len);
 
 #ifdef THREADS
     pthread_mutex_lock(&dev->lock);
@@ -518,28 +551,23 @@ static void rtlsdr_read_cb(unsigned char *iq_buf, uint32_t len, void *ctx)
             .ev               = SDR_EV_DATA,
             .sample_rate      = sample_rate,
             .center_frequency = center_frequency,
-            .buf              = buffer,
+            .buf              = frame->buf,
             .len              = len,
+            .frame            = frame,
     };
     //fprintf(stderr, "rtlsdr_read_cb cb...\n");
-    if (len > 0) // prevent a crash in callback
+    if (len > 0) { // prevent a crash in callback
+        ATOMIC_FETCH_ADD(&dev->frames_produced, 1);
         dev->rtlsdr_cb(&ev, dev->rtlsdr_cb_ctx);
+    }
     //fprintf(stderr, "rtlsdr_read_cb cb done.\n");
-    // NOTE: we actually need to copy the buffer to prevent it going away on cancel_async
+    iq_frame_release(frame); // consumers retained the frame if they still need it
 }
 
 static int rtlsdr_read_loop(sdr_dev_t *dev, sdr_event_cb_t cb, void *ctx, uint32_t buf_num, uint32_t buf_len)
 {
-    size_t buffer_size = (size_t)buf_num * buf_len;
-    if (dev->buffer_size != buffer_size) {
-        free(dev->buffer);
-        dev->buffer = malloc(buffer_size);
-        if (!dev->buffer) {
-            WARN_MALLOC("rtlsdr_read_loop()");
-            return -1; // NOTE: returns error on alloc failure.
-        }
-        dev->buffer_size = buffer_size;
-        dev->buffer_pos = 0;
+    if (prepare_pool(dev, buf_num, buf_len, 0) < 0) {
+        return -1;
     }
 
     int r = 0;
@@ -964,26 +992,17 @@ static int sdr_open_soapy(sdr_dev_t **out_dev, char const *dev_query, int verbos
 
 static int soapysdr_read_loop(sdr_dev_t *dev, sdr_event_cb_t cb, void *ctx, uint32_t buf_num, uint32_t buf_len)
 {
-    size_t buffer_size = (size_t)buf_num * buf_len;
-    if (dev->buffer_size != buffer_size) {
-        free(dev->buffer);
-        dev->buffer = malloc(buffer_size);
-        if (!dev->buffer) {
-            WARN_MALLOC("soapysdr_read_loop()");
-            return -1; // NOTE: returns error on alloc failure.
-        }
-        dev->buffer_size = buffer_size;
-        dev->buffer_pos = 0;
+    if (prepare_pool(dev, buf_num, buf_len, 1) < 0) {
+        return -1;
     }
 
     size_t buf_elems = buf_len / dev->sample_size;
 
     dev->running = 1;
     do {
-        if (dev->buffer_pos + buf_len > buffer_size)
-            dev->buffer_pos = 0;
-        int16_t *buffer = (void *)&dev->buffer[dev->buffer_pos];
-        dev->buffer_pos += buf_len;
+        // read directly into a leased frame, drop the data if all frames are in use
+        iq_frame_t *frame = iq_pool_lease(dev->pool);
+        int16_t *buffer   = (void *)(frame ? frame->buf : dev->drop_buf);
 
         void *buffs[]    = {buffer};
         int flags        = 0;
@@ -1003,8 +1022,10 @@ static int soapysdr_read_loop(sdr_dev_t *dev, sdr_event_cb_t cb, void *ctx, uint
         //fprintf(stderr, "readStream ret=%u (%u), flags=%d, timeNs=%lld\n", n_read, buf_len, flags, timeNs);
         if (r < 0) {
             if (r == SOAPY_SDR_OVERFLOW) {
+                ATOMIC_FETCH_ADD(&dev->overflows, 1);
                 fprintf(stderr, "O");
                 fflush(stderr);
+                iq_frame_release(frame);
                 continue;
             }
             print_logf(LOG_WARNING, __func__, "sync read failed. %d", r);
@@ -1041,17 +1062,25 @@ static int soapysdr_read_loop(sdr_dev_t *dev, sdr_event_cb_t cb, void *ctx, uint
                 .center_frequency = center_frequency,
                 .buf              = buffer,
                 .len              = n_read * dev->sample_size,
+                .frame            = frame,
         };
 #ifdef THREADS
         pthread_mutex_lock(&dev->lock);
         int exit_acquire = dev->exit_acquire;
         pthread_mutex_unlock(&dev->lock);
         if (exit_acquire) {
+            iq_frame_release(frame);
             break; // do not deliver any more events
         }
 #endif
-        if (n_read > 0) // prevent a crash in callback
+        if (n_read > 0 && !frame) {
+            ATOMIC_FETCH_ADD(&dev->frames_dropped, 1);
+        }
+        if (n_read > 0 && frame) { // prevent a crash in callback
+            ATOMIC_FETCH_ADD(&dev->frames_produced, 1);
             cb(&ev, ctx);
+        }
+        iq_frame_release(frame);
 
     } while (dev->running);
 
@@ -1123,7 +1152,8 @@ int sdr_close(sdr_dev_t *dev)
 #endif
 
     free(dev->dev_info);
-    free(dev->buffer);
+    iq_pool_free(dev->pool); // frames still in use keep the pool until released
+    free(dev->drop_buf);
     free(dev);
     return ret;
 }
@@ -1152,6 +1182,33 @@ int sdr_get_sample_signed(sdr_dev_t *dev)
     return dev->sample_signed;
 }
 
+void sdr_get_stats(sdr_dev_t *dev, sdr_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (!dev)
+        return;
+
+    stats->frames_produced = ATOMIC_LOAD_ACQUIRE(&dev->frames_produced);
+    stats->frames_dropped  = ATOMIC_LOAD_ACQUIRE(&dev->frames_dropped);
+    stats->overflows       = ATOMIC_LOAD_ACQUIRE(&dev->overflows);
+
+#ifdef THREADS
+    pthread_mutex_lock(&dev->lock);
+#endif
+    // one leased frame is being filled by the acquire thread
+    unsigned high_water = dev->pool ? ATOMIC_LOAD_ACQUIRE(&dev->pool->high_water) : 0;
+    if (high_water > 1) {
+        stats->lag_max = high_water - 1;
+        if (dev->sample_size && dev->sample_rate) {
+            uint64_t lag_samples = (uint64_t)stats->lag_max * dev->pool->frame_size / dev->sample_size;
+            stats->lag_max_ms    = (unsigned)(lag_samples * 1000 / dev->sample_rate);
+        }
+    }
+#ifdef THREADS
+    pthread_mutex_unlock(&dev->lock);
+#endif
+}
+
 int sdr_set_center_freq(sdr_dev_t *dev, uint32_t freq, int verbose)
 {
     if (!dev)
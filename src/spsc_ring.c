@@ -0,0 +1,148 @@
+/** @file
+    Lock-free single-producer single-consumer ring of pointers.
+
+    The producer owns head and the consumer owns tail, both count up and wrap,
+    the slot index is the count modulo the power of two size.
+    A push publishes the slot with a release store of head, a pop acquires it.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "spsc_ring.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "compat_atomic.h"
+#include "fatal.h"
+
+spsc_ring_t *spsc_ring_create(unsigned size)
+{
+    unsigned n = 2;
+    while (n < size) {
+        n <<= 1;
+    }
+
+    spsc_ring_t *ring = calloc(1, sizeof(*ring));
+    if (!ring) {
+        WARN_CALLOC("spsc_ring_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    ring->elems = calloc(n, sizeof(*ring->elems));
+    if (!ring->elems) {
+        WARN_CALLOC("spsc_ring_create()");
+        free(ring);
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    ring->size = n;
+
+    return ring;
+}
+
+void spsc_ring_free(spsc_ring_t *ring)
+{
+    if (!ring) {
+        return;
+    }
+    free(ring->elems);
+    free(ring);
+}
+
+int spsc_ring_push(spsc_ring_t *ring, void *elem)
+{
+    unsigned head  = ring->head;
+    unsigned depth = head - ATOMIC_LOAD_ACQUIRE(&ring->tail);
+    if (depth >= ring->size) {
+        return -1;
+    }
+    ring->elems[head & (ring->size - 1)] = elem;
+    ATOMIC_STORE_RELEASE(&ring->head, head + 1);
+
+    if (depth + 1 > ring->high_water) {
+        ring->high_water = depth + 1;
+    }
+    return 0;
+}
+
+void *spsc_ring_pop(spsc_ring_t *ring)
+{
+    unsigned tail = ring->tail;
+    if (tail == ATOMIC_LOAD_ACQUIRE(&ring->head)) {
+        return NULL;
+    }
+    void *elem = ring->elems[tail & (ring->size - 1)];
+    ATOMIC_STORE_RELEASE(&ring->tail, tail + 1);
+    return elem;
+}
+
+unsigned spsc_ring_depth(spsc_ring_t *ring)
+{
+    unsigned tail = ATOMIC_LOAD_ACQUIRE(&ring->tail);
+    return ATOMIC_LOAD_ACQUIRE(&ring->head) - tail;
+}
+
+#ifdef _TEST
+#define ASSERT_EQUALS(a, b) \
+    do { \
+        if ((a) == (b)) \
+            ++passed; \
+        else { \
+            ++failed; \
+            fprintf(stderr, "FAIL: %d <> %d\n", (int)(a), (int)(b)); \
+        } \
+    } while (0)
+
+int main(void)
+{
+    unsigned passed = 0;
+    unsigned failed = 0;
+    int vals[8];
+
+    fprintf(stderr, "spsc_ring::spsc_ring_create(): size is a power of two\n");
+    spsc_ring_t *ring = spsc_ring_create(3);
+    ASSERT_EQUALS(ring->size, 4);
+
+    fprintf(stderr, "spsc_ring::spsc_ring_push(): fill and overflow\n");
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQUALS(spsc_ring_push(ring, &vals[i]), 0);
+    }
+    ASSERT_EQUALS(spsc_ring_push(ring, &vals[4]), -1);
+    ASSERT_EQUALS(spsc_ring_depth(ring), 4);
+    ASSERT_EQUALS(ring->high_water, 4);
+
+    fprintf(stderr, "spsc_ring::spsc_ring_pop(): fifo order and empty\n");
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQUALS(spsc_ring_pop(ring) == &vals[i], 1);
+    }
+    ASSERT_EQUALS(spsc_ring_pop(ring) == NULL, 1);
+    ASSERT_EQUALS(spsc_ring_depth(ring), 0);
+
+    fprintf(stderr, "spsc_ring::spsc_ring_push(): wrap around\n");
+    for (int round = 0; round < 5; ++round) {
+        ASSERT_EQUALS(spsc_ring_push(ring, &vals[round]), 0);
+        ASSERT_EQUALS(spsc_ring_push(ring, &vals[round + 1]), 0);
+        ASSERT_EQUALS(spsc_ring_pop(ring) == &vals[round], 1);
+        ASSERT_EQUALS(spsc_ring_pop(ring) == &vals[round + 1], 1);
+    }
+    ASSERT_EQUALS(ring->high_water, 4);
+
+    fprintf(stderr, "spsc_ring::spsc_ring_push(): counter overflow\n");
+    ring->head = ring->tail = 0xfffffffe;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQUALS(spsc_ring_push(ring, &vals[i]), 0);
+    }
+    ASSERT_EQUALS(spsc_ring_push(ring, &vals[4]), -1);
+    ASSERT_EQUALS(spsc_ring_depth(ring), 4);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQUALS(spsc_ring_pop(ring) == &vals[i], 1);
+    }
+
+    spsc_ring_free(ring);
+
+    fprintf(stderr, "spsc_ring:: test (%u passed, %u failed)\n", passed, failed);
+    return failed;
+}
+#endif /* _TEST */
@@ -0,0 +1,266 @@
+/** @file
+    Baseband kernel benchmark.
+
+    Times all baseband functions on synthetic input across block sizes
+    and prints the results as JSON.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "compat_time.h"
+#include "fatal.h"
+#include "baseband.h"
+
+#define MAX_BLOCKS 8
+#define SAMP_RATE 1000000
+
+static unsigned const default_blocks[] = {1024, 16384, 131072, 1048576};
+
+static uint8_t *cu8;
+static int16_t *cs16;
+static float *cf32;
+static uint8_t *cs8;
+static uint16_t *u16;
+static int16_t *am;
+static int16_t *fm;
+
+/// Deterministic noise with an OOK modulated tone, the kernels are mostly data independent.
+static void fill_input(unsigned len)
+{
+    uint32_t lcg = 433920;
+    for (unsigned n = 0; n < len; ++n) {
+        lcg    = lcg * 1664525 + 1013904223;
+        int on = (n / 1000) & 1;
+        int i  = (int)(lcg >> 28) - 8 + (on ? ((n & 4) ? 60 : -60) : 0);
+        int q  = (int)((lcg >> 24) & 0xf) - 8 + (on ? ((n & 2) ? 60 : -60) : 0);
+        cu8[2 * n]      = (uint8_t)(128 + i);
+        cu8[2 * n + 1]  = (uint8_t)(128 + q);
+        cs16[2 * n]     = (int16_t)(i * 256);
+        cs16[2 * n + 1] = (int16_t)(q * 256);
+        cf32[2 * n]     = i / 128.0f;
+        cf32[2 * n + 1] = q / 128.0f;
+    }
+}
+
+enum kernel_id {
+    K_ENVELOPE,
+    K_MAG_EST_CU8,
+    K_MAG_TRUE_CU8,
+    K_MAG_EST_CS16,
+    K_MAG_TRUE_CS16,
+    K_LOW_PASS,
+    K_FM_CU8,
+    K_FM_CU8_FAST,
+    K_FM_CS16,
+    K_AM_FM_CU8,
+    K_AM_FM_CS16,
+    K_PROBE_LEVEL,
+    K_CONVERT_CS8,
+    K_CONVERT_CF32,
+    K_END,
+};
+
+static char const *const kernel_names[K_END] = {
+        "envelope_detect",
+        "magnitude_est_cu8",
+        "magnitude_true_cu8",
+        "magnitude_est_cs16",
+        "magnitude_true_cs16",
+        "baseband_low_pass_filter",
+        "baseband_demod_FM",
+        "baseband_demod_FM_fast",
+        "baseband_demod_FM_cs16",
+        "baseband_demod_AM_FM",
+        "baseband_demod_AM_FM_cs16",
+        "baseband_probe_level",
+        "baseband_convert_cs8_cu8",
+        "baseband_convert_cf32_cs16",
+};
+
+/// Run one kernel over a block once.
+static void run_kernel(int k, unsigned len, filter_state_t *lp, demodfm_state_t *fm_state)
+{
+    float tail_db;
+    switch (k) {
+    case K_ENVELOPE: envelope_detect(cu8, u16, len); break;
+    case K_MAG_EST_CU8: magnitude_est_cu8(cu8, u16, len); break;
+    case K_MAG_TRUE_CU8: magnitude_true_cu8(cu8, u16, len); break;
+    case K_MAG_EST_CS16: magnitude_est_cs16(cs16, u16, len); break;
+    case K_MAG_TRUE_CS16: magnitude_true_cs16(cs16, u16, len); break;
+    case K_LOW_PASS: baseband_low_pass_filter(lp, u16, am, len); break;
+    case K_FM_CU8: // fallthrough
+    case K_FM_CU8_FAST: baseband_demod_FM(fm_state, cu8, fm, len, SAMP_RATE, 0.1f); break;
+    case K_FM_CS16: baseband_demod_FM_cs16(fm_state, cs16, fm, len, SAMP_RATE, 0.1f); break;
+    case K_AM_FM_CU8: baseband_demod_AM_FM(lp, fm_state, 0, cu8, am, fm, len, SAMP_RATE, 0.1f); break;
+    case K_AM_FM_CS16: baseband_demod_AM_FM_cs16(lp, fm_state, cs16, am, fm, len, SAMP_RATE, 0.1f); break;
+    case K_PROBE_LEVEL: baseband_probe_level(cu8, 2, 0, len, 8, &tail_db); break;
+    case K_CONVERT_CS8: baseband_convert_cs8_cu8(cs8, 2 * len); break;
+    default: baseband_convert_cf32_cs16(cf32, (int16_t *)u16, 2 * len); break; // not in place to keep the input
+    }
+}
+
+static double elapsed_us(struct timeval const *start)
+{
+    struct timeval now, diff;
+    gettimeofday(&now, NULL);
+    timeval_subtract(&diff, &now, start);
+    return diff.tv_sec * 1e6 + diff.tv_usec;
+}
+
+/// Time one kernel on one block size, repeat for at least min_ms, print a JSON object.
+static void bench_kernel(int k, unsigned len, unsigned min_ms, int first)
+{
+    filter_state_t lp;
+    demodfm_state_t fm_state;
+    memset(&lp, 0, sizeof(lp));
+    memset(&fm_state, 0, sizeof(fm_state));
+    fm_state.fast_atan = k == K_FM_CU8_FAST;
+
+    run_kernel(k, len, &lp, &fm_state); // warm up caches and filter setup
+
+    unsigned long iterations = 0;
+    double us                = 0.0;
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    do {
+        run_kernel(k, len, &lp, &fm_state);
+        iterations++;
+        us = elapsed_us(&start);
+    } while (us < min_ms * 1000.0);
+
+    double ns_per_sample = us * 1000.0 / ((double)iterations * len);
+    printf("%s    {\"kernel\" : \"%s\", \"impl\" : \"%s\", \"block\" : %u, \"iterations\" : %lu, \"ns_per_sample\" : %.3f, \"msps\" : %.2f}",
+            first ? "" : ",\n", kernel_names[k], baseband_impl_name(baseband_get_impl()), len, iterations,
+            ns_per_sample, 1000.0 / ns_per_sample);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: baseband-bench [-t <ms>] [-b <block size>]... [-i auto | all | scalar | sse2 | avx2 | neon]\n"
+                    "  -t  minimum time per measurement in ms (default: 100)\n"
+                    "  -b  block size in samples, can be used multiple times (default: 1024 16384 131072 1048576)\n"
+                    "  -i  kernel implementation to time (default: auto)\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned min_ms = 100;
+    unsigned blocks[MAX_BLOCKS];
+    unsigned n_blocks = 0;
+    int impl_arg      = BASEBAND_IMPL_AUTO;
+    int all_impls     = 0;
+
+    baseband_init();
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            min_ms = (unsigned)atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc && n_blocks < MAX_BLOCKS) {
+            blocks[n_blocks++] = (unsigned)atoi(argv[++i]);
+            if (blocks[n_blocks - 1] < 2) {
+                usage();
+            }
+        }
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) {
+            char const *name = argv[++i];
+            all_impls        = !strcmp(name, "all");
+            if (!all_impls && strcmp(name, "auto")) {
+                impl_arg = BASEBAND_IMPL_END;
+                for (int j = BASEBAND_IMPL_SCALAR; j < BASEBAND_IMPL_END; ++j) {
+                    if (!strcmp(name, baseband_impl_name(j))) {
+                        impl_arg = j;
+                    }
+                }
+                if (impl_arg == BASEBAND_IMPL_END) {
+                    usage();
+                }
+            }
+        }
+        else {
+            usage();
+        }
+    }
+    if (!n_blocks) {
+        n_blocks = sizeof(default_blocks) / sizeof(*default_blocks);
+        memcpy(blocks, default_blocks, sizeof(default_blocks));
+    }
+
+    unsigned max_len = 0;
+    for (unsigned b = 0; b < n_blocks; ++b) {
+        max_len = blocks[b] > max_len ? blocks[b] : max_len;
+    }
+    cu8 = malloc(2 * max_len * sizeof(*cu8));
+    if (!cu8) {
+        FATAL_MALLOC("main()");
+    }
+    cs16 = malloc(2 * max_len * sizeof(*cs16));
+    if (!cs16) {
+        FATAL_MALLOC("main()");
+    }
+    cf32 = malloc(2 * max_len * sizeof(*cf32));
+    if (!cf32) {
+        FATAL_MALLOC("main()");
+    }
+    cs8 = malloc(2 * max_len * sizeof(*cs8));
+    if (!cs8) {
+        FATAL_MALLOC("main()");
+    }
+    u16 = malloc(2 * max_len * sizeof(*u16)); // also holds the CF32 conversion output
+    if (!u16) {
+        FATAL_MALLOC("main()");
+    }
+    am = malloc(max_len * sizeof(*am));
+    if (!am) {
+        FATAL_MALLOC("main()");
+    }
+    fm = malloc(max_len * sizeof(*fm));
+    if (!fm) {
+        FATAL_MALLOC("main()");
+    }
+    fill_input(max_len);
+    memcpy(cs8, cu8, 2 * max_len);
+
+    int impls[BASEBAND_IMPL_END];
+    int n_impls = 0;
+    for (int impl = BASEBAND_IMPL_SCALAR; all_impls && impl < BASEBAND_IMPL_END; ++impl) {
+        if (baseband_impl_available(impl)) {
+            impls[n_impls++] = impl;
+        }
+    }
+    if (!all_impls) {
+        impls[n_impls++] = impl_arg;
+    }
+
+    printf("{\"samp_rate\" : %d, \"min_ms\" : %u, \"results\" : [\n", SAMP_RATE, min_ms);
+    int first = 1;
+    for (int i = 0; i < n_impls; ++i) {
+        baseband_set_thread_impl(impls[i]);
+        for (int k = 0; k < K_END; ++k) {
+            for (unsigned b = 0; b < n_blocks; ++b) {
+                bench_kernel(k, blocks[b], min_ms, first);
+                first = 0;
+            }
+        }
+    }
+    printf("\n]}\n");
+
+    free(cu8);
+    free(cs16);
+    free(cf32);
+    free(cs8);
+    free(u16);
+    free(am);
+    free(fm);
+
+    return 0;
+}
@@ -13,6 +13,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #ifdef _MSC_VER
@@ -70,9 +71,331 @@ static int write_buf(const char *filename, const void *buf, size_t nbyte)
     return ret;
 }
 
+#define CHECK_LEN 1027 // not a multiple of any vector width
+
+/// Check that all available kernel implementations match the scalar reference.
+static int check_impls(void)
+{
+    uint8_t cu8[2 * CHECK_LEN];
+    int16_t cs16[2 * CHECK_LEN];
+    uint16_t ref[CHECK_LEN];
+    uint16_t out[CHECK_LEN];
+    int failed = 0;
+
+    srand(433);
+    for (int i = 0; i < 2 * CHECK_LEN; ++i) {
+        cu8[i]  = rand() & 0xff;
+        cs16[i] = (int16_t)(rand() & 0xffff);
+    }
+    // edge values
+    int16_t const edges[] = {-32768, 32767, -32767, 0, -1, 1, -32768, -32768, 32767, 32767};
+    for (unsigned i = 0; i < sizeof(edges) / sizeof(*edges); ++i) {
+        cu8[i]  = i & 1 ? 0 : 255;
+        cs16[i] = edges[i];
+    }
+
+    for (int impl = BASEBAND_IMPL_SCALAR + 1; impl < BASEBAND_IMPL_END; ++impl) {
+        if (!baseband_impl_available(impl)) {
+            continue;
+        }
+        for (int k = 0; k < 5; ++k) {
+            float lvl[2];
+            uint16_t *y_buf[2] = {ref, out};
+            for (int j = 0; j < 2; ++j) {
+                baseband_set_thread_impl(j ? impl : BASEBAND_IMPL_SCALAR);
+                switch (k) {
+                case 0: lvl[j] = envelope_detect(cu8, y_buf[j], CHECK_LEN); break;
+                case 1: lvl[j] = magnitude_est_cu8(cu8, y_buf[j], CHECK_LEN); break;
+                case 2: lvl[j] = magnitude_true_cu8(cu8, y_buf[j], CHECK_LEN); break;
+                case 3: lvl[j] = magnitude_est_cs16(cs16, y_buf[j], CHECK_LEN); break;
+                default: lvl[j] = magnitude_true_cs16(cs16, y_buf[j], CHECK_LEN); break;
+                }
+            }
+            if (lvl[0] != lvl[1] || memcmp(ref, out, sizeof(ref))) {
+                fprintf(stderr, "Kernel %d of %s differs from scalar\n", k, baseband_impl_name(impl));
+                failed++;
+            }
+        }
+        printf("Kernels %s checked\n", baseband_impl_name(impl));
+    }
+    baseband_set_thread_impl(BASEBAND_IMPL_AUTO);
+
+    return failed;
+}
+
+/// Check the input converters of all implementations against the former conversion loops, in place.
+static int check_convert(void)
+{
+    static float cf32[2 * CHECK_LEN];
+    static int8_t cs8[2 * CHECK_LEN];
+    static int16_t ref16[2 * CHECK_LEN];
+    static uint8_t ref8[2 * CHECK_LEN];
+    static float buf[2 * CHECK_LEN];
+    int failed = 0;
+
+    for (int i = 0; i < 2 * CHECK_LEN; ++i) {
+        cf32[i] = (rand() - RAND_MAX / 2) / (RAND_MAX / 2.5f); // about -1.25 to 1.25
+        cs8[i]  = (int8_t)(rand() & 0xff);
+    }
+    float const edges[] = {-1.0f, 1.0f, 0.0f, -0.0f, 1e10f, -1e10f, 0.99999f, -0.99999f, 1.0f / INT16_MAX, -0.5f / INT16_MAX, NAN};
+    memcpy(cf32, edges, sizeof(edges));
+    for (int i = 0; i < 2 * CHECK_LEN; ++i) {
+        // the former loop, but clamping before the (otherwise undefined) int conversion
+        float f  = cf32[i] * INT16_MAX;
+        ref16[i] = f < -INT16_MAX ? -INT16_MAX : f > INT16_MAX ? INT16_MAX : isnan(f) ? -INT16_MAX : (int)f;
+        ref8[i]  = cs8[i] + 128;
+    }
+
+    for (int impl = BASEBAND_IMPL_SCALAR; impl < BASEBAND_IMPL_END; ++impl) {
+        if (!baseband_impl_available(impl)) {
+            continue;
+        }
+        baseband_set_thread_impl(impl);
+        memcpy(buf, cf32, sizeof(cf32));
+        baseband_convert_cf32_cs16(buf, (int16_t *)buf, 2 * CHECK_LEN);
+        if (memcmp(buf, ref16, sizeof(ref16))) {
+            fprintf(stderr, "CF32 converter of %s differs\n", baseband_impl_name(impl));
+            failed++;
+        }
+        memcpy(buf, cs8, sizeof(cs8));
+        baseband_convert_cs8_cu8((uint8_t *)buf, 2 * CHECK_LEN);
+        if (memcmp(buf, ref8, sizeof(ref8))) {
+            fprintf(stderr, "CS8 converter of %s differs\n", baseband_impl_name(impl));
+            failed++;
+        }
+    }
+    baseband_set_thread_impl(BASEBAND_IMPL_AUTO);
+    printf("Input converters checked\n");
+
+    return failed;
+}
+
+static int check_find_above(void)
+{
+    static int16_t buf[CHECK_LEN];
+    int failed = 0;
+
+    for (int i = 0; i < CHECK_LEN; ++i) {
+        buf[i] = (int16_t)(rand() % 2000 - 100);
+    }
+
+    for (int impl = BASEBAND_IMPL_SCALAR; impl < BASEBAND_IMPL_END; ++impl) {
+        if (!baseband_impl_available(impl)) {
+            continue;
+        }
+        baseband_set_thread_impl(impl);
+        // every level and start offset, the first sample above is at varying vector positions
+        for (int level = -200; level < 2000; level += 7) {
+            for (uint32_t start = 0; start < 40; ++start) {
+                uint32_t len = CHECK_LEN - start;
+                uint32_t ref = 0;
+                while (ref < len && buf[start + ref] <= level) {
+                    ref++;
+                }
+                if (baseband_find_above(&buf[start], len, (int16_t)level) != ref) {
+                    fprintf(stderr, "Threshold search of %s differs at level %d\n", baseband_impl_name(impl), level);
+                    failed++;
+                    break;
+                }
+            }
+        }
+        if (baseband_find_above(buf, 0, 0) != 0 || baseband_find_above(buf, CHECK_LEN, INT16_MAX) != CHECK_LEN) {
+            fprintf(stderr, "Threshold search of %s fails on empty results\n", baseband_impl_name(impl));
+            failed++;
+        }
+    }
+    baseband_set_thread_impl(BASEBAND_IMPL_AUTO);
+    printf("Threshold search checked\n");
+
+    return failed;
+}
+
+/// Per-sample reference of the CU8 FM discriminator (dspguru atan2 and one-pole low pass).
+static void ref_demod_FM(demodfm_state_t *state, uint8_t const *x_buf, int16_t *y_buf, unsigned long num_samples)
+{
+    int32_t const a1 = state->alp_16[1];
+    int32_t const b0 = state->blp_16[0];
+    int16_t x0r = state->xr, x0i = state->xi, x0f = state->xf, y0f = state->yf;
+    for (unsigned long n = 0; n < num_samples; n++) {
+        int16_t x1r = x0r, x1i = x0i, x1f = x0f;
+        x0r = *x_buf++ - 128;
+        x0i = *x_buf++ - 128;
+        int32_t pr = x0r * x1r + x0i * x1i;
+        int32_t pi = x0i * x1r - x0r * x1i;
+        int32_t abs_y = abs(pi), angle, denom;
+        if (!pr && !pi) {
+            angle = 0;
+        }
+        else if (pr >= 0) {
+            denom = abs_y + pr ? abs_y + pr : 1;
+            angle = INT16_MAX / 4 - INT16_MAX / 4 * (pr - abs_y) / denom;
+        }
+        else {
+            denom = abs_y - pr ? abs_y - pr : 1;
+            angle = 3 * INT16_MAX / 4 - INT16_MAX / 4 * (pr + abs_y) / denom;
+        }
+        x0f = pi < 0 ? -angle : angle;
+        y0f = (a1 * y0f + b0 * (x0f + x1f)) >> 14;
+        *y_buf++ = y0f;
+    }
+    state->xr = x0r, state->xi = x0i, state->xf = x0f, state->yf = y0f;
+}
+
+/// Check the block FM discriminator against the per-sample reference, across block boundaries.
+static int check_fm(void)
+{
+    uint8_t cu8[2 * CHECK_LEN];
+    int16_t ref[CHECK_LEN];
+    int16_t out[CHECK_LEN];
+    int16_t fast_ref[CHECK_LEN];
+    int failed = 0;
+
+    for (int i = 0; i < 2 * CHECK_LEN; ++i) {
+        cu8[i] = rand() & 0xff;
+    }
+    cu8[0] = cu8[1] = cu8[2] = cu8[3] = 0; // -128 overflow edge
+
+    for (int impl = BASEBAND_IMPL_SCALAR; impl < BASEBAND_IMPL_END; ++impl) {
+        if (!baseband_impl_available(impl)) {
+            continue;
+        }
+        baseband_set_thread_impl(impl);
+        for (int fast_atan = 0; fast_atan <= 1; ++fast_atan) {
+            demodfm_state_t ref_state = {0};
+            demodfm_state_t state     = {0};
+            state.fast_atan           = fast_atan;
+            for (unsigned long pos = 0, len = 1; pos < CHECK_LEN; pos += len, len = len * 3 + 1) {
+                len = pos + len > CHECK_LEN ? CHECK_LEN - pos : len;
+                baseband_demod_FM(&state, &cu8[2 * pos], &out[pos], len, 250000, 0.1f);
+                ref_state.alp_16[1] = state.alp_16[1];
+                ref_state.blp_16[0] = state.blp_16[0];
+                ref_demod_FM(&ref_state, &cu8[2 * pos], &ref[pos], len);
+            }
+            if (!fast_atan && memcmp(ref, out, sizeof(ref))) {
+                fprintf(stderr, "FM demod of %s differs from reference\n", baseband_impl_name(impl));
+                failed++;
+            }
+            // the polynomial atan is not exact but must be identical across implementations
+            if (fast_atan && impl == BASEBAND_IMPL_SCALAR) {
+                memcpy(fast_ref, out, sizeof(fast_ref));
+            }
+            else if (fast_atan && memcmp(fast_ref, out, sizeof(fast_ref))) {
+                fprintf(stderr, "Fast FM demod of %s differs from scalar\n", baseband_impl_name(impl));
+                failed++;
+            }
+        }
+        printf("FM demod %s checked\n", baseband_impl_name(impl));
+    }
+    baseband_set_thread_impl(BASEBAND_IMPL_AUTO);
+
+    return failed;
+}
+
+/// Check the fused front end against the separate AM, low pass, and FM passes.
+static int check_fused(void)
+{
+    static uint8_t cu8[2 * 3 * CHECK_LEN];
+    static uint16_t env[3 * CHECK_LEN];
+    static int16_t am[2][3 * CHECK_LEN];
+    static int16_t fm[2][3 * CHECK_LEN];
+    int failed = 0;
+
+    for (int i = 0; i < 2 * 3 * CHECK_LEN; ++i) {
+        cu8[i] = rand() & 0xff;
+    }
+
+    for (int use_mag_est = 0; use_mag_est <= 1; ++use_mag_est) {
+        filter_state_t lp_state[2];
+        demodfm_state_t fm_state[2];
+        memset(lp_state, 0, sizeof(lp_state));
+        memset(fm_state, 0, sizeof(fm_state));
+        float lvl[2];
+        lvl[0] = use_mag_est ? magnitude_est_cu8(cu8, env, 3 * CHECK_LEN) : envelope_detect(cu8, env, 3 * CHECK_LEN);
+        baseband_low_pass_filter(&lp_state[0], env, am[0], 3 * CHECK_LEN);
+        baseband_demod_FM(&fm_state[0], cu8, fm[0], 3 * CHECK_LEN, 250000, 0.1f);
+        lvl[1] = baseband_demod_AM_FM(&lp_state[1], &fm_state[1], use_mag_est, cu8, am[1], fm[1], 3 * CHECK_LEN, 250000, 0.1f);
+        if (lvl[0] != lvl[1] || memcmp(am[0], am[1], sizeof(am[0])) || memcmp(fm[0], fm[1], sizeof(fm[0]))) {
+            fprintf(stderr, "Fused front end differs from separate passes\n");
+            failed++;
+        }
+    }
+    printf("Fused front end checked\n");
+
+    return failed;
+}
+
+static int check_probe(void)
+{
+    static uint8_t cu8[2 * 3 * CHECK_LEN];
+    static int16_t cs16[2 * 3 * CHECK_LEN];
+    static uint16_t env[3 * CHECK_LEN];
+    int failed = 0;
+    float tail_db;
+
+    for (int i = 0; i < 2 * 3 * CHECK_LEN; ++i) {
+        cu8[i]  = 128 + (rand() % 33) - 16;
+        cs16[i] = (cu8[i] - 128) * 256;
+    }
+
+    // a stride of 1 gives the exact estimator level
+    if (baseband_probe_level(cu8, 2, 0, 3 * CHECK_LEN, 1, &tail_db) != envelope_detect(cu8, env, 3 * CHECK_LEN)
+            || baseband_probe_level(cu8, 2, 1, 3 * CHECK_LEN, 1, &tail_db) != magnitude_est_cu8(cu8, env, 3 * CHECK_LEN)
+            || baseband_probe_level(cs16, 4, 1, 3 * CHECK_LEN, 1, &tail_db) != magnitude_est_cs16(cs16, env, 3 * CHECK_LEN)) {
+        fprintf(stderr, "Level probe differs from the estimators\n");
+        failed++;
+    }
+
+    // subsampled noise stays close, a burst at the frame end shows in the tail
+    float full_db  = envelope_detect(cu8, env, 3 * CHECK_LEN);
+    float probe_db = baseband_probe_level(cu8, 2, 0, 3 * CHECK_LEN, 8, &tail_db);
+    if (fabsf(probe_db - full_db) > 0.5f || fabsf(tail_db - full_db) > 1.5f) { // the tail has only a few samples here
+        fprintf(stderr, "Subsampled level probe off: %.2f dB, tail %.2f dB, full %.2f dB\n", probe_db, tail_db, full_db);
+        failed++;
+    }
+    memset(&cu8[2 * (3 * CHECK_LEN - 100)], 255, 2 * 100);
+    baseband_probe_level(cu8, 2, 0, 3 * CHECK_LEN, 8, &tail_db);
+    if (tail_db < full_db + 10.0f) {
+        fprintf(stderr, "Level probe misses a burst at the frame end: tail %.2f dB\n", tail_db);
+        failed++;
+    }
+    printf("Level probe checked\n");
+
+    return failed;
+}
+
+/// The kernels are fixed by baseband_init(), only the calling thread can switch.
+static int check_selection(void)
+{
+    int failed = 0;
+    baseband_impl_t selected = baseband_get_impl();
+
+    if (baseband_set_impl(BASEBAND_IMPL_SCALAR) != selected || baseband_get_impl() != selected) {
+        printf("Kernel selection changed after baseband_init()\n");
+        failed++;
+    }
+    if (baseband_set_kernel_impl(BASEBAND_KERNEL_ENVELOPE, BASEBAND_IMPL_SCALAR) != selected) {
+        printf("Envelope kernel changed after baseband_init()\n");
+        failed++;
+    }
+    baseband_set_thread_impl(BASEBAND_IMPL_SCALAR);
+    if (baseband_get_kernel_impl(BASEBAND_KERNEL_FM_CU8) != BASEBAND_IMPL_SCALAR) {
+        printf("Thread kernels not in use\n");
+        failed++;
+    }
+    baseband_set_thread_impl(BASEBAND_IMPL_AUTO);
+    if (baseband_get_impl() != selected) {
+        printf("Thread kernels not reset\n");
+        failed++;
+    }
+    printf("Kernel selection checked\n");
+
+    return failed;
+}
+
 int main(int argc, char *argv[])
 {
     baseband_init();
+    printf("Using %s kernels\n", baseband_impl_name(baseband_get_impl()));
 
     uint8_t *cu8_buf;
     uint16_t *y16_buf;
@@ -86,11 +409,11 @@ int main(int argc, char *argv[])
     long n_read;
     unsigned long n_samples;
     int max_block_size = 4096000;
-    filter_state_t state;
-    demodfm_state_t fm_state;
+    filter_state_t state = {0};
+    demodfm_state_t fm_state = {0};
 
     if (argc <= 1) {
-        return 1;
+        return check_selection() + check_impls() + check_fm() + check_fused() + check_probe() + check_convert() + check_find_above();
     }
     filename = argv[1];
 
@@ -163,6 +486,25 @@ int main(int argc, char *argv[])
         baseband_demod_FM(&fm_state, cu8_buf, s16_buf, n_samples, 250000, 0.1f);
     );
     write_buf("bb.fm.s16", s16_buf, sizeof(int16_t) * n_samples);
+    fm_state.fast_atan = 1;
+    MEASURE("baseband_demod_FM fast_atan",
+        baseband_demod_FM(&fm_state, cu8_buf, s16_buf, n_samples, 250000, 0.1f);
+    );
+    fm_state.fast_atan = 0;
+
+    // Estimated bytes per sample through full size buffers, not measured:
+    // separate passes: envelope (r2 w2), low pass (r2 w2), FM phase (r2 w2), FM low pass (r2 w2)
+    // fused: IQ read once (r2), AM and FM written once (w4), the envelope stays in a small chunk buffer
+    MEASURE("separate AM, low pass, FM",
+        envelope_detect(cu8_buf, y16_buf, n_samples);
+        baseband_low_pass_filter(&state, y16_buf, (int16_t *)u16_buf, n_samples);
+        baseband_demod_FM(&fm_state, cu8_buf, s16_buf, n_samples, 250000, 0.1f);
+    );
+    MEASURE("baseband_demod_AM_FM",
+        baseband_demod_AM_FM(&state, &fm_state, 0, cu8_buf, (int16_t *)u16_buf, s16_buf, n_samples, 250000, 0.1f);
+    );
+    printf("Estimated buffer traffic for %lu samples (not measured): separate %lu bytes, fused %lu bytes\n",
+            n_samples, 16 * n_samples, 6 * n_samples);
 
     write_buf("bb.cs16", cs16_buf, sizeof(int16_t) * 2 * n_samples);
     //envelope_detect_cs16(cs16_buf, y32_buf, n_samples);
@@ -0,0 +1,194 @@
+/** @file
+    Test of the DSP pipeline event rings with several inputs.
+
+    Each input has a DSP and a slicer thread and an event loop of its own,
+    the event rings are tiny so that pushing events waits for the event loop.
+    Every event must reach the event loop of its own input, a wait on the
+    wrong input hangs the test until the timeout.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dsp_thread.h"
+#include "iq_pool.h"
+#include "compat_pthread.h"
+
+#define N_INPUTS 3
+#define N_FRAMES 200
+#define EVENTS_PER_STAGE 16 ///< events per frame and per package, much more than the ring holds
+
+#ifdef THREADS
+
+typedef struct test_input {
+    dsp_thread_t *dsp;
+    pthread_t loop_thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int woken;
+    int stop;
+    unsigned popped;       ///< events of this input, written by the event loop
+    unsigned wrong;        ///< events of other inputs, written by the event loop
+    char tag;              ///< the address is the event of this input
+} test_input_t;
+
+static test_input_t inputs[N_INPUTS];
+
+static void test_frame(void *ctx, iq_frame_t *iq, uint32_t len, uint32_t sample_rate, uint32_t center_frequency)
+{
+    test_input_t *input = ctx;
+    (void)iq;
+    (void)len;
+    (void)sample_rate;
+    (void)center_frequency;
+
+    for (int i = 0; i < EVENTS_PER_STAGE; ++i) {
+        dsp_thread_push_event(&input->tag);
+    }
+    void *package = dsp_thread_get_package(input->dsp);
+    if (package) {
+        dsp_thread_push_package(input->dsp, package);
+    }
+}
+
+static void test_package(void *ctx, void *package)
+{
+    test_input_t *input = ctx;
+    (void)package;
+
+    for (int i = 0; i < EVENTS_PER_STAGE; ++i) {
+        dsp_thread_push_event(&input->tag);
+    }
+}
+
+static void test_wake(void *ctx)
+{
+    test_input_t *input = ctx;
+    pthread_mutex_lock(&input->lock);
+    input->woken = 1;
+    pthread_cond_broadcast(&input->cond); // the main thread waits on it too
+    pthread_mutex_unlock(&input->lock);
+}
+
+static THREAD_RETURN THREAD_CALL test_event_loop(void *arg)
+{
+    test_input_t *input = arg;
+
+    pthread_mutex_lock(&input->lock);
+    while (!input->stop) {
+        while (!input->woken && !input->stop) {
+            pthread_cond_wait(&input->cond, &input->lock);
+        }
+        input->woken = 0;
+        pthread_mutex_unlock(&input->lock);
+
+        unsigned popped = 0;
+        unsigned wrong  = 0;
+        for (char *event; (event = dsp_thread_pop_event(input->dsp));) {
+            if (event == &input->tag) {
+                popped++;
+            }
+            else {
+                wrong++;
+            }
+        }
+
+        pthread_mutex_lock(&input->lock);
+        input->popped += popped;
+        input->wrong += wrong;
+        pthread_cond_broadcast(&input->cond); // the main thread waits for the count
+    }
+    pthread_mutex_unlock(&input->lock);
+
+    return (THREAD_RETURN)0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    fprintf(stderr, "dsp_thread::dsp_thread_push_event(): full event rings on %d inputs\n", N_INPUTS);
+    iq_pool_t *pool = iq_pool_create(N_INPUTS * 8, 64);
+    if (!pool) {
+        fprintf(stderr, "FAIL: alloc\n");
+        return 1;
+    }
+
+    for (int k = 0; k < N_INPUTS; ++k) {
+        test_input_t *input = &inputs[k];
+        pthread_mutex_init(&input->lock, NULL);
+        pthread_cond_init(&input->cond, NULL);
+        input->dsp = dsp_thread_start(4, test_frame, 2, 16, test_package, 2, test_wake, input);
+        if (!input->dsp || pthread_create(&input->loop_thread, NULL, test_event_loop, input)) {
+            fprintf(stderr, "FAIL: start\n");
+            return 1;
+        }
+    }
+
+    // feed the inputs in turn, frames are dropped while all frames of an input are queued
+    unsigned accepted[N_INPUTS] = {0};
+    for (int f = 0; f < N_FRAMES; ++f) {
+        for (int k = 0; k < N_INPUTS; ++k) {
+            iq_frame_t *iq = iq_pool_lease(pool);
+            if (!iq) {
+                continue;
+            }
+            if (!dsp_thread_push_frame(inputs[k].dsp, iq, 64, 250000, 433920000)) {
+                accepted[k]++;
+            }
+            iq_frame_release(iq);
+        }
+    }
+
+    for (int k = 0; k < N_INPUTS; ++k) {
+        test_input_t *input = &inputs[k];
+        unsigned expected   = accepted[k] * EVENTS_PER_STAGE * 2;
+        pthread_mutex_lock(&input->lock);
+        while (input->popped + input->wrong < expected) {
+            pthread_cond_wait(&input->cond, &input->lock);
+        }
+        input->stop = 1;
+        pthread_cond_broadcast(&input->cond);
+        pthread_mutex_unlock(&input->lock);
+        pthread_join(input->loop_thread, NULL);
+
+        dsp_stats_t stats;
+        dsp_thread_stop(input->dsp);
+        dsp_thread_stats(input->dsp, &stats);
+        for (void *event; (event = dsp_thread_pop_event(input->dsp));) {
+            input->wrong++; // nothing may be left over
+        }
+        dsp_thread_free(input->dsp);
+        pthread_mutex_destroy(&input->lock);
+        pthread_cond_destroy(&input->cond);
+
+        if (!accepted[k] || input->popped != expected || input->wrong || stats.events_dropped) {
+            fprintf(stderr, "FAIL: input %d got %u of %u events, %u wrong, %u dropped\n",
+                    k, input->popped, expected, input->wrong, stats.events_dropped);
+            failed++;
+        }
+        if (!stats.events_stalled) {
+            fprintf(stderr, "FAIL: input %d never waited for its event loop\n", k);
+            failed++;
+        }
+    }
+    iq_pool_free(pool);
+
+    fprintf(stderr, "dsp_thread:: test (%d failed)\n", failed);
+    return failed;
+}
+
+#else /* !THREADS */
+
+int main(void)
+{
+    fprintf(stderr, "dsp_thread:: test skipped, no threads\n");
+    return 0;
+}
+
+#endif /* THREADS */
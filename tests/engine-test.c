@@ -0,0 +1,248 @@
+/** @file
+    Test of the reentrant engine API, several engines decoding concurrently.
+
+    Each engine gets a synthetic OOK PWM signal of its own and two flex decoders,
+    one matching each signal, an engine must only report the codes it was fed.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "r_engine.h"
+#include "pulse_data.h"
+#include "data.h"
+#include "compat_pthread.h"
+
+#define SAMPLE_RATE 250000
+#define SHORT_US 500
+#define LONG_US 1000
+#define BLOCK_LEN 16384
+
+static char spec_a[] = "n=code_a,m=OOK_PWM,s=500,l=1000,r=4000,match={24}0xa5c3f0";
+static char spec_b[] = "n=code_b,m=OOK_PWM,s=500,l=1000,r=4000,match={24}0x5a3c0f";
+
+typedef struct test_input {
+    uint8_t code[3];
+    unsigned n_messages;
+    unsigned rounds;
+    unsigned char *iq_buf;
+    size_t iq_len;
+    unsigned count_a; ///< events of code_a
+    unsigned count_b; ///< events of code_b
+    unsigned count_other;
+} test_input_t;
+
+static void test_event(void *ctx, data_t *data)
+{
+    test_input_t *input = ctx;
+    for (; data; data = data->next) {
+        if (strcmp(data->key, "model") == 0 && data->type == DATA_STRING) {
+            if (strcmp(data->value.v_ptr, "code_a") == 0)
+                input->count_a++;
+            else if (strcmp(data->value.v_ptr, "code_b") == 0)
+                input->count_b++;
+            else
+                input->count_other++;
+            return;
+        }
+    }
+    input->count_other++;
+}
+
+/// Append @p n samples of carrier or silence, with a little deterministic noise.
+static size_t put_samples(unsigned char *buf, size_t pos, unsigned n, int on, unsigned *seed)
+{
+    for (unsigned i = 0; i < n; ++i) {
+        *seed = *seed * 1103515245 + 12345;
+        int noise = (int)((*seed >> 16) & 3) - 1;
+        // a carrier at fs/4 has the IQ pattern (1, 0), (0, 1), (-1, 0), (0, -1)
+        int amp = on ? 100 : 0;
+        int k   = (int)((pos / 2) & 3);
+        int re  = k == 0 ? amp : k == 2 ? -amp : 0;
+        int im  = k == 1 ? amp : k == 3 ? -amp : 0;
+        buf[pos++] = (unsigned char)(128 + re + noise);
+        buf[pos++] = (unsigned char)(128 + im + noise);
+    }
+    return pos;
+}
+
+/// Build a CU8 signal of PWM messages, a short pulse is a 1 bit, each message followed by silence.
+static void build_signal(test_input_t *input)
+{
+    unsigned const s_len     = SHORT_US * (SAMPLE_RATE / 1000) / 1000;
+    unsigned const l_len     = LONG_US * (SAMPLE_RATE / 1000) / 1000;
+    unsigned const silence   = SAMPLE_RATE / 20; // 50 ms
+    unsigned const n_samples = silence + input->n_messages * (24 * (s_len + l_len) + silence);
+
+    input->iq_len = (size_t)n_samples * 2;
+    input->iq_buf = malloc(input->iq_len);
+    if (!input->iq_buf) {
+        fprintf(stderr, "FAIL: malloc\n");
+        exit(1);
+    }
+
+    unsigned seed = 1;
+    size_t pos    = put_samples(input->iq_buf, 0, silence, 0, &seed);
+    for (unsigned m = 0; m < input->n_messages; ++m) {
+        for (int i = 0; i < 24; ++i) {
+            int bit = (input->code[i / 8] >> (7 - i % 8)) & 1;
+            pos     = put_samples(input->iq_buf, pos, bit ? s_len : l_len, 1, &seed);
+            pos     = put_samples(input->iq_buf, pos, bit ? l_len : s_len, 0, &seed);
+        }
+        pos = put_samples(input->iq_buf, pos, silence, 0, &seed);
+    }
+}
+
+static void run_engine(test_input_t *input)
+{
+    r_engine_t *engine = r_engine_create();
+    if (!engine) {
+        return;
+    }
+    r_engine_register_flex(engine, spec_a);
+    r_engine_register_flex(engine, spec_b);
+    r_engine_set_event_handler(engine, test_event, input);
+    r_engine_set_input(engine, SAMPLE_RATE, 433920000, 2);
+
+    for (unsigned r = 0; r < input->rounds; ++r) {
+        for (size_t pos = 0; pos < input->iq_len; pos += BLOCK_LEN) {
+            size_t len = input->iq_len - pos < BLOCK_LEN ? input->iq_len - pos : BLOCK_LEN;
+            r_engine_push_iq(engine, &input->iq_buf[pos], (uint32_t)len);
+        }
+    }
+    r_engine_flush(engine);
+
+    r_engine_free(engine);
+}
+
+#ifdef THREADS
+static THREAD_RETURN THREAD_CALL engine_thread(void *arg)
+{
+    run_engine(arg);
+    return (THREAD_RETURN)0;
+}
+#endif
+
+static int test_pulses(void)
+{
+    int failed           = 0;
+    test_input_t input   = {.code = {0xa5, 0xc3, 0xf0}};
+    pulse_data_t *pulses = calloc(1, sizeof(*pulses));
+    r_engine_t *engine   = r_engine_create();
+    if (!pulses || !engine || pulse_data_reserve(pulses, 24)) {
+        fprintf(stderr, "FAIL: alloc\n");
+        if (pulses)
+            pulse_data_free(pulses);
+        free(pulses);
+        r_engine_free(engine);
+        return 1;
+    }
+    r_engine_register_flex(engine, spec_a);
+    r_engine_set_event_handler(engine, test_event, &input);
+
+    unsigned const s_len = SHORT_US * (SAMPLE_RATE / 1000) / 1000;
+    unsigned const l_len = LONG_US * (SAMPLE_RATE / 1000) / 1000;
+    pulses->sample_rate  = SAMPLE_RATE;
+    for (int i = 0; i < 24; ++i) {
+        int bit = (input.code[i / 8] >> (7 - i % 8)) & 1;
+        pulses->pulse[pulses->num_pulses] = bit ? s_len : l_len;
+        pulses->gap[pulses->num_pulses]   = bit ? l_len : s_len;
+        pulses->num_pulses++;
+    }
+    pulses->gap[pulses->num_pulses - 1] = SAMPLE_RATE / 20;
+
+    int events = r_engine_push_pulses(engine, pulses);
+    if (events != 1 || input.count_a != 1 || input.count_b || input.count_other) {
+        fprintf(stderr, "FAIL: pulses gave %d events, %u a, %u b, %u other\n", events, input.count_a, input.count_b, input.count_other);
+        failed++;
+    }
+
+    r_engine_free(engine);
+    pulse_data_free(pulses);
+    free(pulses);
+    return failed;
+}
+
+static int test_bad_flex(void)
+{
+    int failed         = 0;
+    r_engine_t *engine = r_engine_create();
+    if (!engine) {
+        fprintf(stderr, "FAIL: alloc\n");
+        return 1;
+    }
+    char bad_key[]  = "n=bad,m=OOK_PWM,s=500,l=1000,r=4000,nokey=1";
+    char bad_mod[]  = "n=bad,m=OOK_XYZ,s=500,l=1000,r=4000";
+    char no_reset[] = "n=bad,m=OOK_PWM,s=500,l=1000";
+    char help[]     = "help";
+    char *specs[]   = {bad_key, bad_mod, no_reset, help};
+    for (unsigned i = 0; i < sizeof(specs) / sizeof(*specs); ++i) {
+        if (r_engine_register_flex(engine, specs[i]) != -1) {
+            fprintf(stderr, "FAIL: bad flex spec \"%s\" accepted\n", specs[i]);
+            failed++;
+        }
+    }
+    if (r_engine_register_flex(engine, spec_a) != 0) {
+        fprintf(stderr, "FAIL: flex spec rejected\n");
+        failed++;
+    }
+
+    r_engine_free(engine);
+    return failed;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    fprintf(stderr, "engine::r_engine_register_flex(): reject bad specs\n");
+    failed += test_bad_flex();
+
+    fprintf(stderr, "engine::r_engine_push_pulses(): decode pulse data\n");
+    failed += test_pulses();
+
+    fprintf(stderr, "engine::r_engine_push_iq(): engines on concurrent threads\n");
+    test_input_t inputs[2] = {
+            {.code = {0xa5, 0xc3, 0xf0}, .n_messages = 5, .rounds = 10},
+            {.code = {0x5a, 0x3c, 0x0f}, .n_messages = 3, .rounds = 10},
+    };
+    build_signal(&inputs[0]);
+    build_signal(&inputs[1]);
+
+#ifdef THREADS
+    pthread_t threads[2];
+    for (int i = 0; i < 2; ++i) {
+        if (pthread_create(&threads[i], NULL, engine_thread, &inputs[i])) {
+            fprintf(stderr, "FAIL: pthread_create\n");
+            return 1;
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+#else
+    run_engine(&inputs[0]);
+    run_engine(&inputs[1]);
+#endif
+
+    if (inputs[0].count_a != 50 || inputs[0].count_b || inputs[0].count_other) {
+        fprintf(stderr, "FAIL: engine 0 got %u a, %u b, %u other\n", inputs[0].count_a, inputs[0].count_b, inputs[0].count_other);
+        failed++;
+    }
+    if (inputs[1].count_b != 30 || inputs[1].count_a || inputs[1].count_other) {
+        fprintf(stderr, "FAIL: engine 1 got %u a, %u b, %u other\n", inputs[1].count_a, inputs[1].count_b, inputs[1].count_other);
+        failed++;
+    }
+
+    free(inputs[0].iq_buf);
+    free(inputs[1].iq_buf);
+
+    fprintf(stderr, "engine:: test (%d failed)\n", failed);
+    return failed;
+}
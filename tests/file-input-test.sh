@@ -0,0 +1,85 @@
+#!/bin/sh
+#
+# Decode the same signal through the mapped and the read file input paths.
+#
+# CU8 and CS16 files are memory-mapped, CS8 files and stdin are read and
+# converted into a buffer. A CS8 file must give byte-for-byte the same output
+# as the mapped CU8 file, stdin the same as the mapped file of its format,
+# also with block sizes (-b) that are not whole samples and are rounded down.
+# The files are written by tests/synth_ook_file.py.
+#
+# Usage: file-input-test.sh [path-to-rtl_433-binary]
+
+set -u
+
+SCRIPT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")" && pwd)
+RTL_433=${1:-"$SCRIPT_DIR/../src/rtl_433"}
+PYTHON3=${PYTHON3:-python3}
+
+if [ ! -x "$RTL_433" ]; then
+    echo "ERROR: rtl_433 binary not found or not executable: $RTL_433" >&2
+    exit 99
+fi
+
+WORK_DIR=$(mktemp -d 2>/dev/null || echo /tmp/rtl_433_input_test.$$)
+mkdir -p "$WORK_DIR"
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+FLEX="n=synth,m=OOK_PWM,s=500,l=1000,r=4000,bits>=16"
+FAILED=0
+
+# Decode with the given options, print the events.
+decode() {
+    "$RTL_433" -R 0 -X "$FLEX" -F json "$@" 2>/dev/null
+}
+
+# Decode a mapped file as the reference of a format, it must not be empty.
+reference() {
+    fmt=$1
+    decode -r "$WORK_DIR/sig_433.92M_250k.$fmt" >"$WORK_DIR/ref_$fmt.json"
+    events=$(wc -l <"$WORK_DIR/ref_$fmt.json")
+    if [ "$events" -lt 10 ]; then
+        echo "FAIL: only $events events from the mapped $fmt file"
+        exit 1
+    fi
+    echo "Reference: $events events from the mapped $fmt file"
+}
+
+# Compare a decode with the reference output of a format.
+check() {
+    name=$1
+    fmt=$2
+    shift 2
+    decode "$@" >"$WORK_DIR/out.json"
+    if ! cmp -s "$WORK_DIR/ref_$fmt.json" "$WORK_DIR/out.json"; then
+        echo "FAIL: $name: output differs from the mapped $fmt file"
+        diff "$WORK_DIR/ref_$fmt.json" "$WORK_DIR/out.json" | cut -c1-100 | head -10
+        FAILED=$((FAILED + 1))
+    else
+        echo "PASS: $name"
+    fi
+}
+
+for fmt in cu8 cs8 cs16; do
+    "$PYTHON3" "$SCRIPT_DIR/synth_ook_file.py" "$WORK_DIR/sig_433.92M_250k.$fmt" --seconds 6 --long-bits 1000 || exit 98
+done
+CU8="$WORK_DIR/sig_433.92M_250k.cu8"
+CS8="$WORK_DIR/sig_433.92M_250k.cs8"
+CS16="$WORK_DIR/sig_433.92M_250k.cs16"
+
+reference cu8
+reference cs16
+
+check "CU8 from stdin" cu8 -s 250k -r cu8:- <"$CU8"
+check "CS8 file, read and converted" cu8 -r "$CS8"
+check "CS16 from stdin" cs16 -s 250k -r cs16:- <"$CS16"
+
+# block sizes that split samples are rounded down to whole samples
+for size in 1001 100003 262147 4000000; do
+    check "CU8 file, mapped, -b $size" cu8 -b $size -r "$CU8"
+    check "CS8 file, read, -b $size" cu8 -b $size -r "$CS8"
+    check "CS16 file, mapped, -b $size" cs16 -b $size -r "$CS16"
+done
+check "CU8 file, mapped, split, -b 100003" cu8 -b 100003 -j 2:split -r "$CU8"
+
+exit $FAILED
@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+# Decode input files with jobs (-j) and compare with reading them in turn.
+#
+# A set of files decoded by several jobs and a large file split into chunks
+# (-j n:split) must give byte-for-byte the same output as a single job. The
+# split file has long messages that cross the chunk boundaries. The files are
+# written by tests/synth_ook_file.py.
+#
+# Usage: file-jobs-test.sh [path-to-rtl_433-binary]
+
+set -u
+
+SCRIPT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")" && pwd)
+RTL_433=${1:-"$SCRIPT_DIR/../src/rtl_433"}
+PYTHON3=${PYTHON3:-python3}
+
+if [ ! -x "$RTL_433" ]; then
+    echo "ERROR: rtl_433 binary not found or not executable: $RTL_433" >&2
+    exit 99
+fi
+
+WORK_DIR=$(mktemp -d 2>/dev/null || echo /tmp/rtl_433_jobs_test.$$)
+mkdir -p "$WORK_DIR"
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+FLEX="n=synth,m=OOK_PWM,s=500,l=1000,r=4000,bits>=16"
+FAILED=0
+
+# Decode the files with the given jobs option, print the events.
+decode() {
+    jobs_opt=$1
+    shift
+    "$RTL_433" $jobs_opt -R 0 -X "$FLEX" -F json "$@" 2>/dev/null
+}
+
+# Compare a jobs run with a single job run, the single job run must not be empty.
+compare() {
+    name=$1
+    jobs=$2
+    shift 2
+    decode "" "$@" >"$WORK_DIR/serial.json"
+    decode "$jobs" "$@" >"$WORK_DIR/jobs.json"
+    events=$(wc -l <"$WORK_DIR/serial.json")
+    if [ "$events" -lt 10 ]; then
+        echo "FAIL: $name: only $events events with a single job"
+        FAILED=$((FAILED + 1))
+    elif ! cmp -s "$WORK_DIR/serial.json" "$WORK_DIR/jobs.json"; then
+        echo "FAIL: $name: $jobs output differs from a single job"
+        diff "$WORK_DIR/serial.json" "$WORK_DIR/jobs.json" | head -10
+        FAILED=$((FAILED + 1))
+    else
+        echo "PASS: $name: $jobs gives the same $events events"
+    fi
+}
+
+gen() {
+    "$PYTHON3" "$SCRIPT_DIR/synth_ook_file.py" "$@" || exit 98
+}
+
+# a set of files, in several formats, each numbering its messages on
+gen "$WORK_DIR/set1_433.92M_250k.cu8" --seconds 3 --first 0
+gen "$WORK_DIR/set2_433.92M_250k.cs8" --seconds 2 --first 1000
+gen "$WORK_DIR/set3_433.92M_250k.cs16" --seconds 3 --first 2000
+gen "$WORK_DIR/set4_433.92M_250k.cu8" --seconds 1 --first 3000
+gen "$WORK_DIR/set5_433.92M_250k.cu8" --seconds 2 --first 4000
+set -- "$WORK_DIR"/set*
+compare "file set" "-j 3" "$@"
+
+# a file long enough to be split into several chunks per job
+gen "$WORK_DIR/long_433.92M_250k.cu8" --seconds 40 --long-every 3 --long-bits 1000
+compare "split file" "-j 4:split" "$WORK_DIR/long_433.92M_250k.cu8"
+compare "split file and set" "-j 2:split" "$WORK_DIR/set1_433.92M_250k.cu8" "$WORK_DIR/long_433.92M_250k.cu8" "$WORK_DIR/set2_433.92M_250k.cs8"
+
+exit $FAILED
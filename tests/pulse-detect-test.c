@@ -0,0 +1,191 @@
+/** @file
+    Test of the pulse detector fast paths against the exact per-sample path.
+
+    Below LOG_NOTICE the OOK states idle, gap and pulse skip ahead in bulk,
+    at LOG_NOTICE every sample goes through the state machine for the level histogram.
+    Both detectors get the same synthetic signal in the same blocks and must
+    return identical packages.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pulse_detect.h"
+#include "pulse_data.h"
+#include "baseband.h"
+#include "logger.h"
+
+#define SAMPLE_RATE 1000000
+#define SIGNAL_LEN 1500000
+#define N_SCENES 6
+
+static unsigned seed;
+
+static int rnd(int n)
+{
+    seed = seed * 1103515245 + 12345;
+    return (int)((seed >> 8) % (unsigned)n);
+}
+
+/** Fill a signal of OOK packages with noise, spikes in the gaps and long idle stretches.
+    Scene 0 has long idle stretches, 1 long pulses, 2 long gaps, 3 many spikes, 4 and 5 have FSK packages.
+*/
+static void build_signal(int scene, int16_t *am, int16_t *fm, int n)
+{
+    seed      = (unsigned)scene + 1;
+    int noise = 50 + rnd(400);
+    int pos   = 0;
+    while (pos < n) {
+        int idle = scene == 0 ? rnd(300000) : rnd(30000);
+        int lvl  = 500 + rnd(15000);
+        for (int i = 0; i < idle && pos < n; ++i, ++pos) {
+            am[pos] = (int16_t)rnd(noise);
+            fm[pos] = (int16_t)(rnd(2000) - 1000);
+        }
+        if (scene >= 4) {
+            // one long OOK pulse with FSK chips
+            int len = 20000 + rnd(200000);
+            for (int i = 0; i < len && pos < n;) {
+                int chip = 10 + rnd(scene == 5 ? 3000 : 200);
+                int freq = rnd(2) ? 8000 : -8000;
+                for (int k = 0; k < chip && i < len && pos < n; ++k, ++i, ++pos) {
+                    am[pos] = (int16_t)(lvl - rnd(lvl / 3) + rnd(noise));
+                    fm[pos] = (int16_t)(freq + rnd(1500));
+                }
+            }
+            continue;
+        }
+        int spikes   = scene == 3 ? 20 : 1000;
+        int n_pulses = rnd(200);
+        for (int k = 0; k < n_pulses && pos < n; ++k) {
+            int pulse = 1 + rnd(scene == 1 ? 3000 : 600);
+            int gap   = 1 + rnd(scene == 2 ? 20000 : 1500);
+            int freq  = rnd(2) ? 8000 : -8000;
+            for (int i = 0; i < pulse && pos < n; ++i, ++pos) {
+                am[pos] = (int16_t)(lvl - rnd(lvl / 3) + rnd(noise));
+                fm[pos] = (int16_t)(freq + rnd(500));
+            }
+            for (int i = 0; i < gap && pos < n; ++i, ++pos) {
+                am[pos] = (int16_t)(rnd(noise) + (rnd(spikes) == 0 ? lvl : 0));
+                fm[pos] = (int16_t)(rnd(2000) - 1000);
+            }
+        }
+    }
+}
+
+static int compare_pulses(pulse_data_t const *a, pulse_data_t const *b)
+{
+    if (a->num_pulses != b->num_pulses
+            || a->offset != b->offset
+            || a->start_ago != b->start_ago
+            || a->end_ago != b->end_ago
+            || a->ook_low_estimate != b->ook_low_estimate
+            || a->ook_high_estimate != b->ook_high_estimate
+            || a->fsk_f1_est != b->fsk_f1_est
+            || a->fsk_f2_est != b->fsk_f2_est) {
+        return 1;
+    }
+    for (unsigned i = 0; i < a->num_pulses; ++i) {
+        if (a->pulse[i] != b->pulse[i] || a->gap[i] != b->gap[i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/// Feed both detectors in lockstep, returns the number of mismatches.
+static int check_signal(int16_t const *am, int16_t const *fm, int n, int block_len, float fixed_level, unsigned fpdm, unsigned *packages)
+{
+    int failed = 0;
+    pulse_detect_t *fast  = pulse_detect_create();
+    pulse_detect_t *exact = pulse_detect_create();
+    if (!fast || !exact) {
+        fprintf(stderr, "FAIL: alloc\n");
+        exit(1);
+    }
+    pulse_detect_set_levels(fast, 1, fixed_level, -12.1442f, 9.0f, LOG_WARNING);
+    pulse_detect_set_levels(exact, 1, fixed_level, -12.1442f, 9.0f, LOG_NOTICE);
+
+    pulse_data_t pulses[2]     = {{0}};
+    pulse_data_t fsk_pulses[2] = {{0}};
+    for (int pos = 0; pos < n; pos += block_len) {
+        int len = n - pos < block_len ? n - pos : block_len;
+        int ret[2];
+        do {
+            ret[0] = pulse_detect_package(fast, &am[pos], &fm[pos], len, SAMPLE_RATE, pos, &pulses[0], &fsk_pulses[0], fpdm);
+            ret[1] = pulse_detect_package(exact, &am[pos], &fm[pos], len, SAMPLE_RATE, pos, &pulses[1], &fsk_pulses[1], fpdm);
+            if (ret[0] != ret[1]) {
+                fprintf(stderr, "FAIL: block at %d: package type %d <> %d\n", pos, ret[0], ret[1]);
+                failed++;
+                break;
+            }
+            if (ret[0] == PULSE_DATA_OOK && compare_pulses(&pulses[0], &pulses[1])) {
+                fprintf(stderr, "FAIL: block at %d: OOK package differs\n", pos);
+                failed++;
+            }
+            if (ret[0] == PULSE_DATA_FSK && compare_pulses(&fsk_pulses[0], &fsk_pulses[1])) {
+                fprintf(stderr, "FAIL: block at %d: FSK package differs\n", pos);
+                failed++;
+            }
+            *packages += ret[0] != 0;
+        } while (ret[0] && !failed);
+        if (failed) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        pulse_data_free(&pulses[i]);
+        pulse_data_free(&fsk_pulses[i]);
+    }
+    pulse_detect_free(exact);
+    pulse_detect_free(fast);
+    return failed;
+}
+
+int main(void)
+{
+    int failed         = 0;
+    int const blocks[] = {131072, 16384, 1000, 7};
+
+    int16_t *am = malloc(SIGNAL_LEN * sizeof(*am));
+    int16_t *fm = malloc(SIGNAL_LEN * sizeof(*fm));
+    if (!am || !fm) {
+        fprintf(stderr, "FAIL: alloc\n");
+        return 1;
+    }
+    baseband_init();
+
+    for (int scene = 0; scene < N_SCENES; ++scene) {
+        build_signal(scene, am, fm, SIGNAL_LEN);
+        unsigned packages = 0;
+        for (unsigned b = 0; b < sizeof(blocks) / sizeof(*blocks); ++b) {
+            for (unsigned fpdm = 0; fpdm < 2; ++fpdm) {
+                for (int fixed = 0; fixed < 2; ++fixed) {
+                    if (blocks[b] < 1000 && (fpdm || fixed)) {
+                        continue; // tiny blocks are slow, the defaults are enough
+                    }
+                    fprintf(stderr, "pulse_detect::pulse_detect_package(): scene %d, %d sample blocks, fpdm %u%s\n",
+                            scene, blocks[b], fpdm, fixed ? ", fixed level" : "");
+                    failed += check_signal(am, fm, SIGNAL_LEN, blocks[b], fixed ? -20.0f : 0.0f, fpdm, &packages);
+                }
+            }
+        }
+        if (!packages) {
+            fprintf(stderr, "FAIL: scene %d has no packages\n", scene);
+            failed++;
+        }
+    }
+
+    free(fm);
+    free(am);
+
+    fprintf(stderr, "pulse_detect:: test (%d failed)\n", failed);
+    return failed;
+}
@@ -11,7 +11,7 @@
     (at your option) any later version.
 */
 
-// gcc -Wall -I ../include -o pulse-eval ../src/baseband.c ../src/write_sigrok.c ../tests/pulse-eval.c && ./pulse-eval FILE
+// built as the pulse-eval target, run ./pulse-eval FILE
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -65,18 +65,6 @@ static int write_buf(char const *filename, void const *buf, size_t nbyte)
     return ret;
 }
 
-static int write_u16_to_f32(char const *filename, uint16_t const *u16, size_t len)
-{
-    float *f32 = malloc(sizeof(float) * len);
-    assert(f32);
-    for (size_t i = 0; i < len; ++i) {
-        f32[i] = u16[i] / 65536.0;
-    }
-    int ret = write_buf(filename, f32, sizeof(float) * len);
-    free(f32);
-    return ret;
-}
-
 static int write_s16_to_f32(char const *filename, uint16_t const *s16, size_t len)
 {
     float *f32 = malloc(sizeof(float) * len);
@@ -156,11 +144,6 @@ static void mavgdev_push(mavgdev_t *a, int val)
     a->idx = a->idx % MAVGDEV_WIDTH;
 }
 
-static int mavgdev_avg(mavgdev_t *a)
-{
-    return a->avg / MAVGDEV_WIDTH;
-}
-
 static int mavgdev_dev(mavgdev_t *a)
 {
     return a->dev / MAVGDEV_WIDTH;
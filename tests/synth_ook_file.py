@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""Write a synthetic OOK_PULSE_PWM signal file for the file input tests.
+
+The file is a train of numbered messages: the message number as 16 bits,
+then the fill bits, short pulse = 1, long pulse = 0, each message followed
+by silence. Every --long-every message carries --long-bits fill bits, long
+enough to cross the chunk boundaries of a split file.
+
+The carrier is at fs/4 with a little deterministic noise, so the samples are
+built from repeated byte patterns and even long files are written quickly.
+
+Pure standard library so it runs in CI without extra packages.
+
+Usage: synth_ook_file.py PATH [options]
+  PATH             output file, the format is taken from the extension (.cu8, .cs8, .cs16)
+  --rate HZ        sample rate (default 250000)
+  --seconds S      length of the signal (default 2)
+  --first N        number of the first message (default 0)
+  --fill-bits N    fill bits of a message (default 16)
+  --long-every N   every N-th message is long, 0 for none (default 7)
+  --long-bits N    fill bits of a long message (default 400)
+"""
+import argparse
+import struct
+import sys
+
+SHORT_US = 500
+LONG_US = 1000
+GAP_US = 500
+SILENCE_US = 20000
+
+
+def carrier(fmt, n):
+    """Return n samples of the fs/4 carrier, the IQ pattern is (1, 0), (0, 1), (-1, 0), (0, -1)."""
+    amp = 100
+    iq = [(amp, 0), (0, amp), (-amp, 0), (0, -amp)]
+    return pattern(fmt, iq, n)
+
+
+def silence(fmt, n):
+    """Return n samples of silence with a tiny deterministic noise."""
+    iq = [(1, 0), (0, -1), (-1, 1), (0, 0), (1, 1), (-1, 0), (0, 1)]
+    return pattern(fmt, iq, n)
+
+
+def pattern(fmt, iq, n):
+    if fmt == "cu8":
+        block = bytes(b for i, q in iq for b in (128 + i, 128 + q))
+    elif fmt == "cs8":
+        block = b"".join(struct.pack("bb", i, q) for i, q in iq)
+    else:  # cs16
+        block = b"".join(struct.pack("<hh", i * 64, q * 64) for i, q in iq)
+    reps = (n + len(iq) - 1) // len(iq)
+    return (block * reps)[: n * len(block) // len(iq)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("path")
+    parser.add_argument("--rate", type=int, default=250000)
+    parser.add_argument("--seconds", type=float, default=2.0)
+    parser.add_argument("--first", type=int, default=0)
+    parser.add_argument("--fill-bits", type=int, default=16)
+    parser.add_argument("--long-every", type=int, default=7)
+    parser.add_argument("--long-bits", type=int, default=400)
+    args = parser.parse_args()
+
+    fmt = args.path.rsplit(".", 1)[-1]
+    if fmt not in ("cu8", "cs8", "cs16"):
+        sys.exit("unknown format: " + fmt)
+
+    def samples(us):
+        return int(us * args.rate // 1000000)
+
+    total = int(args.seconds * args.rate)
+    pos = 0
+    number = args.first
+    with open(args.path, "wb") as out:
+        while pos < total:
+            long_msg = args.long_every and number % args.long_every == args.long_every - 1
+            fill = args.long_bits if long_msg else args.fill_bits
+            bits = format(number & 0xFFFF, "016b") + ("10" * fill)[:fill]
+            for b in bits:
+                out.write(carrier(fmt, samples(SHORT_US if b == "1" else LONG_US)))
+                out.write(silence(fmt, samples(GAP_US)))
+                pos += samples(SHORT_US if b == "1" else LONG_US) + samples(GAP_US)
+            out.write(silence(fmt, samples(SILENCE_US)))
+            pos += samples(SILENCE_US)
+            number += 1
+
+
+if __name__ == "__main__":
+    main()